@@ -0,0 +1,699 @@
+#include "MFRC522Sim.h"
+#include "HostGpio.h"
+#include "MFRC522_I2C.h"
+
+#define SIM_FC_HZ 13560000ULL
+#define SIM_CRC_BYTE_NS 100ULL
+
+// ComIrqReg / DivIrqReg bits
+#define SIM_TX_IRQ 0x40
+#define SIM_RX_IRQ 0x20
+#define SIM_IDLE_IRQ 0x10
+#define SIM_HI_ALERT_IRQ 0x08
+#define SIM_LO_ALERT_IRQ 0x04
+#define SIM_ERR_IRQ 0x02
+#define SIM_TIMER_IRQ 0x01
+#define SIM_CRC_IRQ 0x04
+
+// ErrorReg bits
+#define SIM_BUFFER_OVFL 0x10
+#define SIM_COLL_ERR 0x08
+#define SIM_CRC_ERR 0x04
+
+#define SIM_MF_CRYPTO1_ON 0x08
+
+// Reset values of the registers the driver uses (datasheet section 9.2). Others reset to 0x00.
+static const struct {
+    byte reg;
+    byte value;
+} resetValues[] = {
+    { MFRC522::CommandReg, 0x20 },
+    { MFRC522::ComIEnReg, 0x80 },
+    { MFRC522::ComIrqReg, 0x14 },
+    { MFRC522::Status1Reg, 0x21 },
+    { MFRC522::WaterLevelReg, 0x08 },
+    { MFRC522::ControlReg, 0x10 },
+    { MFRC522::CollReg, 0xA0 },
+    { MFRC522::ModeReg, 0x3F },
+    { MFRC522::TxControlReg, 0x80 },
+    { MFRC522::TxSelReg, 0x10 },
+    { MFRC522::RxSelReg, 0x84 },
+    { MFRC522::RxThresholdReg, 0x84 },
+    { MFRC522::DemodReg, 0x4D },
+    { MFRC522::MfTxReg, 0x62 },
+    { MFRC522::SerialSpeedReg, 0xEB },
+    { MFRC522::ModWidthReg, 0x26 },
+    { MFRC522::RFCfgReg, 0x48 },
+    { MFRC522::GsNReg, 0x88 },
+    { MFRC522::CWGsPReg, 0x20 },
+    { MFRC522::ModGsPReg, 0x20 },
+};
+
+MFRC522Sim::MFRC522Sim(byte version)
+    : _address(0), _irqPin(NO_PIN), _phase(PHASE_IDLE), _due(DUE_TRANSMITTED), _authOk(false), _crc(0xFFFF),
+      _collision(0), _piccCount(0), _fieldOn(false)
+{
+    reset();
+    _registers[MFRC522::VersionReg] = version;
+    memset(_buffer, 0, sizeof(_buffer));
+    resetStats();
+}
+
+/**
+ * Places a card in the field. It is powered as soon as (or as long as) the antenna is on.
+ */
+bool MFRC522Sim::addPicc(SimPicc * picc)
+{
+    if(_piccCount == MAX_PICCS) {
+        return false;
+    }
+    _piccs[_piccCount++] = picc;
+    if(_fieldOn) {
+        picc->powerOn();
+    }
+    return true;
+}
+
+void MFRC522Sim::removePicc(SimPicc * picc)
+{
+    for(uint8_t i = 0; i < _piccCount; i++) {
+        if(_piccs[i] == picc) {
+            picc->powerOff();
+            _piccs[i] = _piccs[--_piccCount];
+            return;
+        }
+    }
+}
+
+// The IRQ output is connected to pin.
+void MFRC522Sim::connectIrq(uint8_t pin)
+{
+    _irqPin = pin;
+    updateIrq();
+}
+
+void MFRC522Sim::resetStats()
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Host interfaces
+/////////////////////////////////////////////////////////////////////////////////////
+
+// The first byte of a write sets the register address; there is no auto increment.
+void MFRC522Sim::i2cWrite(const uint8_t * data, size_t length)
+{
+    if(length == 0) {
+        return;
+    }
+    _address = data[0] & 0x3F;
+    for(size_t i = 1; i < length; i++) {
+        write(_address, data[i]);
+    }
+}
+
+void MFRC522Sim::i2cRead(uint8_t * data, size_t length)
+{
+    for(size_t i = 0; i < length; i++) {
+        data[i] = read(_address);
+    }
+}
+
+void MFRC522Sim::writeRegister(byte reg, const byte * values, byte count)
+{
+    HostClock::advanceNs(count * DIRECT_BYTE_NS);
+    for(byte i = 0; i < count; i++) {
+        write(reg & 0x3F, values[i]);
+    }
+}
+
+void MFRC522Sim::readRegister(byte reg, byte * values, byte count)
+{
+    HostClock::advanceNs(count * DIRECT_BYTE_NS);
+    for(byte i = 0; i < count; i++) {
+        values[i] = read(reg & 0x3F);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Register file
+/////////////////////////////////////////////////////////////////////////////////////
+
+// Power on and SoftReset: everything but the version goes back to its reset value; the antenna is off.
+void MFRC522Sim::reset()
+{
+    HostClock::cancel(event, this);
+    byte version = _registers[MFRC522::VersionReg];
+    memset(_registers, 0, sizeof(_registers));
+    for(size_t i = 0; i < sizeof(resetValues) / sizeof(resetValues[0]); i++) {
+        _registers[resetValues[i].reg] = resetValues[i].value;
+    }
+    _registers[MFRC522::VersionReg] = version;
+    _fifoHead = _fifoLength = 0;
+    _phase = PHASE_IDLE;
+    _crc = 0xFFFF;
+    antenna();
+    updateIrq();
+}
+
+void MFRC522Sim::write(byte reg, byte value)
+{
+    switch(reg) {
+        case MFRC522::CommandReg:
+            _registers[reg] = (_registers[reg] & 0x0F) | (value & 0x30);
+            if((value & 0x0F) != MFRC522::PCD_NoCmdChange) {
+                command(value & 0x0F);
+            }
+            return;
+        case MFRC522::ComIEnReg:
+        case MFRC522::DivIEnReg:
+            _registers[reg] = value;
+            updateIrq();
+            return;
+        case MFRC522::ComIrqReg:
+        case MFRC522::DivIrqReg: {
+            // Set1/Set2 = 1: the marked bits are set, 0: they are cleared
+            byte mask = reg == MFRC522::ComIrqReg ? 0x7F : 0x14;
+            if(value & 0x80) {
+                _registers[reg] |= value & mask;
+            }
+            else {
+                _registers[reg] &= ~(value & mask);
+            }
+            updateIrq();
+            return;
+        }
+        case MFRC522::Status2Reg:
+            // MFCrypto1On can only be cleared by software
+            _registers[reg] = (value & 0xC0) | (_registers[reg] & value & SIM_MF_CRYPTO1_ON);
+            return;
+        case MFRC522::FIFODataReg:
+            fifoPush(value);
+            if((_registers[MFRC522::CommandReg] & 0x0F) == MFRC522::PCD_CalcCRC && _phase != PHASE_CRC) {
+                calculateCrc();
+            }
+            return;
+        case MFRC522::FIFOLevelReg:
+            if(value & 0x80) {
+                _fifoHead = _fifoLength = 0;
+                _registers[MFRC522::ErrorReg] &= ~SIM_BUFFER_OVFL;
+                irq(SIM_LO_ALERT_IRQ);
+            }
+            return;
+        case MFRC522::BitFramingReg:
+            _registers[reg] = value;
+            if((value & 0x80) && _phase == PHASE_WAIT_START) {
+                transmit();
+            }
+            return;
+        case MFRC522::ControlReg:
+            return;     // TStopNow/TStartNow are not modelled, RxLastBits is read-only
+        case MFRC522::CollReg:
+            _registers[reg] = (value & 0x80) | (_registers[reg] & 0x7F);
+            return;
+        case MFRC522::TxControlReg:
+            _registers[reg] = value;
+            antenna();
+            return;
+        case MFRC522::ErrorReg:
+        case MFRC522::Status1Reg:
+        case MFRC522::VersionReg:
+            return;
+        default:
+            _registers[reg] = value;
+            return;
+    }
+}
+
+byte MFRC522Sim::read(byte reg)
+{
+    switch(reg) {
+        case MFRC522::FIFODataReg:
+            return fifoPop();
+        case MFRC522::FIFOLevelReg:
+            return _fifoLength;
+        case MFRC522::Status1Reg: {
+            byte waterLevel = _registers[MFRC522::WaterLevelReg] & 0x3F;
+            byte status = 0;
+            status |= _fifoLength <= waterLevel ? 0x01 : 0;                         // LoAlert
+            status |= sizeof(_fifo) - _fifoLength <= waterLevel ? 0x02 : 0;         // HiAlert
+            status |= _phase == PHASE_RECEIVE_WAIT && _due == DUE_TIMEOUT ? 0x08 : 0;   // TRunning
+            status |= (_registers[MFRC522::ComIrqReg] & _registers[MFRC522::ComIEnReg] & 0x7F)
+                      || (_registers[MFRC522::DivIrqReg] & _registers[MFRC522::DivIEnReg] & 0x14) ? 0x10 : 0;
+            status |= _phase != PHASE_CRC ? 0x20 : 0;                               // CRCReady
+            status |= _crc == 0 ? 0x40 : 0;                                         // CRCOk
+            return status;
+        }
+        case MFRC522::Status2Reg: {
+            // ModemState: 000 idle, 001 wait for StartSend, 011 transmitting, 101 wait for data, 110 receiving
+            static const byte modemState[] = { 0, 1, 3, 5, 6, 0, 0 };
+            return (_registers[reg] & 0xF8) | modemState[_phase];
+        }
+        case MFRC522::CRCResultRegH:
+            return _crc >> 8;
+        case MFRC522::CRCResultRegL:
+            return _crc & 0xFF;
+        default:
+            return _registers[reg];
+    }
+}
+
+void MFRC522Sim::fifoPush(byte value)
+{
+    if(_fifoLength == sizeof(_fifo)) {
+        _registers[MFRC522::ErrorReg] |= SIM_BUFFER_OVFL;
+        return;
+    }
+    _fifo[(_fifoHead + _fifoLength++) % sizeof(_fifo)] = value;
+    if(sizeof(_fifo) - _fifoLength <= (_registers[MFRC522::WaterLevelReg] & 0x3F)) {
+        irq(SIM_HI_ALERT_IRQ);
+    }
+}
+
+byte MFRC522Sim::fifoPop()
+{
+    if(_fifoLength == 0) {
+        return 0;
+    }
+    byte value = _fifo[_fifoHead];
+    _fifoHead = (_fifoHead + 1) % sizeof(_fifo);
+    _fifoLength--;
+    if(_fifoLength <= (_registers[MFRC522::WaterLevelReg] & 0x3F)) {
+        irq(SIM_LO_ALERT_IRQ);
+    }
+    return value;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Commands
+/////////////////////////////////////////////////////////////////////////////////////
+
+// Writing a command stops the running one. Idle does not raise IdleIRq, commands that end by themselves do.
+void MFRC522Sim::command(byte command)
+{
+    HostClock::cancel(event, this);
+    _phase = PHASE_IDLE;
+    _registers[MFRC522::CommandReg] = (_registers[MFRC522::CommandReg] & 0xF0) | command;
+    switch(command) {
+        case MFRC522::PCD_Mem:
+            // With data in the FIFO: 25 bytes into the buffer, with an empty FIFO: the buffer into the FIFO
+            if(_fifoLength == 0) {
+                for(byte i = 0; i < sizeof(_buffer); i++) {
+                    fifoPush(_buffer[i]);
+                }
+            }
+            else {
+                for(byte i = 0; i < sizeof(_buffer); i++) {
+                    _buffer[i] = fifoPop();
+                }
+            }
+            finish(0);
+            return;
+        case MFRC522::PCD_GenerateRandomID:
+            for(byte i = 0; i < 10; i++) {
+                _buffer[i] = (byte)rand();
+            }
+            finish(0);
+            return;
+        case MFRC522::PCD_CalcCRC: {
+            static const uint16_t presets[] = { 0x0000, 0x6363, 0xA671, 0xFFFF };
+            _crc = presets[_registers[MFRC522::ModeReg] & 0x03];
+            if((_registers[MFRC522::AutoTestReg] & 0x0F) == 0x09) {
+                selfTest();
+                return;
+            }
+            calculateCrc();
+            return;
+        }
+        case MFRC522::PCD_Transmit:
+            transmit();
+            return;
+        case MFRC522::PCD_Receive:
+            _phase = PHASE_RECEIVE_WAIT;
+            return;
+        case MFRC522::PCD_Transceive:
+            _phase = PHASE_WAIT_START;
+            return;
+        case MFRC522::PCD_MFAuthent:
+            authenticate();
+            return;
+        case MFRC522::PCD_SoftReset:
+            reset();
+            return;
+        default:
+            return;
+    }
+}
+
+// The command terminated by itself.
+void MFRC522Sim::finish(byte comIrq)
+{
+    _phase = PHASE_IDLE;
+    _registers[MFRC522::CommandReg] &= 0xF0;
+    irq(comIrq | SIM_IDLE_IRQ);
+}
+
+// Sends the FIFO content. TxLastBits gives the valid bits of the last byte, TxCRCEn appends CRC_A.
+void MFRC522Sim::transmit()
+{
+    byte txLastBits = _registers[MFRC522::BitFramingReg] & 0x07;
+    _tx.bits = 0;
+    for(byte count = _fifoLength, i = 0; i < count; i++) {
+        byte value = fifoPop();
+        byte bits = i == count - 1 && txLastBits ? txLastBits : 8;
+        for(byte bit = 0; bit < bits; bit++) {
+            _tx.appendBit((value >> bit) & 1);
+        }
+    }
+    if((_registers[MFRC522::TxModeReg] & 0x80) && _tx.bits % 8 == 0) {
+        _tx.appendCrc();
+    }
+    _stats.framesSent++;
+    uint64_t ns = airNs(_tx.bits);
+    _stats.airNs += ns;
+    _phase = PHASE_TRANSMIT;
+    at(ns, DUE_TRANSMITTED);
+}
+
+// The frame is out: the cards in the field answer, or the timer (TAuto) runs out.
+void MFRC522Sim::transmitted()
+{
+    bool transmitOnly = (_registers[MFRC522::CommandReg] & 0x0F) == MFRC522::PCD_Transmit;
+    if(!transmitOnly) {
+        irq(SIM_TX_IRQ);
+    }
+
+    // Answers start at the same time; the PCD receives the superposition. Bits after the first collision
+    // are cleared (CollReg.ValuesAfterColl = 0) and CollPos is set.
+    bool crypto1 = _registers[MFRC522::Status2Reg] & SIM_MF_CRYPTO1_ON;
+    byte responders = 0;
+    uint32_t delayNs = 0;
+    _collision = 0;
+    _rx.bits = 0;
+    SimFrame answer;
+    for(uint8_t i = 0; _fieldOn && i < _piccCount; i++) {
+        uint32_t ns;
+        if(!_piccs[i]->receive(_tx, crypto1, answer, ns)) {
+            continue;
+        }
+        if(responders++ == 0) {
+            _rx = answer;
+            delayNs = ns;
+            continue;
+        }
+        // The first bit in which this answer differs from the first one, if it comes before those found so far
+        for(uint16_t bit = 0; bit < answer.bits && bit < _rx.bits && (!_collision || bit + 1 < _collision); bit++) {
+            if(answer.bit(bit) != _rx.bit(bit)) {
+                _collision = bit + 1;
+                break;
+            }
+        }
+        if(answer.bits > _rx.bits) {
+            memcpy(&_rx.data[_rx.bytes()], &answer.data[_rx.bytes()], answer.bytes() - _rx.bytes());
+            _rx.bits = answer.bits;
+        }
+        if(ns > delayNs) {
+            delayNs = ns;
+        }
+    }
+    // Transmit: the cards heard the frame, nobody listens to their answers
+    if(transmitOnly) {
+        finish(SIM_TX_IRQ);
+        return;
+    }
+    if(_collision) {
+        for(uint16_t bit = _collision - 1; bit < _rx.bits; bit++) {
+            _rx.data[bit / 8] &= ~(1 << (bit % 8));
+        }
+        _stats.collisions++;
+    }
+
+    _phase = PHASE_RECEIVE_WAIT;
+    uint64_t timer = timerNs();
+    bool timerOn = _registers[MFRC522::TModeReg] & 0x80;
+    if(responders && (!timerOn || delayNs < timer)) {
+        at(delayNs, DUE_ANSWER);
+    }
+    else if(timerOn) {
+        at(timer, DUE_TIMEOUT);
+    }
+}
+
+// The first bit of the answer stops the timer.
+void MFRC522Sim::answer()
+{
+    _phase = PHASE_RECEIVE;
+    uint64_t ns = airNs(_rx.bits);
+    _stats.airNs += ns;
+    at(ns, DUE_RECEIVED);
+}
+
+/**
+ * The answer is in: into the FIFO from bit RxAlign of the first byte on, RxLastBits valid bits in the last byte.
+ * With RxCRCEn the CRC_A is checked and not stored; frames that are not whole bytes with a valid CRC_A set CRCErr.
+ */
+void MFRC522Sim::received()
+{
+    _stats.framesReceived++;
+    byte errors = 0;
+    uint16_t bits = _rx.bits;
+    if(_registers[MFRC522::RxModeReg] & 0x80) {
+        if(_rx.hasValidCrc()) {
+            bits -= 16;
+        }
+        else {
+            errors |= SIM_CRC_ERR;
+        }
+    }
+
+    byte rxAlign = (_registers[MFRC522::BitFramingReg] >> 4) & 0x07;
+    uint16_t total = rxAlign + bits;
+    byte value = 0;
+    for(uint16_t i = 0; i < bits; i++) {
+        uint16_t position = rxAlign + i;
+        if(_rx.bit(i)) {
+            value |= 1 << (position % 8);
+        }
+        if(position % 8 == 7) {
+            if(_fifoLength == sizeof(_fifo)) {
+                errors |= SIM_BUFFER_OVFL;
+            }
+            fifoPush(value);
+            value = 0;
+        }
+    }
+    if(total % 8) {
+        if(_fifoLength == sizeof(_fifo)) {
+            errors |= SIM_BUFFER_OVFL;
+        }
+        fifoPush(value);
+    }
+    _registers[MFRC522::ControlReg] = (_registers[MFRC522::ControlReg] & 0xF8) | (total % 8);
+
+    // CollPos counts from 1 in the received data, including the RxAlign bits; 32 reads as 0.
+    if(_collision && _collision <= bits) {
+        errors |= SIM_COLL_ERR;
+        _registers[MFRC522::CollReg] = (_registers[MFRC522::CollReg] & 0x80) | ((rxAlign + _collision) & 0x1F);
+    }
+    else {
+        _registers[MFRC522::CollReg] = (_registers[MFRC522::CollReg] & 0x80) | 0x20;   // CollPosNotValid
+    }
+    _registers[MFRC522::ErrorReg] = errors;
+
+    byte comIrq = SIM_RX_IRQ | (errors ? SIM_ERR_IRQ : 0);
+    if((_registers[MFRC522::CommandReg] & 0x0F) == MFRC522::PCD_Receive) {
+        finish(comIrq);
+        return;
+    }
+    // Transceive stays active, the next StartSend transmits again
+    _phase = PHASE_WAIT_START;
+    irq(comIrq);
+}
+
+// Nothing received before the timer ran out. The receiver stays on.
+void MFRC522Sim::timeout()
+{
+    _stats.timeouts++;
+    irq(SIM_TIMER_IRQ);
+}
+
+/**
+ * MFAuthent: FIFO holds the auth command, block address, 6 byte key and 4 UID bytes. The three passes take the
+ * air time of their frames. On success MFCrypto1On is set and the command ends; if the card does not answer
+ * (no card, wrong key) the command waits for the timer like a receive does.
+ */
+void MFRC522Sim::authenticate()
+{
+    byte data[12];
+    bool complete = _fifoLength >= sizeof(data);
+    for(byte i = 0; i < sizeof(data); i++) {
+        data[i] = fifoPop();
+    }
+    SimPicc * card = NULL;
+    for(uint8_t i = 0; _fieldOn && i < _piccCount; i++) {
+        if(_piccs[i]->state() == SimPicc::STATE_ACTIVE) {
+            card = _piccs[i];
+        }
+    }
+    _authOk = complete && card && card->authenticate(data[0], data[1], &data[2]);
+    _phase = PHASE_AUTHENTICATE;
+    // AUTH + CRC, FDT, token RB, then token AB, FDT, token BA
+    uint64_t ns = airNs(32);
+    if(card) {
+        ns += SimPicc::FDT_NS + airNs(32) + SimPicc::FDT_NS + airNs(64);
+        if(_authOk) {
+            ns += SimPicc::FDT_NS + airNs(32);
+        }
+    }
+    _stats.framesSent += card ? 2 : 1;
+    _stats.framesReceived += card ? (_authOk ? 2 : 1) : 0;
+    _stats.airNs += ns;
+    at(ns, DUE_AUTHENTICATED);
+}
+
+void MFRC522Sim::authenticated()
+{
+    if(_authOk) {
+        _registers[MFRC522::Status2Reg] |= SIM_MF_CRYPTO1_ON;
+        finish(0);
+        return;
+    }
+    _phase = PHASE_RECEIVE_WAIT;
+    if(_registers[MFRC522::TModeReg] & 0x80) {
+        at(timerNs(), DUE_TIMEOUT);
+    }
+}
+
+// CalcCRC processes whatever is in the FIFO, also bytes written while it runs, and stays active.
+void MFRC522Sim::calculateCrc()
+{
+    byte data[sizeof(_fifo)];
+    byte count = _fifoLength;
+    for(byte i = 0; i < count; i++) {
+        data[i] = fifoPop();
+    }
+    _crc = SimFrame::crcA(data, count, _crc);
+    _phase = PHASE_CRC;
+    at(count * SIM_CRC_BYTE_NS, DUE_CRC);
+}
+
+void MFRC522Sim::crcDone()
+{
+    _phase = PHASE_IDLE;
+    irq(0, SIM_CRC_IRQ);
+}
+
+// Digital self test (AutoTestReg = 0x09): CalcCRC fills the FIFO with the 64 byte reference of the version.
+void MFRC522Sim::selfTest()
+{
+    const byte * reference = NULL;
+    switch(_registers[MFRC522::VersionReg]) {
+        case 0x88:
+            reference = FM17522_firmware_reference;
+            break;
+        case 0x90:
+            reference = MFRC522_firmware_referenceV0_0;
+            break;
+        case 0x91:
+            reference = MFRC522_firmware_referenceV1_0;
+            break;
+        case 0x92:
+            reference = MFRC522_firmware_referenceV2_0;
+            break;
+    }
+    _fifoHead = _fifoLength = 0;
+    for(byte i = 0; i < 64; i++) {
+        fifoPush(reference ? reference[i] : 0);
+    }
+    _phase = PHASE_CRC;
+    at(64 * SIM_CRC_BYTE_NS, DUE_CRC);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Timing, field and IRQ
+/////////////////////////////////////////////////////////////////////////////////////
+
+// The timer period: (2 * TPrescaler + 1) * (TReload + 1) / 13.56 MHz
+uint64_t MFRC522Sim::timerNs() const
+{
+    uint64_t prescaler = ((_registers[MFRC522::TModeReg] & 0x0F) << 8) | _registers[MFRC522::TPrescalerReg];
+    uint64_t reload = (_registers[MFRC522::TReloadRegH] << 8) | _registers[MFRC522::TReloadRegL];
+    return (2 * prescaler + 1) * (reload + 1) * 1000000000ULL / SIM_FC_HZ;
+}
+
+// A 106 kBd frame: start bit, data bits, a parity bit per whole byte, end of frame. One bit is 128 / fc.
+uint64_t MFRC522Sim::airNs(uint16_t bits)
+{
+    return (uint64_t)(bits + bits / 8 + 2) * 128 * 1000000000ULL / SIM_FC_HZ;
+}
+
+void MFRC522Sim::at(uint64_t delayNs, Due due)
+{
+    HostClock::cancel(event, this);
+    _due = due;
+    HostClock::schedule(HostClock::nowNs() + delayNs, event, this);
+}
+
+void MFRC522Sim::event(void * context)
+{
+    MFRC522Sim * pcd = (MFRC522Sim *)context;
+    switch(pcd->_due) {
+        case DUE_TRANSMITTED:
+            pcd->transmitted();
+            break;
+        case DUE_ANSWER:
+            pcd->answer();
+            break;
+        case DUE_RECEIVED:
+            pcd->received();
+            break;
+        case DUE_TIMEOUT:
+            pcd->timeout();
+            break;
+        case DUE_AUTHENTICATED:
+            pcd->authenticated();
+            break;
+        case DUE_CRC:
+            pcd->crcDone();
+            break;
+    }
+}
+
+// TX1/TX2 on: the cards in the field get power. Off: they lose it, and their state.
+void MFRC522Sim::antenna()
+{
+    bool on = _registers[MFRC522::TxControlReg] & 0x03;
+    if(on == _fieldOn) {
+        return;
+    }
+    _fieldOn = on;
+    for(uint8_t i = 0; i < _piccCount; i++) {
+        if(on) {
+            _piccs[i]->powerOn();
+        }
+        else {
+            _piccs[i]->powerOff();
+        }
+    }
+}
+
+void MFRC522Sim::irq(byte comIrq, byte divIrq)
+{
+    _registers[MFRC522::ComIrqReg] |= comIrq;
+    _registers[MFRC522::DivIrqReg] |= divIrq;
+    updateIrq();
+}
+
+// The IRQ output follows Status1Reg.IRq, inverted if ComIEnReg.IRqInv is set. As an open drain output
+// (DivIEnReg.IRQPushPull = 0) it only pulls low; the pin's pull-up does the rest.
+void MFRC522Sim::updateIrq()
+{
+    if(_irqPin == NO_PIN) {
+        return;
+    }
+    bool irq = (_registers[MFRC522::ComIrqReg] & _registers[MFRC522::ComIEnReg] & 0x7F)
+               || (_registers[MFRC522::DivIrqReg] & _registers[MFRC522::DivIEnReg] & 0x14);
+    bool inverted = _registers[MFRC522::ComIEnReg] & 0x80;
+    HostGpio::drive(_irqPin, irq != inverted ? HIGH : LOW);
+}
@@ -0,0 +1,130 @@
+/**
+ * MFRC522Sim.h - Register accurate host simulation of the MFRC522 reader IC.
+ *
+ * Models what the driver relies on, at the register level and in (virtual) time:
+ *  - the register file with its reset values, Set1/Set2 interrupt request registers, write-only and
+ *    read-only bits;
+ *  - the 64 byte FIFO with FlushBuffer, the water level alerts and BufferOvfl;
+ *  - the commands Idle, Mem, GenerateRandomID, CalcCRC (including the digital self test), Transmit, Receive,
+ *    Transceive, MFAuthent and SoftReset;
+ *  - bit oriented framing (TxLastBits, RxAlign, RxLastBits), CRC_A generation and checking by the
+ *    TxModeReg/RxModeReg CRC enable bits (a checked CRC_A is not written to the FIFO), bit collisions
+ *    (CollReg, CollErr);
+ *  - the timer (TAuto, prescaler, reload) as the receive timeout;
+ *  - the IRQ output (IRqInv, IRQPushPull);
+ *  - the antenna drivers: cards in the field are only powered while TX1/TX2 are on.
+ *
+ * Frames go on the air at 106 kBd; the time a command takes is the air time of the frames plus the card's
+ * response time, and completes through HostClock events, so polling and blocking drivers see realistic
+ * timing. Cards are SimPicc instances placed in the field with addPicc().
+ *
+ * The simulator is an I2C slave on the host Wire and an MFRC522_RegisterFile for the sim transport.
+ * Direct register file access costs about the time of an SPI transfer (DIRECT_BYTE_NS per byte), so that
+ * polling loops see time pass.
+ */
+#ifndef MFRC522Sim_h
+#define MFRC522Sim_h
+
+#include <Wire.h>
+#include "MFRC522_Transport.h"
+#include "SimPicc.h"
+
+// Air interface counters.
+struct MFRC522SimStats {
+    uint32_t framesSent;        // PCD to PICC
+    uint32_t framesReceived;    // PICC to PCD
+    uint32_t collisions;
+    uint32_t timeouts;          // timer expired while waiting for a frame
+    uint64_t airNs;             // time with a frame on the air, either direction
+};
+
+class MFRC522Sim : public HostI2CDevice, public MFRC522_RegisterFile
+{
+    public:
+        static const uint8_t MAX_PICCS = 8;
+        static const uint8_t NO_PIN = 0xFF;
+        static const uint32_t DIRECT_BYTE_NS = 1600;    // address + data byte at 10 MHz SPI
+
+        MFRC522Sim(byte version = 0x92);
+
+        bool addPicc(SimPicc * picc);
+        void removePicc(SimPicc * picc);
+        void connectIrq(uint8_t pin);
+
+        const MFRC522SimStats & stats() const
+        {
+            return _stats;
+        }
+        void resetStats();
+
+        void i2cWrite(const uint8_t * data, size_t length) override;
+        void i2cRead(uint8_t * data, size_t length) override;
+        void writeRegister(byte reg, const byte * values, byte count) override;
+        void readRegister(byte reg, byte * values, byte count) override;
+    private:
+        enum Phase {
+            PHASE_IDLE,
+            PHASE_WAIT_START,       // Transceive, waiting for StartSend
+            PHASE_TRANSMIT,
+            PHASE_RECEIVE_WAIT,     // receiver on, nothing on the air yet
+            PHASE_RECEIVE,          // a PICC frame on the air
+            PHASE_AUTHENTICATE,
+            PHASE_CRC
+        };
+
+        // what the scheduled event does
+        enum Due {
+            DUE_TRANSMITTED,
+            DUE_ANSWER,
+            DUE_RECEIVED,
+            DUE_TIMEOUT,
+            DUE_AUTHENTICATED,
+            DUE_CRC
+        };
+
+        void reset();
+        void write(byte reg, byte value);
+        byte read(byte reg);
+        void command(byte command);
+        void finish(byte comIrq);
+        void transmit();
+        void transmitted();
+        void answer();
+        void received();
+        void timeout();
+        void authenticate();
+        void authenticated();
+        void calculateCrc();
+        void crcDone();
+        void selfTest();
+        void antenna();
+        void irq(byte comIrq, byte divIrq = 0);
+        void updateIrq();
+        void fifoPush(byte value);
+        byte fifoPop();
+        uint64_t timerNs() const;
+        void at(uint64_t delayNs, Due due);
+        static void event(void * context);
+        static uint64_t airNs(uint16_t bits);
+
+        byte _registers[64];
+        byte _fifo[64];
+        byte _fifoHead;
+        byte _fifoLength;
+        byte _buffer[25];       // Mem command buffer
+        byte _address;          // I2C register pointer
+        uint8_t _irqPin;
+        Phase _phase;
+        Due _due;
+        bool _authOk;
+        uint16_t _crc;
+        SimFrame _tx;
+        SimFrame _rx;
+        uint16_t _collision;    // first collided bit of _rx, counting from 1
+        SimPicc * _piccs[MAX_PICCS];
+        uint8_t _piccCount;
+        bool _fieldOn;
+        MFRC522SimStats _stats;
+};
+
+#endif
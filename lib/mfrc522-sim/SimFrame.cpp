@@ -0,0 +1,62 @@
+#include "SimFrame.h"
+
+void SimFrame::set(const byte * values, uint16_t length)
+{
+    if(length > MAX_BYTES) {
+        length = MAX_BYTES;
+    }
+    memcpy(data, values, length);
+    bits = length * 8;
+}
+
+void SimFrame::appendBit(bool value)
+{
+    if(bits >= MAX_BYTES * 8) {
+        return;
+    }
+    if(bits % 8 == 0) {
+        data[bits / 8] = 0;
+    }
+    if(value) {
+        data[bits / 8] |= 1 << (bits % 8);
+    }
+    bits++;
+}
+
+void SimFrame::appendByte(byte value)
+{
+    for(byte i = 0; i < 8; i++) {
+        appendBit((value >> i) & 1);
+    }
+}
+
+// Appends CRC_A over the (whole) bytes so far.
+void SimFrame::appendCrc()
+{
+    uint16_t crc = crcA(data, bits / 8);
+    appendByte(crc & 0xFF);
+    appendByte(crc >> 8);
+}
+
+// True if the frame is whole bytes, at least one plus CRC_A, and the CRC_A matches.
+bool SimFrame::hasValidCrc() const
+{
+    if(bits % 8 || bits < 24) {
+        return false;
+    }
+    uint16_t length = bits / 8 - 2;
+    uint16_t crc = crcA(data, length);
+    return data[length] == (crc & 0xFF) && data[length + 1] == (crc >> 8);
+}
+
+// ISO/IEC 14443-3 CRC_A (CRC-16/CCITT reflected, preset 0x6363 for type A)
+uint16_t SimFrame::crcA(const byte * values, size_t length, uint16_t preset)
+{
+    uint16_t crc = preset;
+    for(size_t i = 0; i < length; i++) {
+        byte b = values[i] ^ (crc & 0xFF);
+        b ^= b << 4;
+        crc = (crc >> 8) ^ ((uint16_t)b << 8) ^ ((uint16_t)b << 3) ^ (b >> 4);
+    }
+    return crc;
+}
@@ -0,0 +1,34 @@
+#ifndef SimFrame_h
+#define SimFrame_h
+
+#include <Arduino.h>
+
+/**
+ * A frame on the air between the simulated PCD and PICCs.
+ * Bits are sent LSB first, byte by byte; the last byte may be incomplete (short frames, anticollision, ACK/NAK).
+ */
+struct SimFrame {
+    static const uint16_t MAX_BYTES = 260;  // FAST_READ of a whole NTAG216 + CRC_A
+
+    byte data[MAX_BYTES];
+    uint16_t bits;
+
+    SimFrame() : bits(0) {}
+    uint16_t bytes() const
+    {
+        return (bits + 7) / 8;
+    }
+    bool bit(uint16_t index) const
+    {
+        return (data[index / 8] >> (index % 8)) & 1;
+    }
+    void set(const byte * values, uint16_t length);
+    void appendBit(bool value);
+    void appendByte(byte value);
+    void appendCrc();
+    bool hasValidCrc() const;
+
+    static uint16_t crcA(const byte * values, size_t length, uint16_t preset = 0x6363);
+};
+
+#endif
@@ -0,0 +1,178 @@
+#include "SimMifareClassic.h"
+#include "MFRC522_I2C.h"
+
+static const byte defaultTrailer[16] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,     // key A
+    0xFF, 0x07, 0x80, 0x69,                 // access bits (transport configuration), general purpose byte
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF      // key B
+};
+
+// A factory fresh card: manufacturer block, empty data blocks, transport keys.
+SimMifareClassic::SimMifareClassic(Type type, const byte * uid, byte uidSize)
+    : SimPicc(uid, uidSize, type == CLASSIC_4K ? (uidSize == 4 ? 0x0002 : 0x0042) : (uidSize == 4 ? 0x0004 : 0x0044),
+              type == MINI ? 0x09 : (type == CLASSIC_4K ? 0x18 : 0x08)),
+      _blocks(type == MINI ? 20 : (type == CLASSIC_4K ? 256 : 64)), _sector(NO_SECTOR), _pending(PENDING_NONE),
+      _pendingCommand(0), _pendingBlock(0), _value(0)
+{
+    memset(_memory, 0, sizeof(_memory));
+    byte * manufacturer = block(0);
+    memcpy(manufacturer, this->uid(), this->uidSize());
+    if(this->uidSize() == 4) {
+        manufacturer[4] = manufacturer[0] ^ manufacturer[1] ^ manufacturer[2] ^ manufacturer[3];
+        manufacturer[5] = type == MINI ? 0x09 : (type == CLASSIC_4K ? 0x18 : 0x08);
+    }
+    for(uint16_t sector = 0; trailerOf(sector) < _blocks; sector++) {
+        memcpy(block(trailerOf(sector)), defaultTrailer, 16);
+    }
+}
+
+// Replaces the memory with a dump, eg from PICC_DumpMifareClassicToSerial() or a reader app. Key A in the
+// trailers must be the real key, not the zeros a card reads out.
+void SimMifareClassic::load(const byte * image, size_t length)
+{
+    memcpy(_memory, image, length < _blocks * 16U ? length : _blocks * 16U);
+}
+
+// Sectors 0..31 have 4 blocks, sectors 32..39 (4K only) have 16.
+uint16_t SimMifareClassic::sectorOf(uint16_t blockAddr)
+{
+    return blockAddr < 128 ? blockAddr / 4 : 32 + (blockAddr - 128) / 16;
+}
+
+uint16_t SimMifareClassic::trailerOf(uint16_t sector)
+{
+    return sector < 32 ? sector * 4 + 3 : 128 + (sector - 32) * 16 + 15;
+}
+
+bool SimMifareClassic::authenticate(byte command, byte blockAddr, const byte * key)
+{
+    _sector = NO_SECTOR;
+    _pending = PENDING_NONE;
+    // a card that fails the authentication stops answering until it is selected again
+    if(blockAddr >= _blocks) {
+        leave();
+        return false;
+    }
+    uint16_t sector = sectorOf(blockAddr);
+    const byte * trailer = block(trailerOf(sector));
+    const byte * expected = command == MFRC522::PICC_CMD_MF_AUTH_KEY_A ? &trailer[0] : &trailer[10];
+    if(memcmp(key, expected, 6) != 0) {
+        leave();
+        return false;
+    }
+    _sector = sector;
+    return true;
+}
+
+bool SimMifareClassic::transceive(const byte * data, uint16_t length, SimFrame & response, uint32_t & delayNs)
+{
+    if(_pending != PENDING_NONE) {
+        Pending pending = _pending;
+        _pending = PENDING_NONE;
+        if(pending == PENDING_WRITE) {
+            if(length != 16) {
+                nak(response, 0x4);
+                return true;
+            }
+            memcpy(block(_pendingBlock), data, 16);
+            delayNs = WRITE_NS;
+            ack(response);
+            return true;
+        }
+        // Value operand: the card does not answer, the PCD sees a timeout and goes on with TRANSFER.
+        if(length != 4) {
+            return false;
+        }
+        int32_t operand;
+        memcpy(&operand, data, 4);
+        memcpy(&_value, block(_pendingBlock), 4);
+        if(_pendingCommand == MFRC522::PICC_CMD_MF_INCREMENT) {
+            _value += operand;
+        }
+        else if(_pendingCommand == MFRC522::PICC_CMD_MF_DECREMENT) {
+            _value -= operand;
+        }
+        response.bits = 0;
+        delayNs = 0;
+        return true;
+    }
+
+    if(length != 2) {
+        return false;
+    }
+    byte command = data[0];
+    byte blockAddr = data[1];
+    switch(command) {
+        case MFRC522::PICC_CMD_MF_READ:
+            if(!accessible(blockAddr)) {
+                nak(response, 0x4);
+                return true;
+            }
+            response.set(block(blockAddr), 16);
+            if(blockAddr == trailerOf(_sector)) {
+                memset(response.data, 0, 6);        // key A is never readable
+            }
+            response.appendCrc();
+            return true;
+        case MFRC522::PICC_CMD_MF_WRITE:
+            if(!accessible(blockAddr) || blockAddr == 0) {
+                nak(response, 0x4);
+                return true;
+            }
+            _pending = PENDING_WRITE;
+            _pendingBlock = blockAddr;
+            ack(response);
+            return true;
+        case MFRC522::PICC_CMD_MF_INCREMENT:
+        case MFRC522::PICC_CMD_MF_DECREMENT:
+        case MFRC522::PICC_CMD_MF_RESTORE:
+            if(!accessible(blockAddr) || !isValue(block(blockAddr))) {
+                nak(response, 0x4);
+                return true;
+            }
+            _pending = PENDING_VALUE;
+            _pendingCommand = command;
+            _pendingBlock = blockAddr;
+            ack(response);
+            return true;
+        case MFRC522::PICC_CMD_MF_TRANSFER: {
+            if(!accessible(blockAddr) || blockAddr == 0 || blockAddr == trailerOf(_sector)) {
+                nak(response, 0x4);
+                return true;
+            }
+            byte * value = block(blockAddr);
+            int32_t inverted = ~_value;
+            memcpy(&value[0], &_value, 4);
+            memcpy(&value[4], &inverted, 4);
+            memcpy(&value[8], &_value, 4);
+            delayNs = WRITE_NS;
+            ack(response);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void SimMifareClassic::deselect()
+{
+    _sector = NO_SECTOR;
+    _pending = PENDING_NONE;
+}
+
+// Blocks of the authenticated sector only.
+bool SimMifareClassic::accessible(byte blockAddr) const
+{
+    return blockAddr < _blocks && _sector != NO_SECTOR && sectorOf(blockAddr) == _sector;
+}
+
+// Value block format: value, ~value, value, addr, ~addr, addr, ~addr
+bool SimMifareClassic::isValue(const byte * data)
+{
+    for(byte i = 0; i < 4; i++) {
+        if(data[i] != data[8 + i] || data[i] != (byte)~data[4 + i]) {
+            return false;
+        }
+    }
+    return data[12] == data[14] && data[13] == data[15] && data[12] == (byte)~data[13];
+}
@@ -0,0 +1,68 @@
+#ifndef SimMifareClassic_h
+#define SimMifareClassic_h
+
+#include "SimPicc.h"
+
+/**
+ * A simulated MIFARE Classic Mini / 1K / 4K.
+ *
+ * Memory, access by sector after authentication, READ, two pass WRITE and the value block commands behave like
+ * the real card. Crypto1 is not: authentication checks the key against the sector trailer and the following
+ * frames travel in plain text. The PCD simulator only tracks whether encryption is switched on
+ * (Status2Reg.MFCrypto1On) on both sides, which is what the driver can get wrong.
+ * Access bits are not enforced, both keys open the whole sector; READ hides key A like a factory card.
+ */
+class SimMifareClassic : public SimPicc
+{
+    public:
+        enum Type {
+            MINI,
+            CLASSIC_1K,
+            CLASSIC_4K
+        };
+
+        static const uint32_t WRITE_NS = 2500000;    // EEPROM programming before the second ACK
+
+        SimMifareClassic(Type type, const byte * uid, byte uidSize = 4);
+
+        uint16_t blockCount() const
+        {
+            return _blocks;
+        }
+        byte * block(uint16_t blockAddr)
+        {
+            return &_memory[blockAddr * 16];
+        }
+        void load(const byte * image, size_t length);
+        static uint16_t sectorOf(uint16_t blockAddr);
+        static uint16_t trailerOf(uint16_t sector);
+
+        bool authenticate(byte command, byte blockAddr, const byte * key) override;
+    protected:
+        bool transceive(const byte * data, uint16_t length, SimFrame & response, uint32_t & delayNs) override;
+        void deselect() override;
+        bool authenticated() const override
+        {
+            return _sector != NO_SECTOR;
+        }
+    private:
+        static const uint16_t NO_SECTOR = 0xFFFF;
+        enum Pending {
+            PENDING_NONE,
+            PENDING_WRITE,
+            PENDING_VALUE
+        };
+
+        bool accessible(byte blockAddr) const;
+        static bool isValue(const byte * data);
+
+        byte _memory[256 * 16];
+        uint16_t _blocks;
+        uint16_t _sector;       // authenticated sector
+        Pending _pending;       // second pass of WRITE / INCREMENT / DECREMENT / RESTORE
+        byte _pendingCommand;
+        byte _pendingBlock;
+        int32_t _value;         // the transfer buffer of the value block commands
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "SimMifareUltralight.h"
+#include "MFRC522_I2C.h"
+
+#define UL_GET_VERSION 0x60
+#define UL_FAST_READ 0x3A
+
+SimMifareUltralight::SimMifareUltralight(Type type, const byte * uid)
+    : SimPicc(uid, 7, 0x0044, 0x00), _type(type), _compatWrite(false), _compatPage(0)
+{
+    static const uint16_t pages[] = { 16, 45, 135, 231 };
+    static const byte dataSize[] = { 0x06, 0x12, 0x3E, 0x6D };     // CC byte 2: data area / 8
+    _pages = pages[type];
+    memset(_memory, 0, sizeof(_memory));
+
+    const byte * id = this->uid();
+    byte * p = page(0);
+    p[0] = id[0];
+    p[1] = id[1];
+    p[2] = id[2];
+    p[3] = MFRC522::PICC_CMD_CT ^ id[0] ^ id[1] ^ id[2];
+    memcpy(&p[4], &id[3], 4);
+    p[8] = id[3] ^ id[4] ^ id[5] ^ id[6];
+    p[9] = 0x48;                        // internal
+    p[12] = 0xE1;                       // CC: NDEF magic number, version 1.0, size, read/write access
+    p[13] = 0x10;
+    p[14] = dataSize[type];
+    p[15] = 0x00;
+    p[16] = 0x03;                       // empty NDEF message TLV, terminator TLV
+    p[17] = 0x00;
+    p[18] = 0xFE;
+    if(type != ULTRALIGHT) {
+        byte * config = page(_pages - 5);
+        config[0] = 0x04;               // MIRROR
+        config[3] = 0xFF;               // AUTH0: no password protection
+        memset(page(_pages - 2), 0xFF, 4);  // PWD
+    }
+}
+
+// Replaces the memory with a dump, starting at page 0.
+void SimMifareUltralight::load(const byte * image, size_t length)
+{
+    memcpy(_memory, image, length < _pages * 4U ? length : _pages * 4U);
+}
+
+// Ultralight: pages 4..15. NTAG: up to the dynamic lock bytes, followed by 4 configuration pages and PWD/PACK.
+uint16_t SimMifareUltralight::userEnd() const
+{
+    return _type == ULTRALIGHT ? _pages : _pages - 5;
+}
+
+bool SimMifareUltralight::transceive(const byte * data, uint16_t length, SimFrame & response, uint32_t & delayNs)
+{
+    if(_compatWrite) {
+        _compatWrite = false;
+        if(length != 16) {
+            nak(response, 0x0);
+            return true;
+        }
+        return writePage(_compatPage, data, response, delayNs);
+    }
+
+    bool ntag = _type != ULTRALIGHT;
+    switch(data[0]) {
+        case MFRC522::PICC_CMD_MF_READ: {
+            if(length != 2 || data[1] >= _pages) {
+                nak(response, 0x0);
+                return true;
+            }
+            response.bits = 0;
+            for(byte i = 0; i < 16; i++) {
+                response.appendByte(_memory[(data[1] * 4 + i) % (_pages * 4)]);
+            }
+            response.appendCrc();
+            return true;
+        }
+        case UL_FAST_READ:
+            if(!ntag) {
+                return false;
+            }
+            if(length != 3 || data[1] > data[2] || data[2] >= _pages) {
+                nak(response, 0x0);
+                return true;
+            }
+            response.set(page(data[1]), (data[2] - data[1] + 1) * 4);
+            response.appendCrc();
+            return true;
+        case UL_GET_VERSION: {
+            if(!ntag || length != 1) {
+                return false;
+            }
+            static const byte storage[] = { 0x0F, 0x11, 0x13 };
+            byte version[] = { 0x00, 0x04, 0x04, 0x02, 0x01, 0x00, storage[_type - NTAG213], 0x03 };
+            response.set(version, sizeof(version));
+            response.appendCrc();
+            return true;
+        }
+        case MFRC522::PICC_CMD_UL_WRITE:
+            if(length != 6) {
+                nak(response, 0x0);
+                return true;
+            }
+            return writePage(data[1], &data[2], response, delayNs);
+        case MFRC522::PICC_CMD_MF_WRITE:
+            if(length != 2 || data[1] < 2 || data[1] >= userEnd()) {
+                nak(response, 0x0);
+                return true;
+            }
+            _compatWrite = true;
+            _compatPage = data[1];
+            ack(response);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void SimMifareUltralight::deselect()
+{
+    _compatWrite = false;
+}
+
+// Pages 0 and 1 hold the UID; page 2's lock bytes and page 3 (OTP, the CC) can only have bits set.
+bool SimMifareUltralight::writePage(byte pageAddr, const byte * data, SimFrame & response, uint32_t & delayNs)
+{
+    if(pageAddr < 2 || pageAddr >= _pages) {
+        nak(response, 0x0);
+        return true;
+    }
+    byte * p = page(pageAddr);
+    if(pageAddr == 2) {
+        p[2] |= data[2];
+        p[3] |= data[3];
+    }
+    else if(pageAddr == 3) {
+        for(byte i = 0; i < 4; i++) {
+            p[i] |= data[i];
+        }
+    }
+    else {
+        memcpy(p, data, 4);
+    }
+    delayNs = WRITE_NS;
+    ack(response);
+    return true;
+}
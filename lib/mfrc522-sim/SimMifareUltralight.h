@@ -0,0 +1,51 @@
+#ifndef SimMifareUltralight_h
+#define SimMifareUltralight_h
+
+#include "SimPicc.h"
+
+/**
+ * A simulated MIFARE Ultralight or NTAG213/215/216 with a 7 byte UID.
+ *
+ * Implements READ (4 pages, rolling over at the end of memory), WRITE, COMPATIBILITY WRITE and, for the NTAG
+ * types, GET_VERSION and FAST_READ. The card starts NDEF formatted: capability container in page 3 and an
+ * empty NDEF message TLV in page 4. Lock bytes, password protection and the counter are not modelled.
+ */
+class SimMifareUltralight : public SimPicc
+{
+    public:
+        enum Type {
+            ULTRALIGHT,
+            NTAG213,
+            NTAG215,
+            NTAG216
+        };
+
+        static const uint32_t WRITE_NS = 4100000;    // EEPROM programming before the ACK
+
+        SimMifareUltralight(Type type, const byte * uid);
+
+        uint16_t pageCount() const
+        {
+            return _pages;
+        }
+        byte * page(uint16_t pageAddr)
+        {
+            return &_memory[pageAddr * 4];
+        }
+        void load(const byte * image, size_t length);
+        // The first page after the user memory.
+        uint16_t userEnd() const;
+    protected:
+        bool transceive(const byte * data, uint16_t length, SimFrame & response, uint32_t & delayNs) override;
+        void deselect() override;
+    private:
+        bool writePage(byte pageAddr, const byte * data, SimFrame & response, uint32_t & delayNs);
+
+        Type _type;
+        byte _memory[231 * 4];
+        uint16_t _pages;
+        bool _compatWrite;      // second pass of COMPATIBILITY WRITE pending
+        byte _compatPage;
+};
+
+#endif
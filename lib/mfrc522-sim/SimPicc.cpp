@@ -0,0 +1,189 @@
+#include "SimPicc.h"
+#include "MFRC522_I2C.h"
+
+SimPicc::SimPicc(const byte * uid, byte uidSize, uint16_t atqa, byte sak)
+    : _uidSize(uidSize == 7 || uidSize == 10 ? uidSize : 4), _atqa(atqa), _sak(sak), _state(STATE_POWER_OFF),
+      _halted(false), _level(0), _nak(false)
+{
+    memset(_uid, 0, sizeof(_uid));
+    memcpy(_uid, uid, _uidSize);
+}
+
+// Entering the field: the card is IDLE, waiting for REQA or WUPA.
+void SimPicc::powerOn()
+{
+    if(_state == STATE_POWER_OFF) {
+        _state = STATE_IDLE;
+        _halted = false;
+        _level = 0;
+    }
+}
+
+void SimPicc::powerOff()
+{
+    if(_state == STATE_ACTIVE) {
+        deselect();
+    }
+    _state = STATE_POWER_OFF;
+}
+
+/**
+ * A frame from the PCD. Returns true if the card answers, with the answer in response and the time between the
+ * end of the request and the start of the answer in delayNs. crypto1 tells whether the PCD encrypts.
+ */
+bool SimPicc::receive(const SimFrame & request, bool crypto1, SimFrame & response, uint32_t & delayNs)
+{
+    response.bits = 0;
+    delayNs = FDT_NS;
+    if(_state == STATE_POWER_OFF || request.bits == 0) {
+        return false;
+    }
+
+    // A short frame: REQA or WUPA. ACTIVE cards do not expect one and fall back.
+    if(request.bits == 7) {
+        byte command = request.data[0] & 0x7F;
+        if((command == MFRC522::PICC_CMD_REQA && _state == STATE_IDLE)
+           || (command == MFRC522::PICC_CMD_WUPA && (_state == STATE_IDLE || _state == STATE_HALT))) {
+            _halted = _state == STATE_HALT;
+            _state = STATE_READY;
+            _level = 0;
+            response.appendByte(_atqa & 0xFF);
+            response.appendByte(_atqa >> 8);
+            return true;
+        }
+        if(_state == STATE_READY || _state == STATE_ACTIVE) {
+            leave();
+        }
+        return false;
+    }
+
+    switch(_state) {
+        case STATE_READY:
+            if(request.bits >= 16 && request.data[0] == MFRC522::PICC_CMD_SEL_CL1 + 2 * _level) {
+                if(request.data[1] == 0x70) {
+                    return select(request, response);
+                }
+                return anticollision(request, response);
+            }
+            leave();
+            return false;
+        case STATE_ACTIVE:
+            // Plain frames to an authenticated card (or the other way around) are garbage to the card.
+            if(crypto1 != authenticated() || !request.hasValidCrc()) {
+                leave();
+                return false;
+            }
+            if(request.bits == 32 && request.data[0] == MFRC522::PICC_CMD_HLTA && request.data[1] == 0) {
+                deselect();
+                _state = STATE_HALT;
+                _halted = true;
+                return false;
+            }
+            _nak = false;
+            if(!transceive(request.data, request.bits / 8 - 2, response, delayNs)) {
+                leave();
+                return false;
+            }
+            if(_nak) {
+                leave();
+            }
+            return response.bits != 0;
+        default:
+            return false;
+    }
+}
+
+// ANTICOLLISION: NVB gives the number of UID bits the PCD already knows. A card whose cascade level starts with
+// those bits answers with the rest; the others stay silent and READY.
+bool SimPicc::anticollision(const SimFrame & request, SimFrame & response)
+{
+    byte nvb = request.data[1];
+    uint16_t known = (nvb >> 4) * 8 + (nvb & 0x0F);
+    if(known < 16 || known > 16 + 39 || request.bits != known) {
+        leave();
+        return false;
+    }
+    known -= 16;
+    byte bytes[5];
+    cascadeLevel(bytes);
+    SimFrame own;
+    own.set(bytes, sizeof(bytes));
+    for(uint16_t i = 0; i < known; i++) {
+        if(own.bit(i) != request.bit(16 + i)) {
+            return false;
+        }
+    }
+    for(uint16_t i = known; i < 40; i++) {
+        response.appendBit(own.bit(i));
+    }
+    return true;
+}
+
+// SELECT: the full cascade level with BCC and CRC_A. Answers SAK, with the cascade bit set while UID levels remain.
+// Cards that do not match go back to IDLE (or HALT), as in ISO/IEC 14443-3.
+bool SimPicc::select(const SimFrame & request, SimFrame & response)
+{
+    byte bytes[5];
+    cascadeLevel(bytes);
+    if(request.bits != 9 * 8 || !request.hasValidCrc() || memcmp(&request.data[2], bytes, sizeof(bytes)) != 0) {
+        leave();    // includes another card being selected
+        return false;
+    }
+    byte levels = _uidSize == 4 ? 1 : (_uidSize == 7 ? 2 : 3);
+    if(_level + 1 < levels) {
+        response.appendByte(0x04);
+        _level++;
+    }
+    else {
+        response.appendByte(_sak);
+        _state = STATE_ACTIVE;
+    }
+    response.appendCrc();
+    return true;
+}
+
+// The 4 UID bytes and BCC of the current cascade level. All but the last level start with the cascade tag.
+void SimPicc::cascadeLevel(byte * bytes) const
+{
+    byte levels = _uidSize == 4 ? 1 : (_uidSize == 7 ? 2 : 3);
+    byte offset = _level * 3;
+    if(_level + 1 < levels) {
+        bytes[0] = MFRC522::PICC_CMD_CT;
+        memcpy(&bytes[1], &_uid[offset], 3);
+    }
+    else {
+        memcpy(bytes, &_uid[offset], 4);
+    }
+    bytes[4] = bytes[0] ^ bytes[1] ^ bytes[2] ^ bytes[3];
+}
+
+// Unexpected frame: back to IDLE, or to HALT for a card that was woken from HALT.
+void SimPicc::leave()
+{
+    if(_state == STATE_ACTIVE) {
+        deselect();
+    }
+    _state = _halted ? STATE_HALT : STATE_IDLE;
+    _level = 0;
+}
+
+// The 4 bit ACK.
+void SimPicc::ack(SimFrame & response)
+{
+    code(response, 0xA);
+}
+
+// A 4 bit NAK. The card falls back to IDLE (or HALT) after sending it.
+void SimPicc::nak(SimFrame & response, byte code)
+{
+    this->code(response, code);
+    _nak = true;
+}
+
+void SimPicc::code(SimFrame & response, byte code)
+{
+    response.bits = 0;
+    for(byte i = 0; i < 4; i++) {
+        response.appendBit((code >> i) & 1);
+    }
+}
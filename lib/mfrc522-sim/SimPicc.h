@@ -0,0 +1,91 @@
+#ifndef SimPicc_h
+#define SimPicc_h
+
+#include "SimFrame.h"
+
+/**
+ * A simulated ISO/IEC 14443-3 type A card (PICC).
+ *
+ * The base class implements activation: the IDLE / READY / ACTIVE / HALT state machine, REQA/WUPA with ATQA,
+ * bit oriented anticollision and SELECT over up to three cascade levels, SAK and HLTA.
+ * Subclasses implement the card's own command set in transceive(), which only sees well formed frames sent
+ * to an ACTIVE card, with CRC_A checked and removed.
+ *
+ * Timing is the card's part of a frame exchange: the delay from the end of the PCD's frame to the start of the
+ * answer. Air time is the PCD simulator's business (MFRC522Sim).
+ */
+class SimPicc
+{
+    public:
+        enum State {
+            STATE_POWER_OFF,
+            STATE_IDLE,
+            STATE_READY,
+            STATE_ACTIVE,
+            STATE_HALT
+        };
+
+        static const uint32_t FDT_NS = 86000;       // frame delay time for n = 9: (9 * 128 + 20) / fc
+
+        SimPicc(const byte * uid, byte uidSize, uint16_t atqa, byte sak);
+        virtual ~SimPicc() {}
+
+        const byte * uid() const
+        {
+            return _uid;
+        }
+        byte uidSize() const
+        {
+            return _uidSize;
+        }
+        State state() const
+        {
+            return _state;
+        }
+
+        void powerOn();
+        void powerOff();
+        bool receive(const SimFrame & request, bool crypto1, SimFrame & response, uint32_t & delayNs);
+
+        // MIFARE Classic three pass authentication, run by the PCD's MFAuthent command on an ACTIVE card.
+        virtual bool authenticate(byte command, byte blockAddr, const byte * key)
+        {
+            (void)command;
+            (void)blockAddr;
+            (void)key;
+            return false;
+        }
+    protected:
+        // A command for the ACTIVE card. Fill response and return true to answer (an empty response stays
+        // silent but ACTIVE), return false to fall back to IDLE (or HALT) without answering, which is what cards
+        // do with frames they do not understand.
+        virtual bool transceive(const byte * data, uint16_t length, SimFrame & response, uint32_t & delayNs) = 0;
+        // The card leaves ACTIVE (or loses power): drop any per-session state.
+        virtual void deselect() {}
+        // True while the card expects Crypto1 encrypted frames.
+        virtual bool authenticated() const
+        {
+            return false;
+        }
+
+        static void ack(SimFrame & response);
+        void nak(SimFrame & response, byte code);
+        // Back to IDLE (or HALT), like after a frame the card does not understand.
+        void leave();
+    private:
+        static void code(SimFrame & response, byte code);
+        bool anticollision(const SimFrame & request, SimFrame & response);
+        bool select(const SimFrame & request, SimFrame & response);
+        void cascadeLevel(byte * bytes) const;
+
+        byte _uid[10];
+        byte _uidSize;
+        uint16_t _atqa;
+        byte _sak;
+        State _state;
+        bool _halted;       // READY* / ACTIVE*: woken from HALT by WUPA, falls back to HALT
+        byte _level;        // cascade level being selected, 0..2
+        bool _nak;          // transceive() answered NAK
+};
+
+#endif
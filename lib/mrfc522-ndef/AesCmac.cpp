@@ -0,0 +1,140 @@
+#include "AesCmac.h"
+
+static inline uint32_t ror(uint32_t word, byte bits)
+{
+    return (word >> bits) | (word << (32 - bits));
+}
+
+static inline uint32_t getWord(const byte * data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+static inline void putWord(uint32_t word, byte * data)
+{
+    data[0] = word >> 24;
+    data[1] = word >> 16;
+    data[2] = word >> 8;
+    data[3] = word;
+}
+
+// SubWord of a column
+static inline uint32_t subWord(uint32_t word)
+{
+    const byte * sbox = AES_tables.sbox;
+    return ((uint32_t)sbox[word >> 24] << 24) | ((uint32_t)sbox[(word >> 16) & 0xFF] << 16)
+           | ((uint32_t)sbox[(word >> 8) & 0xFF] << 8) | sbox[word & 0xFF];
+}
+
+Aes128::Aes128(const byte * key)
+{
+    if(key) {
+        setKey(key);
+    }
+}
+
+// FIPS-197 5.2
+void Aes128::setKey(const byte * key)
+{
+    byte rcon = 0x01;
+    for(byte i = 0; i < 4; i++) {
+        _roundKeys[i] = getWord(&key[4 * i]);
+    }
+    for(byte i = 4; i < 44; i++) {
+        uint32_t word = _roundKeys[i - 1];
+        if(i % 4 == 0) {
+            word = subWord((word << 8) | (word >> 24)) ^ ((uint32_t)rcon << 24);
+            rcon = AES_xtime(rcon);
+        }
+        _roundKeys[i] = _roundKeys[i - 4] ^ word;
+    }
+}
+
+void Aes128::encrypt(const byte * in, byte * out) const
+{
+    const uint32_t * te = AES_tables.te;
+    const byte * sbox = AES_tables.sbox;
+    const uint32_t * rk = _roundKeys;
+    uint32_t s0 = getWord(&in[0]) ^ rk[0];
+    uint32_t s1 = getWord(&in[4]) ^ rk[1];
+    uint32_t s2 = getWord(&in[8]) ^ rk[2];
+    uint32_t s3 = getWord(&in[12]) ^ rk[3];
+
+    // rounds 1 to 9: SubBytes, ShiftRows and MixColumns in the table lookups, then AddRoundKey
+    for(byte round = 1; round < 10; round++) {
+        rk += 4;
+        uint32_t t0 = te[s0 >> 24] ^ ror(te[(s1 >> 16) & 0xFF], 8) ^ ror(te[(s2 >> 8) & 0xFF], 16)
+                      ^ ror(te[s3 & 0xFF], 24) ^ rk[0];
+        uint32_t t1 = te[s1 >> 24] ^ ror(te[(s2 >> 16) & 0xFF], 8) ^ ror(te[(s3 >> 8) & 0xFF], 16)
+                      ^ ror(te[s0 & 0xFF], 24) ^ rk[1];
+        uint32_t t2 = te[s2 >> 24] ^ ror(te[(s3 >> 16) & 0xFF], 8) ^ ror(te[(s0 >> 8) & 0xFF], 16)
+                      ^ ror(te[s1 & 0xFF], 24) ^ rk[2];
+        uint32_t t3 = te[s3 >> 24] ^ ror(te[(s0 >> 16) & 0xFF], 8) ^ ror(te[(s1 >> 8) & 0xFF], 16)
+                      ^ ror(te[s2 & 0xFF], 24) ^ rk[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+    // the last round has no MixColumns
+    rk += 4;
+    putWord(((uint32_t)sbox[s0 >> 24] << 24 | (uint32_t)sbox[(s1 >> 16) & 0xFF] << 16
+             | (uint32_t)sbox[(s2 >> 8) & 0xFF] << 8 | sbox[s3 & 0xFF]) ^ rk[0], &out[0]);
+    putWord(((uint32_t)sbox[s1 >> 24] << 24 | (uint32_t)sbox[(s2 >> 16) & 0xFF] << 16
+             | (uint32_t)sbox[(s3 >> 8) & 0xFF] << 8 | sbox[s0 & 0xFF]) ^ rk[1], &out[4]);
+    putWord(((uint32_t)sbox[s2 >> 24] << 24 | (uint32_t)sbox[(s3 >> 16) & 0xFF] << 16
+             | (uint32_t)sbox[(s0 >> 8) & 0xFF] << 8 | sbox[s1 & 0xFF]) ^ rk[2], &out[8]);
+    putWord(((uint32_t)sbox[s3 >> 24] << 24 | (uint32_t)sbox[(s0 >> 16) & 0xFF] << 16
+             | (uint32_t)sbox[(s1 >> 8) & 0xFF] << 8 | sbox[s2 & 0xFF]) ^ rk[3], &out[12]);
+}
+
+// Doubling in GF(2^128), RFC 4493 2.3
+static void shiftSubkey(const byte * in, byte * out)
+{
+    byte carry = in[0] & 0x80;
+    for(byte i = 0; i < AES_BLOCK_SIZE - 1; i++) {
+        out[i] = (in[i] << 1) | (in[i + 1] >> 7);
+    }
+    out[AES_BLOCK_SIZE - 1] = (in[AES_BLOCK_SIZE - 1] << 1) ^ (carry ? 0x87 : 0);
+}
+
+AesCmac::AesCmac(const byte * key)
+{
+    if(key) {
+        setKey(key);
+    }
+}
+
+void AesCmac::setKey(const byte * key)
+{
+    byte l[AES_BLOCK_SIZE] = { 0 };
+    _aes.setKey(key);
+    _aes.encrypt(l, l);
+    shiftSubkey(l, _k1);
+    shiftSubkey(_k1, _k2);
+}
+
+void AesCmac::mac(const byte * data, size_t length, byte * out) const
+{
+    mac(data, length, length == 0 ? 1 : (length + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE, out);
+}
+
+void AesCmac::mac(const byte * data, size_t length, size_t blocks, byte * out) const
+{
+    byte state[AES_BLOCK_SIZE] = { 0 };
+    bool padded = length < blocks * AES_BLOCK_SIZE;
+    for(size_t block = 0; block < blocks; block++) {
+        for(byte i = 0; i < AES_BLOCK_SIZE; i++) {
+            size_t at = block * AES_BLOCK_SIZE + i;
+            state[i] ^= at < length ? data[at] : at == length ? 0x80 : 0x00;
+        }
+        if(block == blocks - 1) {
+            const byte * subkey = padded ? _k2 : _k1;
+            for(byte i = 0; i < AES_BLOCK_SIZE; i++) {
+                state[i] ^= subkey[i];
+            }
+        }
+        _aes.encrypt(state, state);
+    }
+    memcpy(out, state, AES_BLOCK_SIZE);
+}
@@ -0,0 +1,88 @@
+/**
+ * AesCmac.h - AES-128 encryption (FIPS-197) and AES-CMAC (NIST SP 800-38B, RFC 4493), computed by the MCU.
+ *
+ * Encryption only, which is all CMAC needs. A round is four lookups per column in a table of the combined SubBytes
+ * and MixColumns (Te0, the other three are its rotations); the table and the S-box are generated by the compiler
+ * (constexpr) and live in flash. The round keys are expanded once per key, so a CMAC over two blocks, eg a key
+ * diversification, costs two block encryptions.
+ */
+#ifndef AesCmac_h
+#define AesCmac_h
+
+#include <Arduino.h>
+#include "MFRC522_CRC.h"
+
+#define AES_BLOCK_SIZE 16
+
+// GF(2^8) arithmetic modulo x^8 + x^4 + x^3 + x + 1, single expressions for C++11 constexpr
+constexpr byte AES_xtime(unsigned a)
+{
+    return (byte)((a << 1) ^ (a & 0x80 ? 0x1B : 0));
+}
+constexpr byte AES_mul(unsigned a, unsigned b)
+{
+    return b == 0 ? 0 : (byte)((b & 1 ? a : 0) ^ AES_mul(AES_xtime(a), b >> 1));
+}
+constexpr byte AES_pow(unsigned a, unsigned e)
+{
+    return e == 0 ? 1 : AES_mul(e & 1 ? a : 1, AES_pow(AES_mul(a, a), e >> 1));
+}
+constexpr byte AES_rotl8(unsigned b, unsigned n)
+{
+    return (byte)((b << n) | (b >> (8 - n)));
+}
+// the multiplicative inverse (a^254, 0 for 0) through the affine transformation
+constexpr byte AES_sbox(unsigned a)
+{
+    return AES_pow(a, 254) ^ AES_rotl8(AES_pow(a, 254), 1) ^ AES_rotl8(AES_pow(a, 254), 2)
+           ^ AES_rotl8(AES_pow(a, 254), 3) ^ AES_rotl8(AES_pow(a, 254), 4) ^ 0x63;
+}
+// SubBytes and MixColumns of a byte in the first row: the column 2s, s, s, 3s
+constexpr uint32_t AES_te(byte s)
+{
+    return ((uint32_t)AES_xtime(s) << 24) | ((uint32_t)s << 16) | ((uint32_t)s << 8) | (AES_xtime(s) ^ s);
+}
+
+struct AES_Tables {
+    byte sbox[256];
+    uint32_t te[256];
+};
+
+template <size_t... I> constexpr AES_Tables AES_TablesOf(MFRC522_Indices<I...>)
+{
+    return {{ AES_sbox(I)... }, { AES_te(AES_sbox(I))... }};
+}
+
+constexpr AES_Tables AES_tables = AES_TablesOf(MFRC522_MakeIndices<256>::type());
+
+static_assert(AES_tables.sbox[0x00] == 0x63 && AES_tables.sbox[0x53] == 0xED && AES_tables.sbox[0xFF] == 0x16,
+              "AES S-box");
+
+class Aes128
+{
+    public:
+        Aes128(const byte * key = NULL);
+        void setKey(const byte * key);
+        // in and out may be the same block
+        void encrypt(const byte * in, byte * out) const;
+    private:
+        uint32_t _roundKeys[44];
+};
+
+class AesCmac
+{
+    public:
+        AesCmac(const byte * key = NULL);
+        void setKey(const byte * key);
+        // the CMAC of length bytes
+        void mac(const byte * data, size_t length, byte * out) const;
+        // the CMAC of data padded to blocks blocks: when shorter than that, it gets 0x80 and zeros and the last block
+        // subkey K2, else K1. mac() pads to the next whole block; AN10922 key diversification to 2 blocks.
+        void mac(const byte * data, size_t length, size_t blocks, byte * out) const;
+    private:
+        Aes128 _aes;
+        byte _k1[AES_BLOCK_SIZE];
+        byte _k2[AES_BLOCK_SIZE];
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "MFRC522_CRC.h"
+
+/**
+ * Returns the CRC_A of length bytes, continuing from crc.
+ */
+uint16_t MFRC522_CrcA::compute(const byte * data,   ///< The bytes to checksum.
+                               size_t length,       ///< The number of bytes.
+                               uint16_t crc         ///< PRESET, or the result for the bytes before data.
+                              )
+{
+    for(size_t i = 0; i < length; i++) {
+        crc = update(crc, data[i]);
+    }
+    return crc;
+} // End compute()
+
+/**
+ * Writes the CRC_A of data[0..length-1] to data[length..length+1], low byte first.
+ */
+void MFRC522_CrcA::append(byte * data,      ///< The frame, with room for two more bytes.
+                          size_t length     ///< The number of bytes in the frame.
+                         )
+{
+    uint16_t crc = compute(data, length);
+    data[length] = crc & 0xFF;
+    data[length + 1] = crc >> 8;
+} // End append()
+
+/**
+ * Returns true if the last two of length bytes are the CRC_A of the ones before.
+ */
+bool MFRC522_CrcA::check(const byte * data, ///< The frame, CRC_A included.
+                         size_t length      ///< The number of bytes, CRC_A included.
+                        )
+{
+    if(length < 2) {
+        return false;
+    }
+    uint16_t crc = compute(data, length - 2);
+    return data[length - 2] == (crc & 0xFF) && data[length - 1] == (crc >> 8);
+} // End check()
@@ -0,0 +1,63 @@
+/**
+ * MFRC522_CRC.h - CRC_A (ISO/IEC 14443-3 section 6.2.4) computed by the MCU.
+ *
+ * CRC_A is CRC-16/CCITT with the reflected polynomial 0x8408, preset 0x6363, no final XOR, sent low byte first.
+ * The byte-wise lookup table is generated by the compiler (constexpr) and lives in flash, so a frame's CRC_A
+ * costs a table lookup per byte instead of a CalcCRC command round trip on the bus.
+ *
+ * MFRC522_CrcA::of() is constexpr too: the CRC_A of a fixed frame is a compile time constant.
+ *
+ *      static constexpr uint16_t hltaCrc = MFRC522_CrcA::of(MFRC522::PICC_CMD_HLTA, 0x00);
+ */
+#ifndef MFRC522_CRC_h
+#define MFRC522_CRC_h
+
+#include <Arduino.h>
+
+struct MFRC522_CrcTable {
+    uint16_t entry[256];
+};
+
+// Compile time index sequence 0..N-1 (std::index_sequence is C++14)
+template <size_t... I> struct MFRC522_Indices {};
+template <size_t N, size_t... I> struct MFRC522_MakeIndices : MFRC522_MakeIndices < N - 1, N - 1, I... > {};
+template <size_t... I> struct MFRC522_MakeIndices<0, I...> {
+    typedef MFRC522_Indices<I...> type;
+};
+
+// The CRC register after shifting out bits bits (single expression for C++11 constexpr)
+constexpr uint16_t MFRC522_CrcShift(uint16_t crc, byte bits)
+{
+    return bits == 0 ? crc : MFRC522_CrcShift((crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1, bits - 1);
+}
+
+template <size_t... I> constexpr MFRC522_CrcTable MFRC522_CrcTableOf(MFRC522_Indices<I...>)
+{
+    return {{ MFRC522_CrcShift(I, 8)... }};
+}
+
+constexpr MFRC522_CrcTable MFRC522_crcATable = MFRC522_CrcTableOf(MFRC522_MakeIndices<256>::type());
+
+class MFRC522_CrcA
+{
+    public:
+        static const uint16_t PRESET = 0x6363;
+
+        static constexpr uint16_t update(uint16_t crc, byte value)
+        {
+            return (crc >> 8) ^ MFRC522_crcATable.entry[(crc ^ value) & 0xFF];
+        }
+        // The CRC_A of a two byte frame, eg a command and its argument.
+        static constexpr uint16_t of(byte command, byte argument)
+        {
+            return update(update(PRESET, command), argument);
+        }
+
+        static uint16_t compute(const byte * data, size_t length, uint16_t crc = PRESET);
+        static void append(byte * data, size_t length);
+        static bool check(const byte * data, size_t length);
+};
+
+static_assert(MFRC522_CrcA::of(0x50, 0x00) == 0xCD57, "CRC_A of HLTA is 57 CD");
+
+#endif
@@ -0,0 +1,178 @@
+#include "MFRC522_Dump.h"
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MFRC522_DumpImage
+/////////////////////////////////////////////////////////////////////////////////////
+
+void MFRC522_DumpImage::begin(const MFRC522::Uid &, byte, uint16_t, byte blockSize)
+{
+    unread = 0;
+    _blockSize = blockSize;
+} // End begin()
+
+/**
+ * Appends the block to the image, zeros included: the offset of a block in the image is its address.
+ */
+void MFRC522_DumpImage::block(uint16_t,                         ///< The block (MIFARE Classic) or page (Ultralight).
+                              const byte * data,                ///< Its bytes.
+                              MFRC522::StatusCode status        ///< STATUS_OK if it was read.
+                             )
+{
+    if(status != MFRC522::STATUS_OK) {
+        unread++;
+    }
+    _out.write(data, _blockSize);
+} // End block()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MFRC522_DumpPrinter
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Writes " XX" for each of length bytes to p, with an extra space after every 4 if grouped.
+ *
+ * @return The end of what was written.
+ */
+static char * printHex(char * p, const byte * data, byte length, bool grouped)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    for(byte index = 0; index < length; index++) {
+        *p++ = ' ';
+        *p++ = digits[data[index] >> 4];
+        *p++ = digits[data[index] & 0xF];
+        if(grouped && (index % 4) == 3) {
+            *p++ = ' ';
+        }
+    }
+    return p;
+} // End printHex()
+
+/**
+ * Prints the table header.
+ */
+void MFRC522_DumpPrinter::begin(const MFRC522::Uid &, byte, uint16_t, byte blockSize)
+{
+    _blockSize = blockSize;
+    if(blockSize == 4) {
+        _out.println(F("Page  0  1  2  3"));
+    }
+    else {
+        _out.println(F("Sector Block   0  1  2  3   4  5  6  7   8  9 10 11  12 13 14 15  AccessBits"));
+    }
+} // End begin()
+
+/**
+ * Prints an Ultralight page, or keeps a MIFARE Classic block until the sector trailer comes.
+ */
+void MFRC522_DumpPrinter::block(uint16_t addr,                  ///< The block (MIFARE Classic) or page (Ultralight).
+                                const byte * data,              ///< Its bytes.
+                                MFRC522::StatusCode status      ///< STATUS_OK if it was read.
+                               )
+{
+    if(_blockSize == 4) {
+        char line[32];
+        char * p = line + sprintf(line, "%3u  ", (unsigned)addr);
+        if(status != MFRC522::STATUS_OK) {
+            _out.write((const uint8_t *)line, p - line);
+            _out.print(F("Not read: "));
+            _out.println(MFRC522::GetStatusCodeName(status));
+            return;
+        }
+        p = printHex(p, data, 4, false);
+        *p++ = '\r';
+        *p++ = '\n';
+        _out.write((const uint8_t *)line, p - line);
+        return;
+    }
+
+    // Sectors 0..31 have 4 blocks, sectors 32..39 16
+    byte blocks = addr < 128 ? 4 : 16;
+    byte offset = addr < 128 ? addr & 3 : (addr - 128) & 15;
+    memcpy(_data[offset], data, 16);
+    _status[offset] = status;
+    if(offset == blocks - 1) {
+        printSector(addr - offset, blocks);
+    }
+} // End block()
+
+/**
+ * Prints the sector held, highest address first, with the access bits its trailer gives each block.
+ */
+void MFRC522_DumpPrinter::printSector(uint16_t firstBlock,      ///< The address of its first block.
+                                      byte blocks               ///< Its number of blocks, 4 or 16.
+                                     )
+{
+    byte sector = firstBlock < 128 ? firstBlock / 4 : 32 + (firstBlock - 128) / 16;
+    const byte * trailer = _data[blocks - 1];
+    bool accessBits = _status[blocks - 1] == MFRC522::STATUS_OK;
+
+    // The access bits are stored in a peculiar fashion.
+    // There are four groups:
+    //      g[3]    Access bits for the sector trailer, block 3 (for sectors 0-31) or block 15 (for sectors 32-39)
+    //      g[2]    Access bits for block 2 (for sectors 0-31) or blocks 10-14 (for sectors 32-39)
+    //      g[1]    Access bits for block 1 (for sectors 0-31) or blocks 5-9 (for sectors 32-39)
+    //      g[0]    Access bits for block 0 (for sectors 0-31) or blocks 0-4 (for sectors 32-39)
+    // Each group has access bits [C1 C2 C3]. In this code C1 is MSB and C3 is LSB.
+    // The four CX bits are stored together in a nible cx and an inverted nible cx_.
+    byte c1  = trailer[7] >> 4;
+    byte c2  = trailer[8] & 0xF;
+    byte c3  = trailer[8] >> 4;
+    byte c1_ = trailer[6] & 0xF;
+    byte c2_ = trailer[6] >> 4;
+    byte c3_ = trailer[7] & 0xF;
+    bool invertedError = (c1 != (~c1_ & 0xF)) || (c2 != (~c2_ & 0xF)) || (c3 != (~c3_ & 0xF));
+    byte g[4];
+    g[0] = ((c1 & 1) << 2) | ((c2 & 1) << 1) | ((c3 & 1) << 0);
+    g[1] = ((c1 & 2) << 1) | ((c2 & 2) << 0) | ((c3 & 2) >> 1);
+    g[2] = ((c1 & 4) << 0) | ((c2 & 4) >> 1) | ((c3 & 4) >> 2);
+    g[3] = ((c1 & 8) >> 1) | ((c2 & 8) >> 2) | ((c3 & 8) >> 3);
+
+    char line[160];
+    for(int8_t blockOffset = blocks - 1; blockOffset >= 0; blockOffset--) {
+        uint16_t blockAddr = firstBlock + blockOffset;
+        char * p = line;
+        // Sector number - only on the trailer line
+        if(blockOffset == blocks - 1) {
+            p += sprintf(p, "%4u   %4u  ", sector, (unsigned)blockAddr);
+        }
+        else {
+            p += sprintf(p, "       %4u  ", (unsigned)blockAddr);
+        }
+        const byte * buffer = _data[blockOffset];
+        if(_status[blockOffset] != MFRC522::STATUS_OK) {
+            _out.write((const uint8_t *)line, p - line);
+            _out.print(F("Not read: "));
+            _out.println(MFRC522::GetStatusCodeName(_status[blockOffset]));
+            continue;
+        }
+        p = printHex(p, buffer, 16, true);
+
+        // Which access group is this block in?
+        byte group;
+        bool firstInGroup;
+        if(blocks == 4) {
+            group = blockOffset;
+            firstInGroup = true;
+        }
+        else {
+            group = blockOffset / 5;
+            firstInGroup = (group == 3) || (group != (blockOffset + 1) / 5);
+        }
+
+        if(accessBits && firstInGroup) {
+            p += sprintf(p, " [ %u %u %u ] ", (g[group] >> 2) & 1, (g[group] >> 1) & 1, (g[group] >> 0) & 1);
+            if(invertedError) {
+                p += sprintf(p, " Inverted access bits did not match! ");
+            }
+        }
+
+        if(accessBits && group != 3 && (g[group] == 1 || g[group] == 6)) {  // Not a sector trailer, a value block
+            uint32_t value = ((uint32_t)buffer[3] << 24) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[1] << 8)
+                             | buffer[0];
+            p += sprintf(p, " Value=0x%lX Adr=0x%X", (unsigned long)value, buffer[12]);
+        }
+        *p++ = '\r';
+        *p++ = '\n';
+        _out.write((const uint8_t *)line, p - line);
+    }
+} // End printSector()
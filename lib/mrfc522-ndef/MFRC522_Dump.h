@@ -0,0 +1,65 @@
+/**
+ * MFRC522_Dump.h - Full card dumps streamed block by block into a sink.
+ *
+ * MFRC522::PICC_DumpMifareClassic() authenticates each sector once with key A and reads its blocks in address
+ * order, MFRC522::PICC_DumpMifareUltralight() reads as many pages per frame as the tag allows. Each block goes to
+ * the sink as soon as it is read, with the status of its read, so nothing but the sink decides what a dump costs
+ * besides the RF. The blocks make up the usual .mfd / .bin image: 16 bytes per MIFARE Classic block, 4 per
+ * Ultralight page, from block 0 on. A block that could not be read is zeros. MIFARE Classic hides key A, the dump
+ * puts the key that opened the sector in its place, like .mfd files have it.
+ *
+ *      File file = LittleFS.open("/card.mfd", "w");
+ *      MFRC522_DumpImage image(file);
+ *      mfrc522.PICC_DumpMifareClassic(mfrc522.uid, mfrc522.PICC_GetType(mfrc522.uid.sak), key, image);
+ *
+ * MFRC522_DumpPrinter prints the text table of PICC_DumpToSerial(), a line per write.
+ */
+#ifndef MFRC522_Dump_h
+#define MFRC522_Dump_h
+
+#include <Arduino.h>
+#include "MFRC522_I2C.h"
+
+class MFRC522_DumpSink
+{
+    public:
+        virtual ~MFRC522_DumpSink() {}
+        // before the first block: the dump has blocks blocks of blockSize bytes
+        virtual void begin(const MFRC522::Uid &, byte, uint16_t, byte) {}
+        // the blockSize bytes of block addr, zeros unless status is STATUS_OK; blocks come in address order
+        virtual void block(uint16_t addr, const byte * data, MFRC522::StatusCode status) = 0;
+        // after the last block
+        virtual void end() {}
+};
+
+// The raw image, to a file, a USB CDC port or anything else that is a Print
+class MFRC522_DumpImage : public MFRC522_DumpSink
+{
+    public:
+        MFRC522_DumpImage(Print & out) : unread(0), _out(out), _blockSize(0) {}
+        void begin(const MFRC522::Uid & uid, byte piccType, uint16_t blocks, byte blockSize);
+        void block(uint16_t addr, const byte * data, MFRC522::StatusCode status);
+
+        uint16_t unread;            // blocks that are zeros in the image because they could not be read
+    private:
+        Print & _out;
+        byte _blockSize;
+};
+
+// The text table: a MIFARE Classic sector with its trailer first and the access bits of its blocks, which is why
+// a sector is held until its trailer comes; an Ultralight page per line.
+class MFRC522_DumpPrinter : public MFRC522_DumpSink
+{
+    public:
+        MFRC522_DumpPrinter(Print & out) : _out(out), _blockSize(16) {}
+        void begin(const MFRC522::Uid & uid, byte piccType, uint16_t blocks, byte blockSize);
+        void block(uint16_t addr, const byte * data, MFRC522::StatusCode status);
+    private:
+        void printSector(uint16_t firstBlock, byte blocks);
+        Print & _out;
+        byte _blockSize;                    // MIFARE Classic blocks until begin() tells otherwise
+        byte _data[16][16];                 // the blocks of the sector so far
+        MFRC522::StatusCode _status[16];
+};
+
+#endif
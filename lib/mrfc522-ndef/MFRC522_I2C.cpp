@@ -8,8 +8,17 @@
 
 #include <Arduino.h>
 #include "MFRC522_I2C.h"
+#include "MFRC522_CRC.h"
+#include "MFRC522_Dump.h"
 #include "MifareUltralight.h"
-#include <Wire.h>
+
+// CRC_A of the frames whose content is known, computed by the compiler. Used in PCD_CRC_SOFTWARE mode.
+template <size_t... I> static constexpr MFRC522_CrcTable readCrcTableOf(MFRC522_Indices<I...>)
+{
+    return {{ MFRC522_CrcA::of(MFRC522::PICC_CMD_MF_READ, I)... }};
+}
+static constexpr MFRC522_CrcTable readCrc = readCrcTableOf(MFRC522_MakeIndices<256>::type());  // READ of block/page N
+static constexpr uint16_t hltaCrc = MFRC522_CrcA::of(MFRC522::PICC_CMD_HLTA, 0);
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for setting up the Arduino
@@ -19,12 +28,21 @@
  * Constructor.
  * Prepares the output pins.
  */
-MFRC522::MFRC522(byte chipAddress
+MFRC522::MFRC522(const MFRC522_Transport & bus, ///< How to reach the registers, eg the I2C address. See MFRC522_Transport.h.
                  //byte resetPowerDownPin    ///< Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low)
-                )
+                 byte irqPin                ///< Arduino pin connected to MFRC522's IRQ output, NO_IRQ_PIN to poll for command completion
+                ) : _bus(bus)
 {
-    _chipAddress = chipAddress;
     // _resetPowerDownPin = resetPowerDownPin;
+    _irqPin = irqPin;
+    _crcMode = PCD_CRC_CALC;
+    _frameCrc = 0;
+    _busError = false;
+    _timeoutMs = 25;
+    uid.size = 0;
+#ifdef INC_FREERTOS_H
+    _irqTask = NULL;
+#endif
 } // End constructor
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -33,90 +51,266 @@ MFRC522::MFRC522(byte chipAddress
 
 /**
  * Writes a byte to the specified register in the MFRC522 chip.
- * The interface is described in the datasheet section 8.1.2.
+ * The interface is described in the datasheet section 8.1.
  */
 void MFRC522::PCD_WriteRegister(byte reg,        ///< The register to write to. One of the PCD_Register enums.
                                 byte value      ///< The value to write.
                                )
 {
-    Wire.beginTransmission(_chipAddress);
-    Wire.write(reg);
-    Wire.write(value);
-    Wire.endTransmission();
+    PCD_Transaction(*this).write(reg, value).commit();
 } // End PCD_WriteRegister()
 
 /**
  * Writes a number of bytes to the specified register in the MFRC522 chip.
- * The interface is described in the datasheet section 8.1.2.
+ * The interface is described in the datasheet section 8.1.
  */
 void MFRC522::PCD_WriteRegister(byte reg,        ///< The register to write to. One of the PCD_Register enums.
                                 byte count,     ///< The number of bytes to write to the register
                                 byte * values   ///< The values to write. Byte array.
                                )
 {
-    Wire.beginTransmission(_chipAddress);
-    Wire.write(reg);
-    for(byte index = 0; index < count; index++) {
-        Wire.write(values[index]);
-    }
-    Wire.endTransmission();
+    PCD_Transaction(*this).write(reg, count, values).commit();
 } // End PCD_WriteRegister()
 
 /**
  * Reads a byte from the specified register in the MFRC522 chip.
- * The interface is described in the datasheet section 8.1.2.
+ * The interface is described in the datasheet section 8.1.
  */
 byte MFRC522::PCD_ReadRegister(byte reg  ///< The register to read from. One of the PCD_Register enums.
                               )
 {
-    byte value;
-    //digitalWrite(_chipSelectPin, LOW);            // Select slave
-    Wire.beginTransmission(_chipAddress);
-    Wire.write(reg);
-    Wire.endTransmission();
-
-    Wire.requestFrom(_chipAddress, 1);
-    value = Wire.read();
+    byte value = 0;
+    PCD_Transaction(*this).read(reg, &value).commit();
     return value;
 } // End PCD_ReadRegister()
 
 /**
  * Reads a number of bytes from the specified register in the MFRC522 chip.
- * The interface is described in the datasheet section 8.1.2.
+ * The interface is described in the datasheet section 8.1.
  */
 void MFRC522::PCD_ReadRegister(byte reg,         ///< The register to read from. One of the PCD_Register enums.
                                byte count,     ///< The number of bytes to read
                                byte * values,  ///< Byte array to store the values in.
                                byte rxAlign    ///< Only bit positions rxAlign..7 in values[0] are updated.
                               )
+{
+    PCD_Transaction(*this).read(reg, count, values, rxAlign).commit();
+} // End PCD_ReadRegister()
+
+/**
+ * Merges a byte read from the FIFO into *destination, updating only bit positions rxAlign..7.
+ */
+void MFRC522::PCD_ApplyRxAlign(byte * destination,  ///< The byte to update.
+                               byte value,          ///< The byte read from the MFRC522.
+                               byte rxAlign         ///< Only bit positions rxAlign..7 in *destination are updated.
+                              )
+{
+    // Create bit mask for bit positions rxAlign..7
+    byte mask = 0;
+    for(byte i = rxAlign; i <= 7; i++) {
+        mask |= (1 << i);
+    }
+    // Apply mask to both current value of *destination and the new data in value.
+    *destination = (*destination & ~mask) | (value & mask);
+} // End PCD_ApplyRxAlign()
+
+/**
+ * Queues a single byte register write.
+ */
+MFRC522::PCD_Transaction & MFRC522::PCD_Transaction::write(byte reg,    ///< The register to write to. One of the PCD_Register enums.
+                                                           byte value   ///< The value to write.
+                                                          )
+{
+    MFRC522_RegisterAccess & access = append();
+    access.reg = reg;
+    access.count = 1;
+    access.isRead = false;
+    access.value = value;
+    access.source = NULL;
+    return *this;
+} // End PCD_Transaction::write()
+
+/**
+ * Queues a multi-byte register write, eg filling the FIFO. The values are sent as one burst.
+ */
+MFRC522::PCD_Transaction & MFRC522::PCD_Transaction::write(byte reg,            ///< The register to write to. One of the PCD_Register enums.
+                                                           byte count,          ///< The number of bytes to write to the register
+                                                           const byte * values  ///< The values to write. Must stay valid until commit().
+                                                          )
 {
     if(count == 0) {
-        return;
+        return *this;
     }
-    byte address = reg;
-    byte index = 0;                         // Index in values array.
-    Wire.beginTransmission(_chipAddress);
-    Wire.write(address);
-    Wire.endTransmission();
-    Wire.requestFrom(_chipAddress, count);
-    while(Wire.available()) {
-        if(index == 0 && rxAlign) {         // Only update bit positions rxAlign..7 in values[0]
-            // Create bit mask for bit positions rxAlign..7
-            byte mask = 0;
-            for(byte i = rxAlign; i <= 7; i++) {
-                mask |= (1 << i);
-            }
-            // Read value and tell that we want to read the same address again.
-            byte value = Wire.read();
-            // Apply mask to both current value of values[0] and the new data in value.
-            values[0] = (values[index] & ~mask) | (value & mask);
+    MFRC522_RegisterAccess & access = append();
+    access.reg = reg;
+    access.count = count;
+    access.isRead = false;
+    access.value = values[0];   // transports send single bytes from value
+    access.source = values;
+    return *this;
+} // End PCD_Transaction::write()
+
+/**
+ * Queues a single byte register read. *value is set by commit().
+ */
+MFRC522::PCD_Transaction & MFRC522::PCD_Transaction::read(byte reg,     ///< The register to read from. One of the PCD_Register enums.
+                                                          byte * value  ///< Where to store the value.
+                                                         )
+{
+    return read(reg, 1, value, 0);
+} // End PCD_Transaction::read()
+
+/**
+ * Queues a multi-byte register read, eg draining the FIFO. values[] is set by commit().
+ */
+MFRC522::PCD_Transaction & MFRC522::PCD_Transaction::read(byte reg,         ///< The register to read from. One of the PCD_Register enums.
+                                                          byte count,       ///< The number of bytes to read
+                                                          byte * values,    ///< Byte array to store the values in.
+                                                          byte rxAlign      ///< Only bit positions rxAlign..7 in values[0] are updated.
+                                                         )
+{
+    if(count == 0) {
+        return *this;
+    }
+    MFRC522_RegisterAccess & access = append();
+    access.reg = reg;
+    access.count = count;
+    access.rxAlign = rxAlign;
+    access.isRead = true;
+    access.destination = values;
+    return *this;
+} // End PCD_Transaction::read()
+
+/**
+ * Sends all queued accesses to the MFRC522.
+ */
+void MFRC522::PCD_Transaction::commit()
+{
+    if(_count) {
+        _pcd.PCD_ExecuteTransaction(_accesses, _count);
+        _count = 0;
+    }
+} // End PCD_Transaction::commit()
+
+/**
+ * Sends whatever is still queued.
+ */
+MFRC522::PCD_Transaction::~PCD_Transaction()
+{
+    commit();
+} // End PCD_Transaction destructor
+
+/**
+ * Returns the next free access slot. A full queue is sent first.
+ */
+MFRC522_RegisterAccess & MFRC522::PCD_Transaction::append()
+{
+    if(_count == MAX_ACCESSES) {
+        commit();
+    }
+    MFRC522_RegisterAccess & access = _accesses[_count++];
+    access.rxAlign = 0;
+    access.destination = NULL;
+    return access;
+} // End PCD_Transaction::append()
+
+/**
+ * Executes a list of register accesses on the transport and applies rxAlign to the data read.
+ * A bus error is kept in _busError for the command in progress to report.
+ */
+void MFRC522::PCD_ExecuteTransaction(MFRC522_RegisterAccess * accesses,    ///< The accesses to perform, in order.
+                                     byte count                            ///< The number of accesses.
+                                    )
+{
+    for(byte i = 0; i < count; i++) {
+        if(accesses[i].isRead && accesses[i].rxAlign) {
+            accesses[i].value = accesses[i].destination[0];   // Keep the bits below rxAlign
         }
-        else { // Normal case
-            values[index] = Wire.read();
+    }
+    if(!_bus.execute(accesses, count)) {
+        _busError = true;
+    }
+    for(byte i = 0; i < count; i++) {
+        MFRC522_RegisterAccess & access = accesses[i];
+        if(access.isRead && access.rxAlign) {
+            byte received = access.destination[0];
+            access.destination[0] = access.value;
+            PCD_ApplyRxAlign(&access.destination[0], received, access.rxAlign);
         }
-        index++;
     }
-} // End PCD_ReadRegister()
+} // End PCD_ExecuteTransaction()
+
+/**
+ * Queues the interrupt enable bits for the next command on transaction, if the IRQ pin is used.
+ * The IRQ pin goes low as soon as one of the bits in irqMask is set in the matching request register.
+ * The request bits must already have been cleared.
+ */
+void MFRC522::PCD_ArmIrq(PCD_Transaction & transaction,  ///< The transaction that starts the command.
+                         byte enableReg,                ///< ComIEnReg or DivIEnReg.
+                         byte irqMask                   ///< The interrupt request bits to route to the IRQ pin.
+                        )
+{
+#ifdef INC_FREERTOS_H
+    if(_irqPin == NO_IRQ_PIN) {
+        return;
+    }
+    _irqTask = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);                        // Drop a notification left over from an earlier command
+    transaction.write(enableReg, 0x80 | irqMask);       // ComIEnReg: IRqInv=1, DivIEnReg: IRQPushPull=1
+#else
+    (void)transaction;
+    (void)enableReg;
+    (void)irqMask;
+#endif
+} // End PCD_ArmIrq()
+
+/**
+ * Waits until one of the bits in irqMask is set in irqReg.
+ * With an IRQ pin the calling task blocks on a notification from the pin interrupt, which leaves the bus and
+ * the CPU to others. Otherwise, or if FreeRTOS is not available, irqReg is polled.
+ *
+ * @return The last value read from irqReg. None of the irqMask bits are set if the wait timed out.
+ */
+byte MFRC522::PCD_WaitForIrq(byte irqReg,       ///< ComIrqReg or DivIrqReg.
+                             byte irqMask,      ///< The bits to wait for. Must have been armed with PCD_ArmIrq().
+                             word timeoutMs     ///< Give up after this time.
+                            )
+{
+    byte n;
+#ifdef INC_FREERTOS_H
+    if(_irqPin != NO_IRQ_PIN) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs) + 1);
+        n = PCD_ReadRegister(irqReg);   // Also catches an edge that was missed
+        _irqTask = NULL;
+        return n;
+    }
+#endif
+    // The time a poll takes depends on the transport, so the loop is bounded by time rather than a poll count.
+    unsigned long start = millis();
+    do {
+        n = PCD_ReadRegister(irqReg);
+        if(n & irqMask) {
+            break;
+        }
+    } while(millis() - start <= timeoutMs);
+    return n;
+} // End PCD_WaitForIrq()
+
+#ifdef INC_FREERTOS_H
+/**
+ * IRQ pin interrupt handler, wakes the task waiting in PCD_WaitForIrq().
+ */
+void IRAM_ATTR MFRC522::PCD_IrqHandler(void * arg)
+{
+    MFRC522 * pcd = (MFRC522 *)arg;
+    TaskHandle_t task = pcd->_irqTask;
+    BaseType_t woken = pdFALSE;
+    if(task) {
+        vTaskNotifyGiveFromISR(task, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+} // End PCD_IrqHandler()
+#endif
 
 /**
  * Sets the bits given in mask in register reg.
@@ -153,31 +347,34 @@ MFRC522::StatusCode MFRC522::PCD_CalculateCRC(byte *
                                               byte * result   ///< Out: Pointer to result buffer. Result is written to result[0..1], low byte first.
                                              )
 {
-    PCD_WriteRegister(CommandReg, PCD_Idle);        // Stop any active command.
-    PCD_WriteRegister(DivIrqReg, 0x04);             // Clear the CRCIRq interrupt request bit
-    PCD_SetRegisterBitMask(FIFOLevelReg, 0x80);     // FlushBuffer = 1, FIFO initialization
-    PCD_WriteRegister(FIFODataReg, length, data);   // Write data to the FIFO
-    PCD_WriteRegister(CommandReg, PCD_CalcCRC);     // Start the calculation
-
-    // Wait for the CRC calculation to complete. Each iteration of the while-loop takes 17.73�s.
-    word i = 5000;
-    byte n;
-    while(1) {
-        n = PCD_ReadRegister(
-                DivIrqReg);    // DivIrqReg[7..0] bits are: Set2 reserved reserved MfinActIRq reserved CRCIRq reserved reserved
-        if(n & 0x04) {                      // CRCIRq bit set - calculation done
-            break;
-        }
-        if(--i == 0) {                      // The emergency break. We will eventually terminate on this one after 89ms. Communication with the MFRC522 might be down.
-            return STATUS_TIMEOUT;
-        }
-    }
-    PCD_WriteRegister(CommandReg, PCD_Idle);        // Stop calculating CRC for new content in the FIFO.
-
-    // Transfer the result from the registers to the result buffer
-    result[0] = PCD_ReadRegister(CRCResultRegL);
-    result[1] = PCD_ReadRegister(CRCResultRegH);
-    return STATUS_OK;
+    _busError = false;
+    PCD_Transaction prologue(*this);
+    prologue.write(CommandReg, PCD_Idle)            // Stop any active command.
+    .write(DivIrqReg, 0x04);                        // Clear the CRCIRq interrupt request bit
+    PCD_ArmIrq(prologue, DivIEnReg, 0x04);          // Route CRCIRq to the IRQ pin
+    prologue.write(FIFOLevelReg, 0x80)              // FlushBuffer = 1, FIFO initialization. The other bits are read-only.
+    .write(FIFODataReg, length, data)               // Write data to the FIFO
+    .write(CommandReg, PCD_CalcCRC)                 // Start the calculation
+    .commit();
+
+    // Wait for the CRC calculation to complete.
+    // The emergency break: we will eventually terminate after 89ms. Communication with the MFRC522 might be down.
+    byte n = PCD_WaitForIrq(DivIrqReg, 0x04,
+                            89);    // DivIrqReg[7..0] bits are: Set2 reserved reserved MfinActIRq reserved CRCIRq reserved reserved
+
+    PCD_Transaction epilogue(*this);
+    epilogue.write(CommandReg, PCD_Idle);           // Stop calculating CRC for new content in the FIFO.
+    if(_irqPin != NO_IRQ_PIN) {
+        epilogue.write(DivIEnReg, 0x80);            // Release the IRQ pin
+    }
+    if(_busError || !(n & 0x04)) {                  // CRCIRq bit not set - calculation did not finish
+        epilogue.commit();
+        return _busError ? STATUS_ERROR : STATUS_TIMEOUT;
+    }
+    epilogue.read(CRCResultRegL, &result[0])        // Transfer the result from the registers to the result buffer
+    .read(CRCResultRegH, &result[1])
+    .commit();
+    return _busError ? STATUS_ERROR : STATUS_OK;
 } // End PCD_CalculateCRC()
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -190,6 +387,7 @@ MFRC522::StatusCode MFRC522::PCD_CalculateCRC(byte *
 void MFRC522::PCD_Init()
 {
     // Set the chipSelectPin as digital output, do not select the slave yet
+    _bus.begin();
 
     // Set the resetPowerDownPin as digital output, do not reset or power down.
     // pinMode(_resetPowerDownPin, OUTPUT);
@@ -202,21 +400,37 @@ void MFRC522::PCD_Init()
     // else { // Perform a soft reset
     PCD_Reset();
     // }
+    _timeoutMs = 25;
 
     // When communicating with a PICC we need a timeout if something goes wrong.
     // f_timer = 13.56 MHz / (2*TPreScaler+1) where TPreScaler = [TPrescaler_Hi:TPrescaler_Lo].
     // TPrescaler_Hi are the four low bits in TModeReg. TPrescaler_Lo is TPrescalerReg.
-    PCD_WriteRegister(TModeReg,
-                      0x80);          // TAuto=1; timer starts automatically at the end of the transmission in all communication modes at all speeds
-    PCD_WriteRegister(TPrescalerReg,
-                      0xA9);     // TPreScaler = TModeReg[3..0]:TPrescalerReg, ie 0x0A9 = 169 => f_timer=40kHz, ie a timer period of 25�s.
-    PCD_WriteRegister(TReloadRegH, 0x03);       // Reload timer with 0x3E8 = 1000, ie 25ms before timeout.
-    PCD_WriteRegister(TReloadRegL, 0xE8);
-
-    PCD_WriteRegister(TxASKReg,
-                      0x40);      // Default 0x00. Force a 100 % ASK modulation independent of the ModGsPReg register setting
-    PCD_WriteRegister(ModeReg,
-                      0x3D);       // Default 0x3F. Set the preset value for the CRC coprocessor for the CalcCRC command to 0x6363 (ISO 14443-3 part 6.2.4)
+    PCD_Transaction(*this)
+    .write(TModeReg,
+           0x80)          // TAuto=1; timer starts automatically at the end of the transmission in all communication modes at all speeds
+    .write(TPrescalerReg,
+           0xA9)     // TPreScaler = TModeReg[3..0]:TPrescalerReg, ie 0x0A9 = 169 => f_timer=40kHz, ie a timer period of 25�s.
+    .write(TReloadRegH, 0x03)       // Reload timer with 0x3E8 = 1000, ie 25ms before timeout.
+    .write(TReloadRegL, 0xE8)
+    .write(TxASKReg,
+           0x40)      // Default 0x00. Force a 100 % ASK modulation independent of the ModGsPReg register setting
+    .write(ModeReg,
+           0x3D)       // Default 0x3F. Set the preset value for the CRC coprocessor for the CalcCRC command to 0x6363 (ISO 14443-3 part 6.2.4)
+    .commit();
+
+#ifdef INC_FREERTOS_H
+    // The IRQ pin is active low (IRqInv=1) and driven push-pull. It stays released until a command arms it.
+    if(_irqPin != NO_IRQ_PIN) {
+        PCD_Transaction(*this)
+        .write(ComIEnReg, 0x80)
+        .write(DivIEnReg, 0x80)
+        .commit();
+        pinMode(_irqPin, INPUT_PULLUP);
+        attachInterruptArg(digitalPinToInterrupt(_irqPin), PCD_IrqHandler, this, FALLING);
+    }
+#else
+    _irqPin = NO_IRQ_PIN;   // No task to block without FreeRTOS, poll
+#endif
     PCD_AntennaOn();                        // Enable the antenna driver pins TX1 and TX2 (they were disabled by the reset)
 } // End PCD_Init()
 
@@ -234,6 +448,7 @@ void MFRC522::PCD_Reset()
     while(PCD_ReadRegister(CommandReg) & (1 << 4)) {
         // PCD still restarting - unlikely after waiting 50ms, but better safe than sorry.
     }
+    _frameCrc = 0;      // TxModeReg and RxModeReg are back to 0x00
 } // End PCD_Reset()
 
 /**
@@ -275,9 +490,10 @@ byte MFRC522::PCD_GetAntennaGain()
  */
 void MFRC522::PCD_SetAntennaGain(byte mask)
 {
-    if(PCD_GetAntennaGain() != mask) {                      // only bother if there is a change
-        PCD_ClearRegisterBitMask(RFCfgReg, (0x07 << 4));    // clear needed to allow 000 pattern
-        PCD_SetRegisterBitMask(RFCfgReg, mask & (0x07 << 4)); // only set RxGain[2:0] bits
+    byte value = PCD_ReadRegister(RFCfgReg);
+    if((value & (0x07 << 4)) != mask) {                     // only bother if there is a change
+        value &= ~(0x07 << 4);                              // clear needed to allow 000 pattern
+        PCD_WriteRegister(RFCfgReg, value | (mask & (0x07 << 4))); // only set RxGain[2:0] bits
     }
 } // End PCD_SetAntennaGain()
 
@@ -295,18 +511,17 @@ bool MFRC522::PCD_PerformSelfTest()
 
     // 2. Clear the internal buffer by writing 25 bytes of 00h
     byte ZEROES[25] = {0x00};
-    PCD_SetRegisterBitMask(FIFOLevelReg, 0x80); // flush the FIFO buffer
-    PCD_WriteRegister(FIFODataReg, 25, ZEROES); // write 25 bytes of 00h to FIFO
-    PCD_WriteRegister(CommandReg, PCD_Mem);     // transfer to internal buffer
-
+    PCD_Transaction(*this)
+    .write(FIFOLevelReg, 0x80)          // flush the FIFO buffer
+    .write(FIFODataReg, 25, ZEROES)     // write 25 bytes of 00h to FIFO
+    .write(CommandReg, PCD_Mem)         // transfer to internal buffer
     // 3. Enable self-test
-    PCD_WriteRegister(AutoTestReg, 0x09);
-
+    .write(AutoTestReg, 0x09)
     // 4. Write 00h to FIFO buffer
-    PCD_WriteRegister(FIFODataReg, 0x00);
-
+    .write(FIFODataReg, 0x00)
     // 5. Start self-test by issuing the CalcCRC command
-    PCD_WriteRegister(CommandReg, PCD_CalcCRC);
+    .write(CommandReg, PCD_CalcCRC)
+    .commit();
 
     // 6. Wait for self-test to complete
     word i;
@@ -318,18 +533,18 @@ bool MFRC522::PCD_PerformSelfTest()
             break;
         }
     }
-    PCD_WriteRegister(CommandReg, PCD_Idle);        // Stop calculating CRC for new content in the FIFO.
-
-    // 7. Read out resulting 64 bytes from the FIFO buffer.
     byte result[64];
-    PCD_ReadRegister(FIFODataReg, 64, result, 0);
-
+    byte version;
+    PCD_Transaction(*this)
+    .write(CommandReg, PCD_Idle)        // Stop calculating CRC for new content in the FIFO.
+    // 7. Read out resulting 64 bytes from the FIFO buffer.
+    .read(FIFODataReg, 64, result, 0)
     // Auto self-test done
     // Reset AutoTestReg register to be 0 again. Required for normal operation.
-    PCD_WriteRegister(AutoTestReg, 0x00);
-
+    .write(AutoTestReg, 0x00)
     // Determine firmware version (see section 9.3.4.8 in spec)
-    byte version = PCD_ReadRegister(VersionReg);
+    .read(VersionReg, &version)
+    .commit();
 
     // Pick the appropriate reference values
     const byte * reference;
@@ -361,6 +576,100 @@ bool MFRC522::PCD_PerformSelfTest()
     return true;
 } // End PCD_PerformSelfTest()
 
+/**
+ * Selects how CRC_A is added to frames sent to the PICC and checked on frames received.
+ *
+ * PCD_CRC_CALC (the default) runs the CalcCRC command for every CRC_A, ie a FIFO fill, a wait for completion
+ * and reading the result for every frame sent and every frame checked.
+ * PCD_CRC_FRAMED sets TxCRCEn/RxCRCEn for the frames that carry a CRC_A: the chip appends it while sending and
+ * checks and removes it while receiving. MIFARE_Read() then returns 16 bytes instead of 16 + CRC_A.
+ * PCD_CRC_SOFTWARE computes and checks CRC_A on the MCU with a table lookup per byte, so no bus traffic at all.
+ * HLTA and READ frames are sent with a CRC_A computed at compile time.
+ */
+void MFRC522::PCD_SetCrcMode(PCD_CrcMode mode  ///< PCD_CRC_CALC, PCD_CRC_FRAMED or PCD_CRC_SOFTWARE
+                            )
+{
+    _crcMode = mode;
+} // End PCD_SetCrcMode()
+
+/**
+ * Returns the CRC mode set with PCD_SetCrcMode().
+ */
+MFRC522::PCD_CrcMode MFRC522::PCD_GetCrcMode()
+{
+    return _crcMode;
+} // End PCD_GetCrcMode()
+
+/**
+ * Sets how long the PCD waits for a PICC to answer, from the end of the frame sent, in steps of the 25 us timer
+ * period PCD_Init() sets up. PCD_Init() sets 25 ms. A PICC that does not answer, like a MIFARE Classic given a wrong
+ * key, costs the whole timeout: operations that expect that a lot, eg a key search, use a shorter one.
+ * PCD_CommunicateWithPICC() waits as long for the command, plus a margin for the frames.
+ */
+void MFRC522::PCD_SetTimeout(uint32_t timeoutUs    ///< The timeout in us, 25 to 1638375.
+                            )
+{
+    uint32_t reload = timeoutUs / 25;
+    reload = reload < 1 ? 1 : reload > 0xFFFF ? 0xFFFF : reload;
+    _timeoutMs = (reload * 25 + 999) / 1000;
+    PCD_Transaction(*this)
+    .write(TReloadRegH, reload >> 8)
+    .write(TReloadRegL, reload & 0xFF)
+    .commit();
+} // End PCD_SetTimeout()
+
+/**
+ * Reads back the timeout PCD_SetTimeout() or PCD_Init() set, to restore it after a change.
+ *
+ * @return The timeout in us.
+ */
+uint32_t MFRC522::PCD_GetTimeout()
+{
+    byte high, low;
+    PCD_Transaction(*this)
+    .read(TReloadRegH, &high)
+    .read(TReloadRegL, &low)
+    .commit();
+    return (((uint32_t)high << 8) | low) * 25;
+} // End PCD_GetTimeout()
+
+/**
+ * Queues the TxModeReg/RxModeReg writes that switch the chip's CRC_A generation and checking, if they change.
+ * Only TxCRCEn/RxCRCEn are set; the other bits keep their reset value (106 kBd, no inversion).
+ */
+void MFRC522::PCD_SetFrameCrc(PCD_Transaction & transaction, ///< The transaction to add the writes to.
+                              bool txCRC,                    ///< Append CRC_A to the frame sent
+                              bool rxCRC                     ///< Check and remove CRC_A from the frame received
+                             )
+{
+    if(txCRC != (bool)(_frameCrc & 0x01)) {
+        transaction.write(TxModeReg, txCRC ? 0x80 : 0x00);
+    }
+    if(rxCRC != (bool)(_frameCrc & 0x02)) {
+        transaction.write(RxModeReg, rxCRC ? 0x80 : 0x00);
+    }
+    _frameCrc = (txCRC ? 0x01 : 0) | (rxCRC ? 0x02 : 0);
+} // End PCD_SetFrameCrc()
+
+/**
+ * Calculates a CRC_A with the CRC coprocessor, or on the MCU in PCD_CRC_SOFTWARE mode.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_FrameCRC(byte * data,     ///< In: The bytes to calculate the CRC_A of.
+                                          byte length,     ///< In: The number of bytes.
+                                          byte * result    ///< Out: The CRC_A, low byte first, in result[0..1].
+                                         )
+{
+    if(_crcMode != PCD_CRC_SOFTWARE) {
+        return PCD_CalculateCRC(data, length, result);
+    }
+    uint16_t crc = MFRC522_CrcA::compute(data, length);
+    result[0] = crc & 0xFF;
+    result[1] = crc >> 8;
+    return STATUS_OK;
+} // End PCD_FrameCRC()
+
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for communicating with PICCs
 /////////////////////////////////////////////////////////////////////////////////////
@@ -377,12 +686,13 @@ MFRC522::StatusCode MFRC522::PCD_TransceiveData(byte * sendData,     ///< Pointe
                                                 byte * backLen,     ///< In: Max number of bytes to write to *backData. Out: The number of bytes returned.
                                                 byte * validBits,   ///< In/Out: The number of valid bits in the last byte. 0 for 8 valid bits. Default NULL.
                                                 byte rxAlign,       ///< In: Defines the bit position in backData[0] for the first bit received. Default 0.
-                                                bool checkCRC       ///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+                                                bool checkCRC,      ///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+                                                bool sendCRC        ///< In: True => CRC_A is appended to sendData. Default false.
                                                )
 {
     byte waitIRq = 0x30;        // RxIRq and IdleIRq
     return PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, sendData, sendLen, backData, backLen, validBits, rxAlign,
-                                   checkCRC);
+                                   checkCRC, sendCRC);
 } // End PCD_TransceiveData()
 
 /**
@@ -400,62 +710,93 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(byte
                                                      byte * backLen,     ///< In: Max number of bytes to write to *backData. Out: The number of bytes returned.
                                                      byte * validBits,   ///< In/Out: The number of valid bits in the last byte. 0 for 8 valid bits.
                                                      byte rxAlign,       ///< In: Defines the bit position in backData[0] for the first bit received. Default 0.
-                                                     bool checkCRC       ///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+                                                     bool checkCRC,      ///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+                                                     bool sendCRC        ///< In: True => CRC_A is appended to sendData. Default false.
                                                     )
 {
     byte n, _validBits;
     MFRC522::StatusCode status;
-    unsigned int i;
+    bool framedCRC = _crcMode == PCD_CRC_FRAMED;
 
     // Prepare values for BitFramingReg
     byte txLastBits = validBits ? *validBits : 0;
     byte bitFraming = (rxAlign << 4) + txLastBits;      // RxAlign = BitFramingReg[6..4]. TxLastBits = BitFramingReg[2..0]
 
-    PCD_WriteRegister(CommandReg, PCD_Idle);            // Stop any active command.
-    PCD_WriteRegister(ComIrqReg, 0x7F);                 // Clear all seven interrupt request bits
-    PCD_SetRegisterBitMask(FIFOLevelReg, 0x80);         // FlushBuffer = 1, FIFO initialization
-    PCD_WriteRegister(FIFODataReg, sendLen, sendData);  // Write sendData to the FIFO
-    PCD_WriteRegister(BitFramingReg, bitFraming);       // Bit adjustments
-    PCD_WriteRegister(CommandReg, command);             // Execute the command
+    // Without the chip appending it, calculate the CRC_A of the frame first
+    byte crc[2];
+    if(sendCRC && !framedCRC) {
+        status = PCD_FrameCRC(sendData, sendLen, crc);
+        if(status != STATUS_OK) {
+            return status;
+        }
+    }
+
+    _busError = false;
+    PCD_Transaction prologue(*this);
+    prologue.write(CommandReg, PCD_Idle)                // Stop any active command.
+    .write(ComIrqReg, 0x7F);                            // Clear all seven interrupt request bits
+    PCD_ArmIrq(prologue, ComIEnReg, waitIRq | 0x01);    // Route the completion and timer interrupts to the IRQ pin
+    PCD_SetFrameCrc(prologue, sendCRC && framedCRC, checkCRC && framedCRC);
+    prologue.write(FIFOLevelReg, 0x80)                  // FlushBuffer = 1, FIFO initialization. The other bits are read-only.
+    .write(FIFODataReg, sendLen, sendData);             // Write sendData to the FIFO
+    if(sendCRC && !framedCRC) {
+        prologue.write(FIFODataReg, 2, crc);            // followed by its CRC_A
+    }
+    prologue.write(BitFramingReg, bitFraming)           // Bit adjustments
+    .write(CommandReg, command);                        // Execute the command
     if(command == PCD_Transceive) {
-        PCD_SetRegisterBitMask(BitFramingReg, 0x80);    // StartSend=1, transmission of data starts
+        prologue.write(BitFramingReg, bitFraming | 0x80);   // StartSend=1, transmission of data starts
     }
+    prologue.commit();
 
     // Wait for the command to complete.
     // In PCD_Init() we set the TAuto flag in TModeReg. This means the timer automatically starts when the PCD stops transmitting.
-    // Each iteration of the do-while-loop takes 17.86�s.
-    i = 2000;
-    while(1) {
-        n = PCD_ReadRegister(
-                ComIrqReg);    // ComIrqReg[7..0] bits are: Set1 TxIRq RxIRq IdleIRq HiAlertIRq LoAlertIRq ErrIRq TimerIRq
-        if(n & waitIRq) {                   // One of the interrupts that signal success has been set.
-            break;
-        }
-        if(n & 0x01) {                      // Timer interrupt - nothing received in 25ms
-            return STATUS_TIMEOUT;
-        }
-        if(--i == 0) {                      // The emergency break. If all other condions fail we will eventually terminate on this one after 35.7ms. Communication with the MFRC522 might be down.
-            return STATUS_TIMEOUT;
-        }
+    // The emergency break: if all other condions fail we will eventually terminate 11ms after the timer would have,
+    // 36ms with the timeout of PCD_Init(). The margin covers the frames, the timer only starts at the end of the one
+    // sent. Communication with the MFRC522 might be down.
+    // ComIrqReg[7..0] bits are: Set1 TxIRq RxIRq IdleIRq HiAlertIRq LoAlertIRq ErrIRq TimerIRq
+    n = PCD_WaitForIrq(ComIrqReg, waitIRq | 0x01, _timeoutMs + 11);
+    PCD_Transaction epilogue(*this);
+    if(_irqPin != NO_IRQ_PIN) {
+        epilogue.write(ComIEnReg, 0x80);            // Release the IRQ pin
+    }
+    if(_busError) {                                 // The MFRC522 did not get the command, or n is not its answer
+        epilogue.commit();
+        return STATUS_ERROR;
+    }
+    if(!(n & waitIRq)) {                            // Timer interrupt - no answer in time, or the emergency break
+        epilogue.commit();
+        return STATUS_TIMEOUT;
     }
 
-    // Stop now if any errors except collisions were detected.
-    byte errorRegValue = PCD_ReadRegister(
-                             ErrorReg); // ErrorReg[7..0] bits are: WrErr TempErr reserved BufferOvfl CollErr CRCErr ParityErr ProtocolErr
-    if(errorRegValue & 0x13) {   // BufferOvfl ParityErr ProtocolErr
+    // ErrorReg[7..0] bits are: WrErr TempErr reserved BufferOvfl CollErr CRCErr ParityErr ProtocolErr
+    // Fetch the number of bytes in the FIFO in the same transaction, in case the caller wants data back.
+    byte errorRegValue;
+    epilogue.read(ErrorReg, &errorRegValue);
+    if(backData && backLen) {
+        epilogue.read(FIFOLevelReg, &n);
+    }
+    epilogue.commit();
+
+    // Stop now if any errors except collisions were detected, or ErrorReg could not be read.
+    if(_busError || (errorRegValue & 0x13)) {   // BufferOvfl ParityErr ProtocolErr
         return STATUS_ERROR;
     }
 
     // If the caller wants data back, get it from the MFRC522.
     if(backData && backLen) {
-        n = PCD_ReadRegister(FIFOLevelReg);         // Number of bytes in the FIFO
         if(n > *backLen) {
             return STATUS_NO_ROOM;
         }
         *backLen = n;                                           // Number of bytes returned
-        PCD_ReadRegister(FIFODataReg, n, backData, rxAlign);    // Get received data from FIFO
-        _validBits = PCD_ReadRegister(ControlReg) &
-                     0x07;       // RxLastBits[2:0] indicates the number of valid bits in the last received byte. If this value is 000b, the whole byte is valid.
+        PCD_Transaction(*this)
+        .read(FIFODataReg, n, backData, rxAlign)                // Get received data from FIFO
+        .read(ControlReg, &_validBits)
+        .commit();
+        if(_busError) {
+            return STATUS_ERROR;
+        }
+        _validBits &= 0x07;     // RxLastBits[2:0] indicates the number of valid bits in the last received byte. If this value is 000b, the whole byte is valid.
         if(validBits) {
             *validBits = _validBits;
         }
@@ -472,13 +813,17 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(byte
         if(*backLen == 1 && _validBits == 4) {
             return STATUS_MIFARE_NACK;
         }
+        // The chip checked it and removed it from the FIFO
+        if(framedCRC) {
+            return (errorRegValue & 0x04) ? STATUS_CRC_WRONG : STATUS_OK;   // CRCErr
+        }
         // We need at least the CRC_A value and all 8 bits of the last byte must be received.
         if(*backLen < 2 || _validBits != 0) {
             return STATUS_CRC_WRONG;
         }
         // Verify CRC_A - do our own calculation and store the control in controlBuffer.
         byte controlBuffer[2];
-        status = PCD_CalculateCRC(&backData[0], *backLen - 2, &controlBuffer[0]);
+        status = PCD_FrameCRC(&backData[0], *backLen - 2, &controlBuffer[0]);
         if(status != STATUS_OK) {
             return status;
         }
@@ -679,13 +1024,8 @@ MFRC522::StatusCode MFRC522::PICC_Select(Uid *
                 buffer[1] = 0x70; // NVB - Number of Valid Bits: Seven whole bytes
                 // Calculate BCC - Block Check Character
                 buffer[6] = buffer[2] ^ buffer[3] ^ buffer[4] ^ buffer[5];
-                // Calculate CRC_A
-                result = PCD_CalculateCRC(buffer, 7, &buffer[7]);
-                if(result != STATUS_OK) {
-                    return result;
-                }
                 txLastBits      = 0; // 0 => All 8 bits are valid.
-                bufferUsed      = 9;
+                bufferUsed      = 7; // CRC_A is added by PCD_TransceiveData()
                 // Store response in the last 3 bytes of buffer (BCC and CRC_A - not needed after tx)
                 responseBuffer  = &buffer[6];
                 responseLength  = 3;
@@ -702,13 +1042,14 @@ MFRC522::StatusCode MFRC522::PICC_Select(Uid *
                 responseLength  = sizeof(buffer) - index;
             }
 
-            // Set bit adjustments
+            // Set bit adjustments. PCD_CommunicateWithPICC() writes them to BitFramingReg along with the frame.
             rxAlign = txLastBits;                                           // Having a seperate variable is overkill. But it makes the next line easier to read.
-            PCD_WriteRegister(BitFramingReg, (rxAlign << 4) +
-                              txLastBits);  // RxAlign = BitFramingReg[6..4]. TxLastBits = BitFramingReg[2..0]
 
             // Transmit the buffer and receive the response.
-            result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign);
+            // SELECT and SAK carry a CRC_A, ANTICOLLISION frames do not.
+            bool select = currentLevelKnownBits >= 32;
+            result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign, select,
+                                        select);
             if(result == STATUS_COLLISION) {  // More than one PICC in the field => collision.
                 regval = PCD_ReadRegister(CollReg); // CollReg[7..0] bits are: ValuesAfterColl reserved CollPosNotValid CollPos[4:0]
                 if(regval & 0x20) {  // CollPosNotValid
@@ -718,13 +1059,16 @@ MFRC522::StatusCode MFRC522::PICC_Select(Uid *
                 if(collisionPos == 0) {
                     collisionPos = 32;
                 }
-                if(collisionPos <= currentLevelKnownBits) {  // No progress - should not happen
+                // CollPos counts from the first bit of the received frame, which starts rxAlign bits into the byte
+                // holding the last bits sent. Make it a position in the UID bits of this Cascade Level.
+                collisionPos += currentLevelKnownBits - rxAlign;
+                if(collisionPos <= currentLevelKnownBits || collisionPos > 32) {  // No progress - should not happen
                     return STATUS_INTERNAL_ERROR;
                 }
                 // Choose the PICC with the bit set.
                 currentLevelKnownBits = collisionPos;
                 count           = (currentLevelKnownBits - 1) % 8; // The bit to modify
-                index           = 1 + (currentLevelKnownBits / 8) + (count ? 1 : 0); // First byte is index 0.
+                index           = 2 + (currentLevelKnownBits - 1) / 8; // The byte holding it. UID bits start at index 2.
                 buffer[index]   |= (1 << count);
             }
             else if(result != STATUS_OK) {
@@ -752,18 +1096,11 @@ MFRC522::StatusCode MFRC522::PICC_Select(Uid *
             uid->uidByte[uidIndex + count] = buffer[index++];
         }
 
-        // Check response SAK (Select Acknowledge)
-        if(responseLength != 3 || txLastBits != 0) {  // SAK must be exactly 24 bits (1 byte + CRC_A).
+        // Check response SAK (Select Acknowledge). Its CRC_A has been verified by PCD_TransceiveData().
+        byte sakLength = _crcMode == PCD_CRC_FRAMED ? 1 : 3;
+        if(responseLength != sakLength || txLastBits != 0) {  // SAK must be exactly 24 bits (1 byte + CRC_A).
             return STATUS_ERROR;
         }
-        // Verify CRC_A - do our own calculation and store the control in buffer[2..3] - those bytes are not needed anymore.
-        result = PCD_CalculateCRC(responseBuffer, 1, &buffer[2]);
-        if(result != STATUS_OK) {
-            return result;
-        }
-        if((buffer[2] != responseBuffer[1]) || (buffer[3] != responseBuffer[2])) {
-            return STATUS_CRC_WRONG;
-        }
         if(responseBuffer[0] & 0x04) {  // Cascade bit set - UID not complete yes
             cascadeLevel++;
         }
@@ -781,21 +1118,27 @@ MFRC522::StatusCode MFRC522::PICC_Select(Uid *
 
 /**
  * Instructs a PICC in state ACTIVE(*) to go to state HALT.
+ * With listen false the HLTA is only transmitted: no waiting for a 'not acknowledge' that a PICC that
+ * understood the command does not send anyway. A PICC that did not understand it falls back to IDLE or HALT.
  *
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
-MFRC522::StatusCode MFRC522::PICC_HaltA()
+MFRC522::StatusCode MFRC522::PICC_HaltA(bool listen    ///< True => wait for the answer period to pass, as the standard says.
+                                       )
 {
     MFRC522::StatusCode result;
     byte buffer[4];
+    bool sendCRC = _crcMode != PCD_CRC_SOFTWARE;
 
-    // Build command buffer
+    // Build command buffer, with its CRC_A if that is known at compile time
     buffer[0] = PICC_CMD_HLTA;
     buffer[1] = 0;
-    // Calculate CRC_A
-    result = PCD_CalculateCRC(buffer, 2, &buffer[2]);
-    if(result != STATUS_OK) {
-        return result;
+    buffer[2] = hltaCrc & 0xFF;
+    buffer[3] = hltaCrc >> 8;
+
+    if(!listen) {
+        return PCD_CommunicateWithPICC(PCD_Transmit, 0x40, buffer, sendCRC ? 2 : 4, NULL, NULL, NULL, 0, false,
+                                       sendCRC);    // TxIRq
     }
 
     // Send the command.
@@ -803,7 +1146,7 @@ MFRC522::StatusCode MFRC522::PICC_HaltA()
     //      If the PICC responds with any modulation during a period of 1 ms after the end of the frame containing the
     //      HLTA command, this response shall be interpreted as 'not acknowledge'.
     // We interpret that this way: Only STATUS_TIMEOUT is an success.
-    result = PCD_TransceiveData(buffer, sizeof(buffer), NULL, 0);
+    result = PCD_TransceiveData(buffer, sendCRC ? 2 : 4, NULL, 0, NULL, 0, false, sendCRC);
     if(result == STATUS_TIMEOUT) {
         return STATUS_OK;
     }
@@ -813,6 +1156,92 @@ MFRC522::StatusCode MFRC522::PICC_HaltA()
     return result;
 } // End PICC_HaltA()
 
+/**
+ * Selects a PICC whose UID is known, eg from an earlier PICC_Select(), without the anticollision loop:
+ * the PICC is put to HALT (if it is still ACTIVE), woken with WUPA and selected with SELECT commands carrying
+ * the UID and BCC of each cascade level. Other PICCs woken by the WUPA go back to HALT or IDLE.
+ * Ends any MIFARE Classic authentication.
+ *
+ * @return STATUS_OK when the PICC answered and is in state ACTIVE, STATUS_TIMEOUT when it has left the field,
+ *         STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_Reselect(Uid *
+                                           uid      ///< In: The UID to select, uid->size must be set. Out: The SAK.
+                                          )
+{
+    MFRC522::StatusCode result;
+    byte bufferATQA[2];
+    byte bufferSize = sizeof(bufferATQA);
+
+    if(uid->size != 4 && uid->size != 7 && uid->size != 10) {
+        return STATUS_INVALID;
+    }
+    // WUPA would make an ACTIVE PICC fall back silently, costing a receive timeout before the WUPA that counts.
+    PCD_StopCrypto1();
+    result = PICC_HaltA(false);
+    if(result != STATUS_OK) {
+        return result;
+    }
+    result = PICC_WakeupA(bufferATQA, &bufferSize);
+    if(result != STATUS_OK && result != STATUS_COLLISION) {     // Collision: other PICCs in the field
+        return result;
+    }
+    return PICC_Select(uid, uid->size * 8);
+} // End PICC_Reselect()
+
+/**
+ * Finds all PICCs in the field: repeats REQA, selects one PICC through the anticollision loop and halts it,
+ * until no PICC answers the REQA any more. On return all PICCs found are in state HALT.
+ * PICCs already in state HALT (eg not removed from the field since the last PICC_HaltA()) do not answer REQA
+ * and are not found.
+ *
+ * When PICCs of different types answer the same REQA their ATQAs collide, and the bits from the first
+ * difference on read 0 in atqa[]. The PICC found last was alone and has its exact ATQA.
+ *
+ * @return STATUS_OK when all PICCs were found, STATUS_NO_ROOM if there are more than maxCount, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_Inventory(PICC_Info * piccs,  ///< Out: The PICCs found, in the order they were selected.
+                                            byte maxCount,      ///< In: The number of entries in piccs.
+                                            byte * count        ///< Out: The number of PICCs found.
+                                           )
+{
+    MFRC522::StatusCode result;
+    byte attempts = 0;          // Failed selects in a row, eg a PICC moving out of the field
+
+    *count = 0;
+    while(true) {
+        byte bufferATQA[2];
+        byte bufferSize = sizeof(bufferATQA);
+        result = PICC_RequestA(bufferATQA, &bufferSize);
+        if(result == STATUS_TIMEOUT) {              // Nobody left in state IDLE
+            return STATUS_OK;
+        }
+        if(result != STATUS_OK && result != STATUS_COLLISION) {
+            return result;
+        }
+        if(*count == maxCount) {
+            return STATUS_NO_ROOM;
+        }
+
+        PICC_Info & info = piccs[*count];
+        result = PICC_Select(&info.uid);
+        if(result != STATUS_OK) {
+            if(++attempts == 3) {
+                return result;
+            }
+            continue;
+        }
+        attempts = 0;
+        info.atqa[0] = bufferATQA[0];
+        info.atqa[1] = bufferATQA[1];
+        (*count)++;
+        result = PICC_HaltA();
+        if(result != STATUS_OK) {
+            return result;
+        }
+    }
+} // End PICC_Inventory()
+
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for communicating with MIFARE PICCs
 /////////////////////////////////////////////////////////////////////////////////////
@@ -874,7 +1303,8 @@ void MFRC522::PCD_StopCrypto1()
  * For example; if blockAddr is 03h then pages 03h, 04h, 05h, 06h are returned.
  * A roll-back is implemented: If blockAddr is 0Eh, then the contents of pages 0Eh, 0Fh, 00h and 01h are returned.
  *
- * The buffer must be at least 18 bytes because a CRC_A is also returned.
+ * The buffer must be at least 18 bytes because a CRC_A is also returned (except in PCD_CRC_FRAMED mode, where the
+ * chip removes it and 16 bytes are returned).
  * Checks the CRC_A before returning STATUS_OK.
  *
  * @return STATUS_OK on success, STATUS_??? otherwise.
@@ -885,24 +1315,20 @@ MFRC522::StatusCode MFRC522::MIFARE_Read(byte
                                          byte * bufferSize   ///< Buffer size, at least 18 bytes. Also number of bytes returned if STATUS_OK.
                                         )
 {
-    MFRC522::StatusCode result;
-
     // Sanity check
     if(buffer == NULL || *bufferSize < 18) {
         return STATUS_NO_ROOM;
     }
 
-    // Build command buffer
+    // Build command buffer, with its CRC_A if that is known at compile time
+    bool sendCRC = _crcMode != PCD_CRC_SOFTWARE;
     buffer[0] = PICC_CMD_MF_READ;
     buffer[1] = blockAddr;
-    // Calculate CRC_A
-    result = PCD_CalculateCRC(buffer, 2, &buffer[2]);
-    if(result != STATUS_OK) {
-        return result;
-    }
+    buffer[2] = readCrc.entry[blockAddr] & 0xFF;
+    buffer[3] = readCrc.entry[blockAddr] >> 8;
 
-    // Transmit the buffer and receive the response, validate CRC_A.
-    return PCD_TransceiveData(buffer, 4, buffer, bufferSize, NULL, 0, true);
+    // Transmit the buffer with CRC_A and receive the response, validate CRC_A.
+    return PCD_TransceiveData(buffer, sendCRC ? 2 : 4, buffer, bufferSize, NULL, 0, true, sendCRC);
 } // End MIFARE_Read()
 
 /**
@@ -979,6 +1405,54 @@ MFRC522::StatusCode MFRC522::MIFARE_Ultralight_Write(byte page,          ///< Th
     return STATUS_OK;
 } // End MIFARE_Ultralight_Write()
 
+/**
+ * Reads the version information of an NTAG21x or MIFARE Ultralight EV1 PICC: fixed header, vendor ID, product type,
+ * product subtype, major and minor product version, storage size and protocol type.
+ * Other Ultralights do not answer and fall back to state IDLE; select them again before the next command.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::MIFARE_Ultralight_GetVersion(byte * buffer,     ///< The buffer to store the 8 bytes in
+                                                          byte * bufferSize  ///< Buffer size, at least 10 bytes. Also number of bytes returned if STATUS_OK.
+                                                         )
+{
+    // Sanity check
+    if(buffer == NULL || *bufferSize < 10) {
+        return STATUS_NO_ROOM;
+    }
+
+    buffer[0] = PICC_CMD_UL_GET_VERSION;
+    return PCD_TransceiveData(buffer, 1, buffer, bufferSize, NULL, 0, true, true);
+} // End MIFARE_Ultralight_GetVersion()
+
+/**
+ * Reads the pages startPage to endPage of an NTAG21x or MIFARE Ultralight EV1 PICC in one frame.
+ * The answer and its CRC_A have to fit in the FIFO, so at most 15 pages are read at a time.
+ * Like MIFARE_Read() the CRC_A is returned too, except in PCD_CRC_FRAMED mode.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::MIFARE_Ultralight_FastRead(byte startPage,     ///< The first page to read
+                                                        byte endPage,       ///< The last page to read
+                                                        byte * buffer,      ///< The buffer to store the data in
+                                                        byte * bufferSize   ///< Buffer size, at least 4 bytes per page + 2. Also number of bytes returned if STATUS_OK.
+                                                       )
+{
+    // Sanity check
+    uint16_t length = (endPage - startPage + 1) * 4 + 2;
+    if(endPage < startPage || length > FIFO_SIZE) {
+        return STATUS_INVALID;
+    }
+    if(buffer == NULL || *bufferSize < length) {
+        return STATUS_NO_ROOM;
+    }
+
+    buffer[0] = PICC_CMD_UL_FAST_READ;
+    buffer[1] = startPage;
+    buffer[2] = endPage;
+    return PCD_TransceiveData(buffer, 3, buffer, bufferSize, NULL, 0, true, true);
+} // End MIFARE_Ultralight_FastRead()
+
 /**
  * MIFARE Decrement subtracts the delta from the value of the addressed block, and stores the result in a volatile memory.
  * For MIFARE Classic only. The sector containing the block must be authenticated before calling this function.
@@ -1154,26 +1628,19 @@ MFRC522::StatusCode MFRC522::PCD_MIFARE_Transceive(byte *
                                                   )
 {
     MFRC522::StatusCode result;
-    byte cmdBuffer[18]; // We need room for 16 bytes data and 2 bytes CRC_A.
+    byte cmdBuffer[18]; // The reply; an ACK is 4 bits, anything up to 16 bytes and 2 bytes CRC_A is an error.
 
     // Sanity check
     if(sendData == NULL || sendLen > 16) {
         return STATUS_INVALID;
     }
 
-    // Copy sendData[] to cmdBuffer[] and add CRC_A
-    memcpy(cmdBuffer, sendData, sendLen);
-    result = PCD_CalculateCRC(cmdBuffer, sendLen, &cmdBuffer[sendLen]);
-    if(result != STATUS_OK) {
-        return result;
-    }
-    sendLen += 2;
-
-    // Transceive the data, store the reply in cmdBuffer[]
+    // Transceive the data with CRC_A added, store the reply in cmdBuffer[]
     byte waitIRq = 0x30;        // RxIRq and IdleIRq
     byte cmdBufferSize = sizeof(cmdBuffer);
     byte validBits = 0;
-    result = PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, cmdBuffer, sendLen, cmdBuffer, &cmdBufferSize, &validBits);
+    result = PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, sendData, sendLen, cmdBuffer, &cmdBufferSize, &validBits, 0,
+                                     false, true);
     if(acceptTimeout && result == STATUS_TIMEOUT) {
         return STATUS_OK;
     }
@@ -1391,235 +1858,213 @@ void MFRC522::PICC_DumpMifareClassicToSerial(const Uid &
                                              const MIFARE_Key & key  ///< Key A used for all sectors.
                                             )
 {
-    byte no_of_sectors = 0;
+    MFRC522_DumpPrinter printer(Serial);
+    PICC_DumpMifareClassic(uid, piccType, key, printer);
+} // End PICC_DumpMifareClassicToSerial()
+
+/**
+ * Dumps memory contents of a sector of a MIFARE Classic PICC.
+ * Uses PCD_Authenticate() and MIFARE_Read(), the sector is left authenticated.
+ * Always uses PICC_CMD_MF_AUTH_KEY_A because only Key A can always read the sector trailer access bits.
+ */
+void MFRC522::PICC_DumpMifareClassicSectorToSerial(const Uid &
+                                                   uid,         ///< Pointer to Uid struct returned from a successful PICC_Select().
+                                                   const MIFARE_Key & key, ///< Key A for the sector.
+                                                   byte sector         ///< The sector to dump, 0..39.
+                                                  )
+{
+    if(sector >= 40) { // Illegal input, no MIFARE Classic PICC has more than 40 sectors.
+        return;
+    }
+    MFRC522_DumpPrinter printer(Serial);
+    PICC_DumpMifareClassicSectors(uid, key, sector, 1, printer);
+} // End PICC_DumpMifareClassicSectorToSerial()
+
+/**
+ * Dumps memory contents of a MIFARE Ultralight PICC.
+ */
+void MFRC522::PICC_DumpMifareUltralightToSerial()
+{
+    MFRC522_DumpPrinter printer(Serial);
+    PICC_DumpMifareUltralight(uid, printer);
+} // End PICC_DumpMifareUltralightToSerial()
+
+/**
+ * Dumps all blocks of a MIFARE Classic PICC into sink, in address order, see MFRC522_Dump.h.
+ * Each sector is authenticated once with key A. After a failed authentication or read the PICC is selected again
+ * for the blocks after it; the blocks of a sector the key does not open are zeros.
+ * The PICC is halted after dumping the data.
+ *
+ * @return STATUS_OK if all blocks were read, the status of the first that was not otherwise.
+ *         STATUS_INVALID if piccType is no MIFARE Classic.
+ */
+MFRC522::StatusCode MFRC522::PICC_DumpMifareClassic(const Uid &
+                                                    uid,                   ///< The PICC, from PICC_Select().
+                                                    byte piccType,         ///< One of the PICC_Type enums.
+                                                    const MIFARE_Key & key, ///< Key A used for all sectors.
+                                                    MFRC522_DumpSink & sink ///< Gets the blocks.
+                                                   )
+{
+    byte sectors;
     switch(piccType) {
         case PICC_TYPE_MIFARE_MINI:
             // Has 5 sectors * 4 blocks/sector * 16 bytes/block = 320 bytes.
-            no_of_sectors = 5;
+            sectors = 5;
             break;
 
         case PICC_TYPE_MIFARE_1K:
             // Has 16 sectors * 4 blocks/sector * 16 bytes/block = 1024 bytes.
-            no_of_sectors = 16;
+            sectors = 16;
             break;
 
         case PICC_TYPE_MIFARE_4K:
             // Has (32 sectors * 4 blocks/sector + 8 sectors * 16 blocks/sector) * 16 bytes/block = 4096 bytes.
-            no_of_sectors = 40;
+            sectors = 40;
             break;
 
-        default: // Should not happen. Ignore.
-            break;
+        default:
+            return STATUS_INVALID;
     }
 
-    // Dump sectors, highest address first.
-    if(no_of_sectors) {
-        Serial.println(F("Sector Block   0  1  2  3   4  5  6  7   8  9 10 11  12 13 14 15  AccessBits"));
-        for(int8_t i = no_of_sectors - 1; i >= 0; i--) {
-            PICC_DumpMifareClassicSectorToSerial(uid, key, i);
-        }
-    }
+    sink.begin(uid, piccType, sectors <= 32 ? sectors * 4 : 128 + (sectors - 32) * 16, 16);
+    StatusCode result = PICC_DumpMifareClassicSectors(uid, key, 0, sectors, sink);
     PICC_HaltA(); // Halt the PICC before stopping the encrypted session.
     PCD_StopCrypto1();
-} // End PICC_DumpMifareClassicToSerial()
+    sink.end();
+    return result;
+} // End PICC_DumpMifareClassic()
 
 /**
- * Dumps memory contents of a sector of a MIFARE Classic PICC.
- * Uses PCD_Authenticate(), MIFARE_Read() and PCD_StopCrypto1.
- * Always uses PICC_CMD_MF_AUTH_KEY_A because only Key A can always read the sector trailer access bits.
+ * Dumps the blocks of sectors firstSector.. into sink, see PICC_DumpMifareClassic(). The last sector is left
+ * authenticated. Key A, which MIFARE_Read() returns as zeros, is replaced by key in the trailers.
+ *
+ * @return STATUS_OK if all blocks were read, the status of the first that was not otherwise.
  */
-void MFRC522::PICC_DumpMifareClassicSectorToSerial(const Uid &
-                                                   uid,         ///< Pointer to Uid struct returned from a successful PICC_Select().
-                                                   const MIFARE_Key & key, ///< Key A for the sector.
-                                                   byte sector         ///< The sector to dump, 0..39.
-                                                  )
+MFRC522::StatusCode MFRC522::PICC_DumpMifareClassicSectors(const Uid &
+                                                           uid,                    ///< The PICC, from PICC_Select().
+                                                           const MIFARE_Key & key, ///< Key A used for all sectors.
+                                                           byte firstSector,       ///< The first sector to dump.
+                                                           byte sectors,           ///< The number of sectors.
+                                                           MFRC522_DumpSink & sink ///< Gets the blocks.
+                                                          )
 {
-    byte status;
-    byte firstBlock;        // Address of lowest address to dump actually last block dumped)
-    byte no_of_blocks;      // Number of blocks in sector
-    bool isSectorTrailer;   // Set to true while handling the "last" (ie highest address) in the sector.
-
-    // The access bits are stored in a peculiar fashion.
-    // There are four groups:
-    //      g[3]    Access bits for the sector trailer, block 3 (for sectors 0-31) or block 15 (for sectors 32-39)
-    //      g[2]    Access bits for block 2 (for sectors 0-31) or blocks 10-14 (for sectors 32-39)
-    //      g[1]    Access bits for block 1 (for sectors 0-31) or blocks 5-9 (for sectors 32-39)
-    //      g[0]    Access bits for block 0 (for sectors 0-31) or blocks 0-4 (for sectors 32-39)
-    // Each group has access bits [C1 C2 C3]. In this code C1 is MSB and C3 is LSB.
-    // The four CX bits are stored together in a nible cx and an inverted nible cx_.
-    byte c1, c2, c3;        // Nibbles
-    byte c1_, c2_, c3_;     // Inverted nibbles
-    bool invertedError;     // True if one of the inverted nibbles did not match
-    byte g[4];              // Access bits for each of the four groups.
-    byte group;             // 0-3 - active group for access bits
-    bool firstInGroup;      // True for the first block dumped in the group
-
-    // Determine position and size of sector.
-    if(sector < 32) {  // Sectors 0..31 has 4 blocks each
-        no_of_blocks = 4;
-        firstBlock = sector * no_of_blocks;
-    }
-    else if(sector < 40) {  // Sectors 32-39 has 16 blocks each
-        no_of_blocks = 16;
-        firstBlock = 128 + (sector - 32) * no_of_blocks;
-    }
-    else { // Illegal input, no MIFARE Classic PICC has more than 40 sectors.
-        return;
-    }
-
-    // Dump blocks, highest address first.
-    byte byteCount;
+    Uid picc = uid;                         // for PICC_Reselect()
+    StatusCode result = STATUS_OK;
+    StatusCode selectStatus = STATUS_OK;    // of the last PICC_Reselect(), once it fails the PICC is gone
+    bool active = true;                     // no failure has sent the PICC to IDLE
     byte buffer[18];
-    byte blockAddr;
-    isSectorTrailer = true;
-    for(int8_t blockOffset = no_of_blocks - 1; blockOffset >= 0; blockOffset--) {
-        blockAddr = firstBlock + blockOffset;
-        // Sector number - only on first line
-        if(isSectorTrailer) {
-            if(sector < 10)
-                Serial.print(F("   ")); // Pad with spaces
-            else
-                Serial.print(F("  ")); // Pad with spaces
-            Serial.print(sector);
-            Serial.print(F("   "));
-        }
-        else {
-            Serial.print(F("       "));
-        }
-        // Block number
-        if(blockAddr < 10)
-            Serial.print(F("   ")); // Pad with spaces
-        else {
-            if(blockAddr < 100)
-                Serial.print(F("  ")); // Pad with spaces
-            else
-                Serial.print(F(" ")); // Pad with spaces
-        }
-        Serial.print(blockAddr);
-        Serial.print(F("  "));
-        // Establish encrypted communications before reading the first block
-        if(isSectorTrailer) {
-            status = PCD_Authenticate(PICC_CMD_MF_AUTH_KEY_A, firstBlock, key, uid);
-            if(status != STATUS_OK) {
-                Serial.print(F("PCD_Authenticate() failed: "));
-                Serial.println(GetStatusCodeName(status));
-                return;
+    byte byteCount;
+
+    for(byte sector = firstSector; sector < firstSector + sectors; sector++) {
+        // Sectors 0..31 have 4 blocks each, sectors 32..39 16
+        byte blocks = sector < 32 ? 4 : 16;
+        byte firstBlock = sector < 32 ? sector * 4 : 128 + (sector - 32) * 16;
+        StatusCode sectorStatus = selectStatus; // of its authentication
+        bool open = false;                      // the sector is authenticated
+        for(byte blockOffset = 0; blockOffset < blocks; blockOffset++) {
+            byte blockAddr = firstBlock + blockOffset;
+            // Establish encrypted communications before reading the first block, and again after a failed read
+            if(!open && sectorStatus == STATUS_OK) {
+                if(!active) {
+                    selectStatus = sectorStatus = PICC_Reselect(&picc);
+                }
+                if(sectorStatus == STATUS_OK) {
+                    sectorStatus = PCD_Authenticate(PICC_CMD_MF_AUTH_KEY_A, firstBlock, key, picc);
+                }
+                open = active = sectorStatus == STATUS_OK;
             }
-        }
-        // Read block
-        byteCount = sizeof(buffer);
-        status = MIFARE_Read(blockAddr, buffer, &byteCount);
-        if(status != STATUS_OK) {
-            Serial.print(F("MIFARE_Read() failed: "));
-            Serial.println(GetStatusCodeName(status));
-            continue;
-        }
-        // Dump data
-        for(byte index = 0; index < 16; index++) {
-            if(buffer[index] < 0x10)
-                Serial.print(F(" 0"));
-            else
-                Serial.print(F(" "));
-            Serial.print(buffer[index], HEX);
-            if((index % 4) == 3) {
-                Serial.print(F(" "));
+            StatusCode status = sectorStatus;
+            if(open) {
+                byteCount = sizeof(buffer);
+                status = MIFARE_Read(blockAddr, buffer, &byteCount);
+                open = active = status == STATUS_OK;
             }
-        }
-        // Parse sector trailer data
-        if(isSectorTrailer) {
-            c1  = buffer[7] >> 4;
-            c2  = buffer[8] & 0xF;
-            c3  = buffer[8] >> 4;
-            c1_ = buffer[6] & 0xF;
-            c2_ = buffer[6] >> 4;
-            c3_ = buffer[7] & 0xF;
-            invertedError = (c1 != (~c1_ & 0xF)) || (c2 != (~c2_ & 0xF)) || (c3 != (~c3_ & 0xF));
-            g[0] = ((c1 & 1) << 2) | ((c2 & 1) << 1) | ((c3 & 1) << 0);
-            g[1] = ((c1 & 2) << 1) | ((c2 & 2) << 0) | ((c3 & 2) >> 1);
-            g[2] = ((c1 & 4) << 0) | ((c2 & 4) >> 1) | ((c3 & 4) >> 2);
-            g[3] = ((c1 & 8) >> 1) | ((c2 & 8) >> 2) | ((c3 & 8) >> 3);
-            isSectorTrailer = false;
-        }
-
-        // Which access group is this block in?
-        if(no_of_blocks == 4) {
-            group = blockOffset;
-            firstInGroup = true;
-        }
-        else {
-            group = blockOffset / 5;
-            firstInGroup = (group == 3) || (group != (blockOffset + 1) / 5);
-        }
-
-        if(firstInGroup) {
-            // Print access bits
-            Serial.print(F(" [ "));
-            Serial.print((g[group] >> 2) & 1, DEC);
-            Serial.print(F(" "));
-            Serial.print((g[group] >> 1) & 1, DEC);
-            Serial.print(F(" "));
-            Serial.print((g[group] >> 0) & 1, DEC);
-            Serial.print(F(" ] "));
-            if(invertedError) {
-                Serial.print(F(" Inverted access bits did not match! "));
+            if(status != STATUS_OK) {
+                memset(buffer, 0, 16);
+                if(result == STATUS_OK) {
+                    result = status;
+                }
             }
+            else if(blockOffset == blocks - 1) {
+                memcpy(buffer, key.keyByte, MF_KEY_SIZE);
+            }
+            sink.block(blockAddr, buffer, status);
         }
-
-        if(group != 3 && (g[group] == 1 || g[group] == 6)) {  // Not a sector trailer, a value block
-            long value = (long(buffer[3]) << 24) | (long(buffer[2]) << 16) | (long(buffer[1]) << 8) | long(buffer[0]);
-            Serial.print(F(" Value=0x"));
-            Serial.print(value, HEX);
-            Serial.print(F(" Adr=0x"));
-            Serial.print(buffer[12], HEX);
-        }
-        Serial.println();
     }
-
-    return;
-} // End PICC_DumpMifareClassicSectorToSerial()
+    return result;
+} // End PICC_DumpMifareClassicSectors()
 
 /**
- * Dumps memory contents of a MIFARE Ultralight PICC.
+ * Dumps all pages of a MIFARE Ultralight or NTAG PICC into sink, in address order, see MFRC522_Dump.h.
+ * A PICC that answers GET_VERSION is dumped up to its last page with FAST_READ, 15 pages per frame. Any other is
+ * taken for an original Ultralight: 16 pages, 4 per READ. Pages the PICC refuses (password protection) are zeros,
+ * after a refusal it is selected again for the pages after them.
+ * The PICC is left ACTIVE.
+ *
+ * @return STATUS_OK if all pages were read, the status of the first that was not otherwise.
  */
-void MFRC522::PICC_DumpMifareUltralightToSerial()
+MFRC522::StatusCode MFRC522::PICC_DumpMifareUltralight(const Uid &
+                                                       uid,                    ///< The PICC, from PICC_Select().
+                                                       MFRC522_DumpSink & sink ///< Gets the pages.
+                                                      )
 {
-    byte status;
-    byte byteCount;
-    byte buffer[18];
-    byte i;
-
-    Serial.println(F("Page  0  1  2  3"));
-    // Try the mpages of the original Ultralight. Ultralight C has more pages.
-    for(byte page = 0; page < 16; page += 4) { // Read returns data for 4 pages at a time.
-        // Read pages
-        byteCount = sizeof(buffer);
-        status = MIFARE_Read(page, buffer, &byteCount);
-        if(status != STATUS_OK) {
-            Serial.print(F("MIFARE_Read() failed: "));
-            Serial.println(GetStatusCodeName(status));
-            break;
+    // The storage size byte of the version of MF0UL11, MF0UL21 and NTAG213/215/216, and their number of pages
+    static const byte storage[] = { 0x0B, 0x0E, 0x0F, 0x11, 0x13 };
+    static const byte pageCount[] = { 20, 41, 45, 135, 231 };
+    Uid picc = uid;                         // for PICC_Reselect()
+    byte buffer[FIFO_SIZE];
+    byte byteCount = sizeof(buffer);
+    byte pages = 16;
+    bool fastRead = false;
+
+    StatusCode selectStatus = MIFARE_Ultralight_GetVersion(buffer, &byteCount);
+    if(selectStatus == STATUS_OK) {
+        // vendor NXP, product type NTAG or Ultralight
+        fastRead = byteCount >= 8 && buffer[1] == 0x04 && (buffer[2] == 0x04 || buffer[2] == 0x03);
+        for(byte i = 0; fastRead && i < sizeof(storage); i++) {
+            if(buffer[6] == storage[i]) {
+                pages = pageCount[i];
+            }
         }
-        // Dump data
-        for(byte offset = 0; offset < 4; offset++) {
-            i = page + offset;
-            if(i < 10)
-                Serial.print(F("  ")); // Pad with spaces
-            else
-                Serial.print(F(" ")); // Pad with spaces
-            Serial.print(i);
-            Serial.print(F("  "));
-            for(byte index = 0; index < 4; index++) {
-                i = 4 * offset + index;
-                if(buffer[i] < 0x10)
-                    Serial.print(F(" 0"));
-                else
-                    Serial.print(F(" "));
-                Serial.print(buffer[i], HEX);
+    }
+    else {
+        selectStatus = PICC_Reselect(&picc); // PICCs without GET_VERSION stay silent and go IDLE
+    }
+
+    StatusCode result = selectStatus;
+    sink.begin(uid, PICC_TYPE_MIFARE_UL, pages, ULTRALIGHT_PAGE_SIZE);
+    for(byte page = 0; page < pages;) {
+        byte count = ULTRALIGHT_READ_SIZE / ULTRALIGHT_PAGE_SIZE;
+        if(fastRead) {
+            count = pages - page < ULTRALIGHT_FAST_READ_PAGES ? pages - page : ULTRALIGHT_FAST_READ_PAGES;
+        }
+        StatusCode status = selectStatus;
+        if(status == STATUS_OK) {
+            byteCount = sizeof(buffer);
+            if(fastRead) {
+                status = MIFARE_Ultralight_FastRead(page, page + count - 1, buffer, &byteCount);
+            }
+            else {
+                status = MIFARE_Read(page, buffer, &byteCount);
             }
-            Serial.println();
+        }
+        if(status != STATUS_OK) {
+            memset(buffer, 0, count * ULTRALIGHT_PAGE_SIZE);
+            if(result == STATUS_OK) {
+                result = status;
+            }
+            if(selectStatus == STATUS_OK) {
+                selectStatus = PICC_Reselect(&picc); // A NAK sends the PICC to IDLE
+            }
+        }
+        // READ may roll over at the end of memory, those pages are not the PICC's
+        for(byte index = 0; index < count && page < pages; index++, page++) {
+            sink.block(page, &buffer[index * ULTRALIGHT_PAGE_SIZE], status);
         }
     }
-} // End PICC_DumpMifareUltralightToSerial()
+    sink.end();
+    return result;
+} // End PICC_DumpMifareUltralight()
 
 /**
  * Calculates the bit pattern needed for the specified access bits. In the [C1 C2 C3] tupples C1 is MSB (=4) and C3 is LSB (=1).
@@ -1875,3 +2320,15 @@ bool MFRC522::PICC_ReadCardSerial()
     byte result = PICC_Select(&uid);
     return (result == STATUS_OK);
 } // End PICC_ReadCardSerial()
+
+/**
+ * Returns true if the PICC read by PICC_ReadCardSerial() is still in the field.
+ * Much cheaper than PICC_IsNewCardPresent() and PICC_ReadCardSerial() as it uses PICC_Reselect(), and it also
+ * finds a PICC that was halted. On true the PICC is selected again.
+ *
+ * @return bool
+ */
+bool MFRC522::PICC_IsCardStillPresent()
+{
+    return uid.size && PICC_Reselect(&uid) == STATUS_OK;
+} // End PICC_IsCardStillPresent()
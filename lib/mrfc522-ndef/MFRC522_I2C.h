@@ -79,7 +79,7 @@
 #define MFRC522_h
 
 #include <Arduino.h>
-#include <Wire.h>
+#include "MFRC522_Transport.h"
 
 // Firmware data for self-test
 // Reference values based on firmware version
@@ -134,6 +134,8 @@ const byte FM17522_firmware_reference[] PROGMEM = {
     0x56, 0x9A, 0x98, 0x82, 0x26, 0xEA, 0x2A, 0x62
 };
 
+class MFRC522_DumpSink;     // MFRC522_Dump.h
+
 class MFRC522
 {
     public:
@@ -242,6 +244,13 @@ class MFRC522
             RxGain_max              = 0x07 << 4     // 111b - 48 dB, maximum, convenience for RxGain_48dB
         };
 
+        // How the CRC_A of frames to and from the PICC is produced and checked.
+        enum PCD_CrcMode {
+            PCD_CRC_CALC            = 0,    // A CalcCRC command cycle per frame sent and per frame checked
+            PCD_CRC_FRAMED          = 1,    // TxCRCEn/RxCRCEn: appended and checked within the Transceive
+            PCD_CRC_SOFTWARE        = 2     // Computed by the MCU from a lookup table, see MFRC522_CRC.h
+        };
+
         // Commands sent to the PICC.
         enum PICC_Command {
             // The commands used by the PCD to manage communication with several PICCs (ISO 14443-3, Type A, section 6.4)
@@ -265,7 +274,10 @@ class MFRC522
             PICC_CMD_MF_TRANSFER    = 0xB0,     // Writes the contents of the internal data register to a block.
             // The commands used for MIFARE Ultralight (from http://www.nxp.com/documents/data_sheet/MF0ICU1.pdf, Section 8.6)
             // The PICC_CMD_MF_READ and PICC_CMD_MF_WRITE can also be used for MIFARE Ultralight.
-            PICC_CMD_UL_WRITE       = 0xA2      // Writes one 4 byte page to the PICC.
+            PICC_CMD_UL_WRITE       = 0xA2,     // Writes one 4 byte page to the PICC.
+            // NTAG21x and MIFARE Ultralight EV1 (from https://www.nxp.com/docs/en/data-sheet/NTAG213_215_216.pdf, Section 10)
+            PICC_CMD_UL_GET_VERSION = 0x60,     // Returns 8 bytes: vendor, product type and storage size of the PICC.
+            PICC_CMD_UL_FAST_READ   = 0x3A      // Reads the pages from a start to an end address in one frame.
         };
 
         // MIFARE constants that does not fit anywhere else
@@ -308,6 +320,12 @@ class MFRC522
             byte        sak;            // The SAK (Select acknowledge) byte returned from the PICC after successful selection.
         } Uid;
 
+        // A PICC found by PICC_Inventory().
+        typedef struct {
+            Uid         uid;            // UID and SAK
+            byte        atqa[2];        // The ATQA (Answer to request) received with the REQA that found the PICC.
+        } PICC_Info;
+
         // A struct used for passing a MIFARE Crypto1 key
         typedef struct {
             byte        keyByte[MF_KEY_SIZE];
@@ -319,10 +337,44 @@ class MFRC522
         // Size of the MFRC522 FIFO
         static const byte FIFO_SIZE = 64;       // The FIFO is 64 bytes.
 
+        // irqPin value for a reader whose IRQ output is not connected. Command completion is then polled.
+        static const byte NO_IRQ_PIN = 0xFF;
+
+        // A sequence of register accesses sent to the MFRC522 as one bus transaction.
+        // On I2C each access is addressed with a repeated START instead of STOP + START, on SPI the bus is
+        // acquired once; multi-byte accesses (the FIFO) go out as one burst. Queue the accesses, then call commit():
+        //
+        //      PCD_Transaction(*this)
+        //          .write(CommandReg, PCD_Idle)
+        //          .write(FIFODataReg, sendLen, sendData)
+        //          .read(ErrorReg, &error)
+        //          .commit();
+        //
+        // Buffers passed to write()/read() must stay valid until commit() returns; read results are
+        // available after commit(). If more than MAX_ACCESSES are queued the transaction is split.
+        class PCD_Transaction
+        {
+            public:
+                static const byte MAX_ACCESSES = MFRC522_TRANSACTION_SIZE;
+
+                PCD_Transaction(MFRC522 & pcd) : _pcd(pcd), _count(0) {};
+                ~PCD_Transaction();
+                PCD_Transaction & write(byte reg, byte value);
+                PCD_Transaction & write(byte reg, byte count, const byte * values);
+                PCD_Transaction & read(byte reg, byte * value);
+                PCD_Transaction & read(byte reg, byte count, byte * values, byte rxAlign = 0);
+                void commit();
+            private:
+                MFRC522_RegisterAccess & append();
+                MFRC522 & _pcd;
+                MFRC522_RegisterAccess _accesses[MAX_ACCESSES];
+                byte _count;
+        };
+
         /////////////////////////////////////////////////////////////////////////////////////
         // Functions for setting up the Arduino
         /////////////////////////////////////////////////////////////////////////////////////
-        MFRC522(byte chipAddress);
+        MFRC522(const MFRC522_Transport & bus, byte irqPin = NO_IRQ_PIN);
 
         /////////////////////////////////////////////////////////////////////////////////////
         // Basic interface functions for communicating with the MFRC522
@@ -346,19 +398,26 @@ class MFRC522
         byte PCD_GetAntennaGain();
         void PCD_SetAntennaGain(byte mask);
         bool PCD_PerformSelfTest();
+        void PCD_SetCrcMode(PCD_CrcMode mode);
+        PCD_CrcMode PCD_GetCrcMode();
+        void PCD_SetTimeout(uint32_t timeoutUs);
+        uint32_t PCD_GetTimeout();
 
         /////////////////////////////////////////////////////////////////////////////////////
         // Functions for communicating with PICCs
         /////////////////////////////////////////////////////////////////////////////////////
         StatusCode PCD_TransceiveData(byte * sendData, byte sendLen, byte * backData, byte * backLen, byte * validBits = NULL,
-                                      byte rxAlign = 0, bool checkCRC = false);
+                                      byte rxAlign = 0, bool checkCRC = false, bool sendCRC = false);
         StatusCode PCD_CommunicateWithPICC(byte command, byte waitIRq, byte * sendData, byte sendLen, byte * backData = NULL,
-                                           byte * backLen = NULL, byte * validBits = NULL, byte rxAlign = 0, bool checkCRC = false);
+                                           byte * backLen = NULL, byte * validBits = NULL, byte rxAlign = 0, bool checkCRC = false,
+                                           bool sendCRC = false);
         StatusCode PICC_RequestA(byte * bufferATQA, byte * bufferSize);
         StatusCode PICC_WakeupA(byte * bufferATQA, byte * bufferSize);
         StatusCode PICC_REQA_or_WUPA(byte command, byte * bufferATQA, byte * bufferSize);
         StatusCode PICC_Select(Uid * uid, byte validBits = 0);
-        StatusCode PICC_HaltA();
+        StatusCode PICC_HaltA(bool listen = true);
+        StatusCode PICC_Reselect(Uid * uid);
+        StatusCode PICC_Inventory(PICC_Info * piccs, byte maxCount, byte * count);
 
         /////////////////////////////////////////////////////////////////////////////////////
         // Functions for communicating with MIFARE PICCs
@@ -372,6 +431,8 @@ class MFRC522
         StatusCode MIFARE_Restore(byte blockAddr);
         StatusCode MIFARE_Transfer(byte blockAddr);
         StatusCode MIFARE_Ultralight_Write(byte page, byte * buffer, byte bufferSize);
+        StatusCode MIFARE_Ultralight_GetVersion(byte * buffer, byte * bufferSize);
+        StatusCode MIFARE_Ultralight_FastRead(byte startPage, byte endPage, byte * buffer, byte * bufferSize);
         byte MIFARE_GetValue(byte blockAddr, long * value);
         StatusCode MIFARE_SetValue(byte blockAddr, long value);
 
@@ -381,7 +442,7 @@ class MFRC522
         StatusCode PCD_MIFARE_Transceive(byte * sendData, byte sendLen, bool acceptTimeout = false);
         // old function used too much memory, now name moved to flash; if you need char, copy from flash to memory
         //const char *GetStatusCodeName(byte code);
-        const __FlashStringHelper * GetStatusCodeName(byte code);
+        static const __FlashStringHelper * GetStatusCodeName(byte code);
         byte PICC_GetType(byte sak);
         // old function used too much memory, now name moved to flash; if you need char, copy from flash to memory
         //const char *PICC_GetTypeName(byte type);
@@ -390,6 +451,9 @@ class MFRC522
         void PICC_DumpMifareClassicToSerial(const Uid & uid, byte piccType, const MIFARE_Key & key);
         void PICC_DumpMifareClassicSectorToSerial(const Uid & uid, const MIFARE_Key & key, byte sector);
         void PICC_DumpMifareUltralightToSerial();
+        StatusCode PICC_DumpMifareClassic(const Uid & uid, byte piccType, const MIFARE_Key & key,
+                                          MFRC522_DumpSink & sink);
+        StatusCode PICC_DumpMifareUltralight(const Uid & uid, MFRC522_DumpSink & sink);
         void MIFARE_SetAccessBits(byte * accessBitBuffer, byte g0, byte g1, byte g2, byte g3);
         bool MIFARE_OpenUidBackdoor(bool logErrors);
         bool MIFARE_SetUid(byte * newUid, byte uidSize, bool logErrors);
@@ -400,11 +464,29 @@ class MFRC522
         /////////////////////////////////////////////////////////////////////////////////////
         bool PICC_IsNewCardPresent();
         bool PICC_ReadCardSerial();
+        bool PICC_IsCardStillPresent();
 
     private:
-        byte _chipAddress;
+        MFRC522_Transport _bus;     // Register I/O, see MFRC522_Transport.h
         byte _resetPowerDownPin;    // Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low)
+        byte _irqPin;               // Arduino pin connected to MFRC522's IRQ output (Pin 23), or NO_IRQ_PIN
+        PCD_CrcMode _crcMode;
+        byte _frameCrc;             // TxCRCEn (0x01) and RxCRCEn (0x02) as last written to TxModeReg/RxModeReg
+        bool _busError;             // A transaction failed on the bus since the command began
+        word _timeoutMs;            // The timeout of PCD_SetTimeout(), rounded up to ms, for PCD_WaitForIrq()
+#ifdef INC_FREERTOS_H
+        TaskHandle_t volatile _irqTask; // The task waiting for the IRQ line
+        static void PCD_IrqHandler(void * arg);
+#endif
+        void PCD_ArmIrq(PCD_Transaction & transaction, byte enableReg, byte irqMask);
+        byte PCD_WaitForIrq(byte irqReg, byte irqMask, word timeoutMs);
+        void PCD_SetFrameCrc(PCD_Transaction & transaction, bool txCRC, bool rxCRC);
+        StatusCode PCD_FrameCRC(byte * data, byte length, byte * result);
         StatusCode MIFARE_TwoStepHelper(byte command, byte blockAddr, long data);
+        StatusCode PICC_DumpMifareClassicSectors(const Uid & uid, const MIFARE_Key & key, byte firstSector,
+                                                 byte sectors, MFRC522_DumpSink & sink);
+        void PCD_ExecuteTransaction(MFRC522_RegisterAccess * accesses, byte count);
+        static void PCD_ApplyRxAlign(byte * destination, byte value, byte rxAlign);
 };
 
 #endif
@@ -0,0 +1,65 @@
+/**
+ * MFRC522_Transport.h - Register I/O for the MFRC522 driver.
+ *
+ * The MFRC522 talks I2C, SPI or UART (datasheet section 8.1); which one is used is decided at compile time so
+ * register accesses are direct calls:
+ *
+ *      (default)                   MFRC522_I2CTransport    Wire, address 0x28 on the M5Stack RFID 2 unit
+ *      -DMFRC522_TRANSPORT_SPI     MFRC522_SPITransport    SPI, chip select pin
+ *      -DMFRC522_TRANSPORT_UART    MFRC522_UARTTransport   a Stream (HardwareSerial) at the chip's baud rate
+ *      -DMFRC522_TRANSPORT_SIM     MFRC522_SimTransport    an in-process MFRC522_RegisterFile (host builds)
+ *
+ * The selected class is typedef'd as MFRC522_Transport and held by value in MFRC522. A transport provides
+ *
+ *      void begin();                                               // called from PCD_Init()
+ *      bool execute(MFRC522_RegisterAccess * accesses, byte count);    // performs the accesses in order
+ *
+ * execute() should do the accesses with as little bus overhead as the interface allows (one I2C transaction,
+ * one SPI bus acquisition). It returns false if the bus reported an error (no ACK, arbitration lost, no answer
+ * in time); the driver then fails the command with STATUS_ERROR. The bit alignment of received data (rxAlign)
+ * is handled by the driver.
+ */
+#ifndef MFRC522_Transport_h
+#define MFRC522_Transport_h
+
+#include <Arduino.h>
+
+// Most accesses execute() is given at once: enough for a whole transceive prologue, CRC and IRQ setup included.
+#define MFRC522_TRANSACTION_SIZE 12
+
+// One register read or write. For multi-byte accesses the same register (the FIFO) is accessed count times.
+struct MFRC522_RegisterAccess {
+    byte reg;
+    byte count;
+    byte rxAlign;               // reads: only bit positions rxAlign..7 in destination[0] are updated (done by the driver)
+    bool isRead;
+    byte value;                 // single byte writes are copied
+    const byte * source;        // multi-byte writes
+    byte * destination;         // reads
+};
+
+// An MFRC522 register file that is not behind a bus, eg a simulator. Target of MFRC522_SimTransport.
+class MFRC522_RegisterFile
+{
+    public:
+        virtual ~MFRC522_RegisterFile() {}
+        virtual void writeRegister(byte reg, const byte * values, byte count) = 0;
+        virtual void readRegister(byte reg, byte * values, byte count) = 0;
+};
+
+#if defined(MFRC522_TRANSPORT_SPI)
+    #include "MFRC522_TransportSPI.h"
+    typedef MFRC522_SPITransport MFRC522_Transport;
+#elif defined(MFRC522_TRANSPORT_UART)
+    #include "MFRC522_TransportUART.h"
+    typedef MFRC522_UARTTransport MFRC522_Transport;
+#elif defined(MFRC522_TRANSPORT_SIM)
+    #include "MFRC522_TransportSim.h"
+    typedef MFRC522_SimTransport MFRC522_Transport;
+#else
+    #define MFRC522_TRANSPORT_I2C
+    #include "MFRC522_TransportI2C.h"
+    typedef MFRC522_I2CTransport MFRC522_Transport;
+#endif
+
+#endif
@@ -0,0 +1,105 @@
+#include "MFRC522_Transport.h"
+
+#ifdef MFRC522_TRANSPORT_I2C
+
+// The ESP32 Wire library can only combine a register address write with a following read (write-read with
+// repeated START). To chain several register accesses into one transaction execute() talks to the ESP-IDF
+// I2C driver underneath Wire directly. Define MFRC522_I2C_NO_REPEATED_START to send one transaction per access.
+#if defined(ESP_PLATFORM) && !defined(MFRC522_I2C_NO_REPEATED_START)
+    #include <driver/i2c.h>
+    #define MFRC522_I2C_USE_CMD_LINK
+
+// Wire serializes its users with a mutex of its own. The command link goes around Wire, so it takes the same mutex
+// for the time of the transaction; Wire keeps it protected, this lets the transport reach it.
+struct MFRC522_WireLock : public TwoWire {
+#if !CONFIG_DISABLE_HAL_LOCKS
+    static SemaphoreHandle_t of(TwoWire & wire)
+    {
+        return wire.*(&MFRC522_WireLock::lock);
+    }
+#else
+    static SemaphoreHandle_t of(TwoWire &)
+    {
+        return NULL;
+    }
+#endif
+};
+#endif
+
+/**
+ * Executes a list of register accesses.
+ * Where the platform allows it all accesses are chained with repeated STARTs into one transaction,
+ * so the bus is arbitrated once and there is one STOP at the end.
+ *
+ * @return false if the MFRC522 did not acknowledge, the bus was lost or the transaction timed out.
+ */
+bool MFRC522_I2CTransport::execute(MFRC522_RegisterAccess * accesses,  ///< The accesses to perform, in order.
+                                   byte count                          ///< The number of accesses, at most MFRC522_TRANSACTION_SIZE.
+                                  )
+{
+#ifdef MFRC522_I2C_USE_CMD_LINK
+    if(count > 1) {
+        i2c_port_t port = I2C_NUM_0;                // the port Wire uses
+#if SOC_I2C_NUM > 1
+        if(_wire == &Wire1) {
+            port = I2C_NUM_1;
+        }
+#endif
+        uint8_t link[I2C_LINK_RECOMMENDED_SIZE(2 * MFRC522_TRANSACTION_SIZE)];
+        i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof(link));
+        for(byte i = 0; i < count; i++) {
+            MFRC522_RegisterAccess & access = accesses[i];
+            i2c_master_start(cmd);
+            i2c_master_write_byte(cmd, (_chipAddress << 1) | I2C_MASTER_WRITE, true);
+            i2c_master_write_byte(cmd, access.reg, true);
+            if(access.isRead) {
+                i2c_master_start(cmd);
+                i2c_master_write_byte(cmd, (_chipAddress << 1) | I2C_MASTER_READ, true);
+                i2c_master_read(cmd, access.destination, access.count, I2C_MASTER_LAST_NACK);
+            }
+            else {
+                i2c_master_write(cmd, access.count == 1 ? &access.value : access.source, access.count, true);
+            }
+        }
+        i2c_master_stop(cmd);
+        SemaphoreHandle_t lock = MFRC522_WireLock::of(*_wire);     // NULL before Wire.begin()
+        if(lock) {
+            xSemaphoreTake(lock, portMAX_DELAY);
+        }
+        esp_err_t result = i2c_master_cmd_begin(port, cmd, pdMS_TO_TICKS(50));
+        if(lock) {
+            xSemaphoreGive(lock);
+        }
+        i2c_cmd_link_delete_static(cmd);
+        return result == ESP_OK;
+    }
+#endif
+#if defined(ESP_PLATFORM)
+    // Wire on the ESP32 cannot start a new transmission on a claimed bus, so only reads use a repeated START.
+    const bool chain = false;
+#else
+    const bool chain = true;
+#endif
+    bool ok = true;
+    for(byte i = 0; i < count; i++) {
+        MFRC522_RegisterAccess & access = accesses[i];
+        bool stop = !chain || (i + 1 == count);
+        _wire->beginTransmission(_chipAddress);
+        _wire->write(access.reg);
+        if(access.isRead) {
+            // Repeated START: address write and read are one transaction
+            ok &= _wire->endTransmission(false) == 0;
+            ok &= _wire->requestFrom(_chipAddress, access.count, (byte)stop) == access.count;
+            for(byte index = 0; index < access.count && _wire->available(); index++) {
+                access.destination[index] = _wire->read();
+            }
+        }
+        else {
+            _wire->write(access.count == 1 ? &access.value : access.source, access.count);
+            ok &= _wire->endTransmission(stop) == 0;
+        }
+    }
+    return ok;
+} // End execute()
+
+#endif // MFRC522_TRANSPORT_I2C
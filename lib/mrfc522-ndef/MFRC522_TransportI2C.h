@@ -0,0 +1,18 @@
+// MFRC522 register I/O over I2C (datasheet section 8.1.4). Include MFRC522_Transport.h instead of this file.
+#ifndef MFRC522_TransportI2C_h
+#define MFRC522_TransportI2C_h
+
+#include <Wire.h>
+
+class MFRC522_I2CTransport
+{
+    public:
+        MFRC522_I2CTransport(byte chipAddress, TwoWire & wire = Wire) : _chipAddress(chipAddress), _wire(&wire) {};
+        void begin() {};
+        bool execute(MFRC522_RegisterAccess * accesses, byte count);
+    private:
+        byte _chipAddress;
+        TwoWire * _wire;
+};
+
+#endif
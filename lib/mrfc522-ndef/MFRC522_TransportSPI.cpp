@@ -0,0 +1,49 @@
+#include "MFRC522_Transport.h"
+
+#ifdef MFRC522_TRANSPORT_SPI
+
+/**
+ * Sets up the chip select pin, the slave is not selected yet.
+ */
+void MFRC522_SPITransport::begin()
+{
+    pinMode(_chipSelectPin, OUTPUT);
+    digitalWrite(_chipSelectPin, HIGH);
+} // End begin()
+
+/**
+ * Executes a list of register accesses, all in one SPI bus transaction.
+ * The address byte is 0 A5..A0 0 for writes and 1 A5..A0 0 for reads; for a burst read the address is sent
+ * again for every byte but the last.
+ *
+ * @return Always true: SPI has no acknowledge.
+ */
+bool MFRC522_SPITransport::execute(MFRC522_RegisterAccess * accesses,  ///< The accesses to perform, in order.
+                                   byte count                          ///< The number of accesses.
+                                  )
+{
+    _spi->beginTransaction(SPISettings(_clock, MSBFIRST, SPI_MODE0));
+    for(byte i = 0; i < count; i++) {
+        MFRC522_RegisterAccess & access = accesses[i];
+        digitalWrite(_chipSelectPin, LOW);          // Select slave
+        if(access.isRead) {
+            byte address = 0x80 | (access.reg << 1);
+            _spi->transfer(address);                // Tell MFRC522 which address we want to read
+            for(byte index = 0; index < access.count; index++) {
+                access.destination[index] = _spi->transfer(index + 1 < access.count ? address : 0);
+            }
+        }
+        else {
+            const byte * values = access.count == 1 ? &access.value : access.source;
+            _spi->transfer(access.reg << 1);
+            for(byte index = 0; index < access.count; index++) {
+                _spi->transfer(values[index]);
+            }
+        }
+        digitalWrite(_chipSelectPin, HIGH);         // Release slave again
+    }
+    _spi->endTransaction();
+    return true;
+} // End execute()
+
+#endif // MFRC522_TRANSPORT_SPI
@@ -0,0 +1,24 @@
+// MFRC522 register I/O over SPI (datasheet section 8.1.2). Include MFRC522_Transport.h instead of this file.
+#ifndef MFRC522_TransportSPI_h
+#define MFRC522_TransportSPI_h
+
+#include <SPI.h>
+
+#ifndef MFRC522_SPI_CLOCK
+    #define MFRC522_SPI_CLOCK 4000000   // The MFRC522 accepts up to 10 MHz
+#endif
+
+class MFRC522_SPITransport
+{
+    public:
+        MFRC522_SPITransport(byte chipSelectPin, SPIClass & spi = SPI, uint32_t clock = MFRC522_SPI_CLOCK)
+            : _chipSelectPin(chipSelectPin), _spi(&spi), _clock(clock) {};
+        void begin();
+        bool execute(MFRC522_RegisterAccess * accesses, byte count);
+    private:
+        byte _chipSelectPin;
+        SPIClass * _spi;
+        uint32_t _clock;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#include "MFRC522_Transport.h"
+
+#ifdef MFRC522_TRANSPORT_SIM
+
+/**
+ * Executes a list of register accesses on the register file.
+ *
+ * @return Always true.
+ */
+bool MFRC522_SimTransport::execute(MFRC522_RegisterAccess * accesses,  ///< The accesses to perform, in order.
+                                   byte count                          ///< The number of accesses.
+                                  )
+{
+    for(byte i = 0; i < count; i++) {
+        MFRC522_RegisterAccess & access = accesses[i];
+        if(access.isRead) {
+            _target->readRegister(access.reg, access.destination, access.count);
+        }
+        else {
+            _target->writeRegister(access.reg, access.count == 1 ? &access.value : access.source, access.count);
+        }
+    }
+    return true;
+} // End execute()
+
+#endif // MFRC522_TRANSPORT_SIM
@@ -0,0 +1,16 @@
+// MFRC522 register I/O straight into an in-process register file, no bus. Include MFRC522_Transport.h
+// instead of this file.
+#ifndef MFRC522_TransportSim_h
+#define MFRC522_TransportSim_h
+
+class MFRC522_SimTransport
+{
+    public:
+        MFRC522_SimTransport(MFRC522_RegisterFile * target) : _target(target) {};
+        void begin() {};
+        bool execute(MFRC522_RegisterAccess * accesses, byte count);
+    private:
+        MFRC522_RegisterFile * _target;
+};
+
+#endif
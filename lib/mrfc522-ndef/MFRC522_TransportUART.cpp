@@ -0,0 +1,56 @@
+#include "MFRC522_Transport.h"
+
+#ifdef MFRC522_TRANSPORT_UART
+
+/**
+ * Executes a list of register accesses.
+ * Every byte is addressed separately: reads send 1 A5..A0 and receive the value, writes send 0 A5..A0 and the
+ * value and receive the address back as acknowledgement.
+ *
+ * @return false if the MFRC522 did not answer every byte; the accesses after that are still sent.
+ */
+bool MFRC522_UARTTransport::execute(MFRC522_RegisterAccess * accesses,     ///< The accesses to perform, in order.
+                                    byte count                             ///< The number of accesses.
+                                   )
+{
+    bool ok = true;
+    byte echo;
+    for(byte i = 0; i < count; i++) {
+        MFRC522_RegisterAccess & access = accesses[i];
+        if(access.isRead) {
+            for(byte index = 0; index < access.count; index++) {
+                _serial->write(0x80 | access.reg);
+                ok &= receive(&access.destination[index]);
+            }
+        }
+        else {
+            const byte * values = access.count == 1 ? &access.value : access.source;
+            for(byte index = 0; index < access.count; index++) {
+                _serial->write(access.reg);
+                _serial->write(values[index]);
+                ok &= receive(&echo);
+            }
+        }
+    }
+    return ok;
+} // End execute()
+
+/**
+ * Reads the next byte from the MFRC522.
+ *
+ * @return false, with *value 0, if none arrives within MFRC522_UART_TIMEOUT_MS.
+ */
+bool MFRC522_UARTTransport::receive(byte * value)
+{
+    unsigned long start = millis();
+    while(!_serial->available()) {
+        if(millis() - start > MFRC522_UART_TIMEOUT_MS) {
+            *value = 0;
+            return false;
+        }
+    }
+    *value = _serial->read();
+    return true;
+} // End receive()
+
+#endif // MFRC522_TRANSPORT_UART
@@ -0,0 +1,23 @@
+// MFRC522 register I/O over UART (datasheet section 8.1.3). Include MFRC522_Transport.h instead of this file.
+// The Stream must already be running at the MFRC522's baud rate (9600 Bd after reset, see SerialSpeedReg).
+#ifndef MFRC522_TransportUART_h
+#define MFRC522_TransportUART_h
+
+#include <Stream.h>
+
+#ifndef MFRC522_UART_TIMEOUT_MS
+    #define MFRC522_UART_TIMEOUT_MS 10
+#endif
+
+class MFRC522_UARTTransport
+{
+    public:
+        MFRC522_UARTTransport(Stream & serial) : _serial(&serial) {};
+        void begin() {};
+        bool execute(MFRC522_RegisterAccess * accesses, byte count);
+    private:
+        bool receive(byte * value);
+        Stream * _serial;
+};
+
+#endif
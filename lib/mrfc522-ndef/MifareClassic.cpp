@@ -3,21 +3,133 @@
 
 MifareClassic::~MifareClassic()
 {
+    if(_keys) {
+        _keys->flush();
+    }
+}
+
+static_assert(MIFARE_CLASSIC_MINI.ndefBytes() == 192 && MIFARE_CLASSIC_1K.ndefBytes() == 720
+              && MIFARE_CLASSIC_4K.ndefBytes() == 3360, "NDEF capacity of the MIFARE Classic geometries");
+static_assert(MIFARE_CLASSIC_4K.trailer(31) == 127 && MIFARE_CLASSIC_4K.trailer(39) == 255
+              && MIFARE_CLASSIC_4K.blocks() == 256, "MIFARE Classic 4K sectors");
+
+const MifareClassicGeometry & MifareClassic::geometryOf(byte piccType)
+{
+    return piccType == MFRC522::PICC_TYPE_MIFARE_4K ? MIFARE_CLASSIC_4K
+           : piccType == MFRC522::PICC_TYPE_MIFARE_MINI ? MIFARE_CLASSIC_MINI : MIFARE_CLASSIC_1K;
+}
+
+bool MifareClassicSession::isAuthenticated(byte command, byte block, const MFRC522::MIFARE_Key & key) const
+{
+    return _sector == MifareClassicGeometry::sectorOf(block) && _command == command
+           && memcmp(_key.keyByte, key.keyByte, MFRC522::MF_KEY_SIZE) == 0;
+}
+
+void MifareClassicSession::authenticated(byte command, byte block, const MFRC522::MIFARE_Key & key)
+{
+    _sector = MifareClassicGeometry::sectorOf(block);
+    _command = command;
+    _key = key;
+}
+
+bool MifareClassicSession::knowsMad(const MFRC522::Uid & uid) const
+{
+    return _madUidSize != 0 && _madUidSize == uid.size && _madSak == uid.sak
+           && memcmp(_madUid, uid.uidByte, uid.size) == 0;
+}
+
+void MifareClassicSession::madRead(const MFRC522::Uid & uid, uint64_t ndefSectors)
+{
+    memcpy(_madUid, uid.uidByte, uid.size);
+    _madUidSize = uid.size;
+    _madSak = uid.sak;
+    _ndefSectors = ndefSectors;
+}
+
+// Authenticates the sector of block, unless the session already is
+MFRC522::StatusCode MifareClassic::authenticate(byte command, byte block, const MFRC522::MIFARE_Key & key)
+{
+    MifareClassicSession & session = this->session();
+    if(session.isAuthenticated(command, block, key)) {
+        session.skipped++;
+        return MFRC522::STATUS_OK;
+    }
+    session.authentications++;
+    MFRC522::StatusCode status = _nfcShield->PCD_Authenticate(command, block, key, _nfcShield->uid);
+    if(status == MFRC522::STATUS_OK) {
+        session.authenticated(command, block, key);
+    }
+    else {
+        session.reset();
+    }
+    return status;
+}
+
+// Authenticates the sector of block for reading. With a key provider: each key it has for the sector, reselecting
+// the tag after every failure.
+MFRC522::StatusCode MifareClassic::authenticateRead(byte block)
+{
+    if(!_keys) {
+        return authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, block, _key);
+    }
+    MFRC522::Uid & uid = _nfcShield->uid;
+    byte sector = MifareClassicGeometry::sectorOf(block);
+    MifareSectorKey key;
+    MFRC522::StatusCode status = MFRC522::STATUS_ERROR;
+    for(byte candidate = 0; _keys->key(uid, sector, candidate, key); candidate++) {
+        status = authenticate(key.command, block, key.key);
+        if(status == MFRC522::STATUS_OK) {
+            _keys->opened(uid, sector, key);
+            return status;
+        }
+        if(_nfcShield->PICC_Reselect(&uid) != MFRC522::STATUS_OK) {
+            return status;
+        }
+    }
+    _keys->failed(uid, sector);
+    return status;
+}
+
+// A failed command leaves the card unauthenticated (it NAKs and goes IDLE, or did not hear us)
+MFRC522::StatusCode MifareClassic::readBlock(byte block, byte * buffer, byte * bufferSize)
+{
+    MFRC522::StatusCode status = _nfcShield->MIFARE_Read(block, buffer, bufferSize);
+    if(status != MFRC522::STATUS_OK) {
+        session().reset();
+    }
+    return status;
+}
+
+MFRC522::StatusCode MifareClassic::writeBlock(byte block, byte * buffer, byte bufferSize)
+{
+    MFRC522::StatusCode status = _nfcShield->MIFARE_Write(block, buffer, bufferSize);
+    if(status != MFRC522::STATUS_OK) {
+        session().reset();
+    }
+    return status;
 }
 
 NfcTag MifareClassic::read()
 {
     int messageStartIndex = 0;
     int messageLength = 0;
-    byte dataSize = BLOCK_SIZE + 2;
-    byte data[dataSize];
+    byte data[BLOCK_SIZE + 2];
+    byte dataSize = sizeof(data);
+    uint64_t sectors = ndefSectors();
+    MifareClassicDataBlocks blocks(_geometry, sectors);
 
     // read first block to get message length
-    if(_nfcShield->PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 4, _key,
-                                    _nfcShield->uid) == MFRC522::STATUS_OK) {
-        if(_nfcShield->MIFARE_Read(4, data, &dataSize) != MFRC522::STATUS_OK) {
+    if(blocks.atEnd()) {
+#ifdef NDEF_USE_SERIAL
+        Serial.println(F("No NDEF sector in the MAD"));
+#endif
+        return NfcTag(_nfcShield->uid.uidByte, _nfcShield->uid.size, NfcTag::TYPE_MIFARE_CLASSIC, false);
+    }
+    if(authenticateRead(blocks.block()) == MFRC522::STATUS_OK) {
+        if(readBlock(blocks.block(), data, &dataSize) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
-            Serial.println(F("Error. Failed read block 4"));
+            Serial.print(F("Error. Failed read block "));
+            Serial.println(blocks.block());
 #endif
             return NfcTag(_nfcShield->uid.uidByte, _nfcShield->uid.size, NfcTag::TYPE_MIFARE_CLASSIC);
         }
@@ -36,27 +148,31 @@ NfcTag MifareClassic::read()
 #endif
         return NfcTag(_nfcShield->uid.uidByte, _nfcShield->uid.size, NfcTag::TYPE_MIFARE_CLASSIC, false);
     }
-    int currentBlock = 4;
-    // this should be nested in the message length loop
-    int index = 0;
-    // Add 2 to allow MFRC522 to add CRC
-    int bufferSize = getBufferSize(messageLength) + 2;
-    uint8_t buffer[bufferSize];
+    if(getBufferSize(messageLength) > _geometry.capacity(sectors)) {
+#ifdef NDEF_USE_SERIAL
+        Serial.println(F("Message length exceeds tag capacity"));
+#endif
+        return NfcTag(_nfcShield->uid.uidByte, _nfcShield->uid.size, NfcTag::TYPE_MIFARE_CLASSIC);
+    }
+    // The blocks go straight into the storage of the tag: a 4K message does not fit the stack of a monitor task
+    NfcTag tag(_nfcShield->uid.uidByte, _nfcShield->uid.size, NfcTag::TYPE_MIFARE_CLASSIC, NULL, 0, _allocator);
+    byte * message = tag.allocateNdefData(messageLength);
+    if(!message) {
+        return tag;
+    }
+    int messageEnd = messageStartIndex + messageLength;
 
 #ifdef MIFARE_CLASSIC_DEBUG
     Serial.print(F("Message Length "));
     Serial.println(messageLength);
-    Serial.print(F("Buffer Size "));
-    Serial.println(bufferSize);
 #endif
 
-    while(index < bufferSize - 2) {
+    for(int index = 0; index < messageEnd; index += BLOCK_SIZE, blocks.next()) {
+        byte currentBlock = blocks.block();
 
         // authenticate on every sector
-        if(((currentBlock < 128) && (currentBlock % 4 == 0)) || ((currentBlock >= 128) && (currentBlock % 16 == 0))) {
-
-            if(_nfcShield->PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, currentBlock, _key,
-                                            _nfcShield->uid) != MFRC522::STATUS_OK) {
+        if(blocks.sectorStart()) {
+            if(authenticateRead(currentBlock) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
                 Serial.print(F("Error. Block Authentication failed for "));
                 Serial.println(currentBlock);
@@ -67,13 +183,13 @@ NfcTag MifareClassic::read()
         }
 
         // read the data
-        byte readBufferSize = 18;
-        if(_nfcShield->MIFARE_Read(currentBlock, &buffer[index], &readBufferSize) == MFRC522::STATUS_OK) {
+        dataSize = sizeof(data);
+        if(readBlock(currentBlock, data, &dataSize) == MFRC522::STATUS_OK) {
 #ifdef MIFARE_CLASSIC_DEBUG
             Serial.print(F("Block "));
             Serial.print(currentBlock);
             Serial.print(" ");
-            PrintHexChar(&buffer[index], BLOCK_SIZE);
+            PrintHexChar(data, BLOCK_SIZE);
 #endif
         }
         else {
@@ -85,22 +201,46 @@ NfcTag MifareClassic::read()
             return NfcTag(_nfcShield->uid.uidByte, _nfcShield->uid.size, NfcTag::TYPE_MIFARE_CLASSIC);
         }
 
-        index += BLOCK_SIZE;
-        currentBlock++;
+        // the part of the block that is message
+        int start = index > messageStartIndex ? index : messageStartIndex;
+        int end = index + BLOCK_SIZE < messageEnd ? index + BLOCK_SIZE : messageEnd;
+        memcpy(&message[start - messageStartIndex], &data[start - index], end - start);
+    }
 
-        // skip the trailer block
-        if(((currentBlock < 128) && ((currentBlock + 1) % 4 == 0)) || ((currentBlock >= 128) &&
-                                                                       ((currentBlock + 1) % 16 == 0))) {
-#ifdef MIFARE_CLASSIC_DEBUG
-            Serial.print(F("Skipping block "));
-            Serial.println(currentBlock);
+    return tag;
+}
+
+// Each data block goes to the decoder as soon as it is read, so memory does not grow with the message
+bool MifareClassic::read(NdefStreamDecoder & decoder)
+{
+    byte data[BLOCK_SIZE + 2];
+
+    for(MifareClassicDataBlocks blocks(_geometry, ndefSectors()); !blocks.atEnd() && !decoder.done(); blocks.next()) {
+        byte block = blocks.block();
+        if(blocks.sectorStart() && authenticateRead(block) != MFRC522::STATUS_OK) {
+#ifdef NDEF_USE_SERIAL
+            Serial.print(F("Error. Block Authentication failed for "));
+            Serial.println(block);
 #endif
-            currentBlock++;
+            return false;
         }
+        byte dataSize = sizeof(data);
+        if(readBlock(block, data, &dataSize) != MFRC522::STATUS_OK) {
+#ifdef NDEF_USE_SERIAL
+            Serial.print(F("Read failed "));
+            Serial.println(block);
+#endif
+            return false;
+        }
+#ifdef MIFARE_CLASSIC_DEBUG
+        Serial.print(F("Block "));
+        Serial.print(block);
+        Serial.print(" ");
+        PrintHexChar(data, BLOCK_SIZE);
+#endif
+        decoder.feed(data, BLOCK_SIZE);
     }
-
-    return NfcTag(_nfcShield->uid.uidByte, _nfcShield->uid.size, NfcTag::TYPE_MIFARE_CLASSIC, &buffer[messageStartIndex],
-                  messageLength);
+    return decoder.complete();
 }
 
 int MifareClassic::getBufferSize(int messageLength)
@@ -181,108 +321,186 @@ bool MifareClassic::decodeTlv(byte * data, int * messageLength, int * messageSta
     return true;
 }
 
-// Intialized NDEF tag contains one empty NDEF TLV 03 00 FE - AN1304 6.3.1
-// We are formatting in read/write mode with a NDEF TLV 03 03 and an empty NDEF record D0 00 00 FE - AN1304 6.3.2
-bool MifareClassic::formatNDEF()
+// CRC-8 of a MIFARE Application Directory, polynomial x^8 + x^4 + x^3 + x^2 + 1, preset 0xC7 - AN10787 3.7
+byte MifareClassic::madCrc(const byte * data, byte length)
 {
-    MFRC522::MIFARE_Key keya = {{0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
-    byte emptyNdefMesg[16] = {0x03, 0x03, 0xD0, 0x00, 0x00, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-    byte blockbuffer0[16] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-    byte blockbuffer1[16] = {0x14, 0x01, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1};
-    byte blockbuffer2[16] = {0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1};
-    byte blockbuffer3[16] = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0x78, 0x77, 0x88, 0xC1, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-    byte blockbuffer4[16] = {0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7, 0x7F, 0x07, 0x88, 0x40, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    byte crc = 0xC7;
+    for(byte i = 0; i < length; i++) {
+        crc ^= data[i];
+        for(byte bit = 0; bit < 8; bit++) {
+            crc = crc & 0x80 ? (crc << 1) ^ 0x1D : crc << 1;
+        }
+    }
+    return crc;
+}
 
-    // TODO use UID from method parameters?
-    if(_nfcShield->PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 1, keya, _nfcShield->uid) != MFRC522::STATUS_OK) {
-#ifdef NDEF_USE_SERIAL
-        Serial.println(F("Unable to authenticate block 1 to enable card formatting!"));
-#endif
+// Reads the 3 MAD blocks of sector 0 (blocks 1, 2 and the trailer with the general purpose byte) or 16 (MAD2)
+bool MifareClassic::readMadSector(byte madSector, const MFRC522::MIFARE_Key & key, byte * data)
+{
+    uint16_t first = _geometry.firstBlock(madSector) + (madSector == 0 ? 1 : 0);
+    if(authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, first, key) != MFRC522::STATUS_OK) {
         return false;
     }
+    for(byte i = 0; i < 3; i++) {
+        byte dataSize = BLOCK_SIZE + 2;
+        if(readBlock(first + i, &data[i * BLOCK_SIZE], &dataSize) != MFRC522::STATUS_OK) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    if(_nfcShield->MIFARE_Write(1, blockbuffer1, 16) != MFRC522::STATUS_OK) {
-#ifdef NDEF_USE_SERIAL
-        Serial.println(F("Unable to format the card for NDEF: Block 1 failed"));
-#endif
-        return false;
+// The sectors the MAD gives NDEF (AID 0x03E1), so other applications on the card are neither read nor
+// authenticated. A card without a valid MAD gets the layout formatNDEF() writes. False if the tag did not answer
+// and the answer is only good for this operation.
+bool MifareClassic::readMad(uint64_t * sectors)
+{
+    const MFRC522::MIFARE_Key madKey = {{0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5}};
+    byte mad[3 * BLOCK_SIZE + 2];   // the last read brings its CRC along
+
+    *sectors = _geometry.dataSectors();
+    if(!readMadSector(0, madKey, mad)) {
+        // the failed command left the tag IDLE: if it is still there to be selected, it refused the public MAD key
+        // and has no MAD
+        return _nfcShield->PICC_Reselect(&_nfcShield->uid) == MFRC522::STATUS_OK;
     }
+    byte gpb = mad[2 * BLOCK_SIZE + 9];
+    if(!(gpb & 0x80) || madCrc(&mad[1], 31) != mad[0]) {
+        return true;
+    }
+    uint64_t found = 0;
+    for(byte sector = 1; sector < 16 && sector < _geometry.sectors; sector++) {
+        if(mad[2 * sector] == 0x03 && mad[2 * sector + 1] == 0xE1) {
+            found |= (uint64_t)1 << sector;
+        }
+    }
+    // MAD2 only counts on a 4K, and with a version 2 general purpose byte
+    if((gpb & 0x03) == 2 && _geometry.sectors > 16) {
+        if(!readMadSector(16, madKey, mad)) {
+            // like sector 0: the tag is IDLE, and if it is still there it has no MAD2, the sectors MAD1 gives are it
+            *sectors = found;
+            return _nfcShield->PICC_Reselect(&_nfcShield->uid) == MFRC522::STATUS_OK;
+        }
+        if(madCrc(&mad[1], 47) == mad[0]) {
+            for(byte sector = 17; sector < _geometry.sectors; sector++) {
+                if(mad[2 * (sector - 16)] == 0x03 && mad[2 * (sector - 16) + 1] == 0xE1) {
+                    found |= (uint64_t)1 << sector;
+                }
+            }
+        }
+    }
+    *sectors = found;
+    return true;
+}
 
-    if(_nfcShield->MIFARE_Write(2, blockbuffer2, 16) != MFRC522::STATUS_OK) {
-#ifdef NDEF_USE_SERIAL
-        Serial.println(F("Unable to format the card for NDEF: Block 2 failed"));
-#endif
-        return false;
+// The NDEF sectors, the MAD is read once per tag and session
+uint64_t MifareClassic::ndefSectors()
+{
+    MifareClassicSession & session = this->session();
+    if(!session.knowsMad(_nfcShield->uid)) {
+        uint64_t sectors;
+        if(!readMad(&sectors)) {
+            return sectors;
+        }
+        session.madRead(_nfcShield->uid, sectors);
     }
-    // Write new key A and permissions
-    if(_nfcShield->MIFARE_Write(3, blockbuffer3, 16) != MFRC522::STATUS_OK) {
+    return session.ndefSectors();
+}
+
+// Writes the MAD blocks of sector 0 (MAD1, sectors 1-15) or 16 (MAD2 on a 4K, sectors 17-39), every sector the
+// card has marked NDEF (AID 0x03E1), with key A 0xA0A1A2A3A4A5 in the trailer
+bool MifareClassic::writeMad(byte madSector, const MFRC522::MIFARE_Key & key)
+{
+    byte mad[3 * BLOCK_SIZE] = { 0 };
+    byte trailer[16] = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0x78, 0x77, 0x88, 0xC1, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    byte first = madSector + 1;
+    byte entries = madSector == 0 ? 15 : 23;
+    byte * block = madSector == 0 ? &mad[BLOCK_SIZE] : mad;   // MAD1 leaves the manufacturer block alone
+
+    block[1] = madSector == 0 ? 0x01 : 0x00;   // info byte
+    for(byte i = 0; i < entries && first + i < _geometry.sectors; i++) {
+        block[2 + 2 * i] = 0x03;
+        block[3 + 2 * i] = 0xE1;
+    }
+    block[0] = madCrc(&block[1], 2 * entries + 1);
+    trailer[9] = _geometry.sectors > 16 ? 0xC2 : 0xC1;    // general purpose byte: MAD in use, version 1 or 2
+
+    uint16_t firstBlock = _geometry.firstBlock(madSector);
+    if(authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, firstBlock + 1, key) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
-        Serial.println(F("Unable to format the card for NDEF: Block 3 failed"));
+        Serial.print(F("Unable to authenticate the MAD in sector "));
+        Serial.println(madSector);
 #endif
         return false;
     }
-    for(int i = 4; i < 64; i += 4) {
-        if(_nfcShield->PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, i, keya, _nfcShield->uid) != MFRC522::STATUS_OK) {
+    for(byte i = madSector == 0 ? 1 : 0; i < 3; i++) {
+        if(writeBlock(firstBlock + i, &mad[i * BLOCK_SIZE], BLOCK_SIZE) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
-            Serial.print(F("Unable to authenticate block "));
-            Serial.println(i);
+            Serial.print(F("Unable to format the card for NDEF: Block "));
+            Serial.print(firstBlock + i);
+            Serial.println(F(" failed"));
 #endif
             return false;
         }
-
-        if(i == 4) { // special handling for block 4
-            if(_nfcShield->MIFARE_Write(i, emptyNdefMesg, 16) != MFRC522::STATUS_OK) {
-#ifdef NDEF_USE_SERIAL
-                Serial.print(F("Unable to write block "));
-                Serial.println(i);
-#endif
-                return false;
-            }
-        }
-        else {
-            if(_nfcShield->MIFARE_Write(i, blockbuffer0, 16) != MFRC522::STATUS_OK) {
+    }
+    // Write new key A and permissions
+    if(writeBlock(firstBlock + 3, trailer, BLOCK_SIZE) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
-                Serial.print(F("Unable to write block "));
-                Serial.println(i);
+        Serial.print(F("Unable to format the card for NDEF: Block "));
+        Serial.print(firstBlock + 3);
+        Serial.println(F(" failed"));
 #endif
-                return false;
-            }
+        return false;
+    }
+    return true;
+}
+
+// Intialized NDEF tag contains one empty NDEF TLV 03 00 FE - AN1304 6.3.1
+// We are formatting in read/write mode with a NDEF TLV 03 03 and an empty NDEF record D0 00 00 FE - AN1304 6.3.2
+bool MifareClassic::formatNDEF()
+{
+    MFRC522::MIFARE_Key keya = {{0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
+    byte emptyNdefMesg[16] = {0x03, 0x03, 0xD0, 0x00, 0x00, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    byte blockbuffer0[16] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    byte blockbuffer4[16] = {0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7, 0x7F, 0x07, 0x88, 0x40, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+    session().forgetMad();
+    // TODO use UID from method parameters?
+    for(byte sector = 0; sector < _geometry.sectors; sector++) {
+        if(_geometry.isMad(sector) && !writeMad(sector, keya)) {
+            return false;
         }
-        if(_nfcShield->MIFARE_Write(i + 1, blockbuffer0, 16) != MFRC522::STATUS_OK) {
+    }
+    for(MifareClassicDataBlocks blocks(_geometry); !blocks.atEnd(); blocks.next()) {
+        uint16_t i = blocks.block();
+        if(blocks.sectorStart() && authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, i, keya) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
-            Serial.print(F("Unable to write block "));
-            Serial.println(i + 1);
+            Serial.print(F("Unable to authenticate block "));
+            Serial.println(i);
 #endif
             return false;
         }
-        if(_nfcShield->MIFARE_Write(i + 2, blockbuffer0, 16) != MFRC522::STATUS_OK) {
+        if(writeBlock(i, i == _geometry.firstBlock(1) ? emptyNdefMesg : blockbuffer0, 16) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
             Serial.print(F("Unable to write block "));
-            Serial.println(i + 2);
+            Serial.println(i);
 #endif
             return false;
         }
-        if(_nfcShield->MIFARE_Write(i + 3, blockbuffer4, 16) != MFRC522::STATUS_OK) {
+        // the last data block of the sector: its trailer follows
+        if(i + 1 == _geometry.trailer(blocks.sector())
+           && writeBlock(i + 1, blockbuffer4, 16) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
             Serial.print(F("Unable to write block "));
-            Serial.println(i + 3);
+            Serial.println(i + 1);
 #endif
             return false;
         }
     }
+    session().madRead(_nfcShield->uid, _geometry.dataSectors());
     return true;
 }
 
-#define NR_SHORTSECTOR          (32)    // Number of short sectors on Mifare 1K/4K
-#define NR_LONGSECTOR           (8)     // Number of long sectors on Mifare 4K
-#define NR_BLOCK_OF_SHORTSECTOR (4)     // Number of blocks in a short sector
-#define NR_BLOCK_OF_LONGSECTOR  (16)    // Number of blocks in a long sector
-
-// Determine the sector trailer block based on sector number
-#define BLOCK_NUMBER_OF_SECTOR_TRAILER(sector) (((sector)<NR_SHORTSECTOR)? \
-                                                ((sector)*NR_BLOCK_OF_SHORTSECTOR + NR_BLOCK_OF_SHORTSECTOR-1):\
-                                                (NR_SHORTSECTOR*NR_BLOCK_OF_SHORTSECTOR + (sector-NR_SHORTSECTOR)*NR_BLOCK_OF_LONGSECTOR + NR_BLOCK_OF_LONGSECTOR-1))
-
 bool MifareClassic::formatMifare()
 {
 
@@ -291,13 +509,12 @@ bool MifareClassic::formatMifare()
     byte emptyBlock[16] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
     byte authBlock[16] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x80, 0x69, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 
-    uint8_t idx = 0;
-    uint8_t numOfSector = 16;                         // Assume Mifare Classic 1K for now (16 4-block sectors)
+    session().forgetMad();
 
-    for(idx = 0; idx < numOfSector; idx++) {
+    for(byte idx = 0; idx < _geometry.sectors; idx++) {
+        uint16_t trailer = _geometry.trailer(idx);
         // Step 1: Authenticate the current sector using key B 0xFF 0xFF 0xFF 0xFF 0xFF 0xFF
-        if(_nfcShield->PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_B, BLOCK_NUMBER_OF_SECTOR_TRAILER(idx),
-                                        KEY_DEFAULT_KEYAB, _nfcShield->uid) != MFRC522::STATUS_OK) {
+        if(authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_B, trailer, KEY_DEFAULT_KEYAB) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
             Serial.print(F("Authentication failed for sector "));
             Serial.println(idx);
@@ -306,39 +523,18 @@ bool MifareClassic::formatMifare()
         }
 
         // Step 2: Write to the other blocks
-        if(idx == 0) {
-            if(_nfcShield->MIFARE_Write((BLOCK_NUMBER_OF_SECTOR_TRAILER(idx)) - 2, emptyBlock, 16) != MFRC522::STATUS_OK) {
+        // block 0 has not to be overwritten. It contains Tag id and other unique data.
+        for(uint16_t block = idx == 0 ? 1 : _geometry.firstBlock(idx); block < trailer; block++) {
+            if(writeBlock(block, emptyBlock, 16) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
                 Serial.print(F("Unable to write to sector "));
                 Serial.println(idx);
 #endif
             }
         }
-        else {
-            // this block has not to be overwritten for block 0. It contains Tag id and other unique data.
-            if(_nfcShield->MIFARE_Write((BLOCK_NUMBER_OF_SECTOR_TRAILER(idx)) - 3, emptyBlock, 16) != MFRC522::STATUS_OK) {
-#ifdef NDEF_USE_SERIAL
-                Serial.print(F("Unable to write to sector "));
-                Serial.println(idx);
-#endif
-            }
-            if(_nfcShield->MIFARE_Write((BLOCK_NUMBER_OF_SECTOR_TRAILER(idx)) - 2, emptyBlock, 16) != MFRC522::STATUS_OK) {
-#ifdef NDEF_USE_SERIAL
-                Serial.print(F("Unable to write to sector "));
-                Serial.println(idx);
-#endif
-            }
-        }
-
-        if(_nfcShield->MIFARE_Write((BLOCK_NUMBER_OF_SECTOR_TRAILER(idx)) - 1, emptyBlock, 16) != MFRC522::STATUS_OK) {
-#ifdef NDEF_USE_SERIAL
-            Serial.print(F("Unable to write to sector "));
-            Serial.println(idx);
-#endif
-        }
 
         // Write the trailer block
-        if(_nfcShield->MIFARE_Write((BLOCK_NUMBER_OF_SECTOR_TRAILER(idx)), authBlock, 16) != MFRC522::STATUS_OK) {
+        if(writeBlock(trailer, authBlock, 16) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
             Serial.print(F("Unable to write trailer block of sector "));
             Serial.println(idx);
@@ -348,47 +544,49 @@ bool MifareClassic::formatMifare()
     return true;
 }
 
+// The image goes on the heap rather than the stack, a message can be as large as the tag
 bool MifareClassic::write(NdefMessage & m)
 {
+    PreparedNdefWrite prepared(m);
+    return write(prepared);
+}
 
-    uint8_t encoded[m.getEncodedSize()];
-    m.encode(encoded);
+bool MifareClassic::update(NdefMessage & m)
+{
+    PreparedNdefWrite prepared(m);
+    return prepared.isValid() && updateImage(prepared.image(), prepared.size());
+}
 
-    uint8_t buffer[getBufferSize(sizeof(encoded))];
-    memset(buffer, 0, sizeof(buffer));
+bool MifareClassic::write(const PreparedNdefWrite & prepared)
+{
+    return prepared.isValid() && writeImage(prepared.image(), prepared.size());
+}
 
+// Writes the TLVs the image holds to the NDEF sectors, around their trailers
+bool MifareClassic::writeImage(const byte * image, uint16_t size)
+{
 #ifdef MIFARE_CLASSIC_DEBUG
-    Serial.print(F("sizeof(encoded) "));
-    Serial.println(sizeof(encoded));
-    Serial.print(F("sizeof(buffer) "));
-    Serial.println(sizeof(buffer));
+    Serial.print(F("image size "));
+    Serial.println(size);
 #endif
+    uint64_t sectors = ndefSectors();
 
-    if(sizeof(encoded) < 0xFF) {
-        buffer[0] = 0x3;
-        buffer[1] = sizeof(encoded);
-        memcpy(&buffer[2], encoded, sizeof(encoded));
-        buffer[2 + sizeof(encoded)] = 0xFE; // terminator
-    }
-    else {
-        buffer[0] = 0x3;
-        buffer[1] = 0xFF;
-        buffer[2] = ((sizeof(encoded) >> 8) & 0xFF);
-        buffer[3] = (sizeof(encoded) & 0xFF);
-        memcpy(&buffer[4], encoded, sizeof(encoded));
-        buffer[4 + sizeof(encoded)] = 0xFE; // terminator
+    if(size > _geometry.capacity(sectors)) {
+#ifdef NDEF_USE_SERIAL
+        Serial.println(F("Encoded message length exceeds tag capacity"));
+#endif
+        return false;
     }
 
     // Write to tag
-    unsigned int index = 0;
-    byte currentBlock = 4;
     MFRC522::MIFARE_Key key = {{0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7}};
+    MifareClassicDataBlocks blocks(_geometry, sectors);
 
-    while(index < sizeof(buffer)) {
+    for(uint16_t index = 0; index < size; index += BLOCK_SIZE, blocks.next()) {
+        byte currentBlock = blocks.block();
 
-        if(((currentBlock < 128) && (currentBlock % 4 == 0)) || ((currentBlock >= 128) && (currentBlock % 16 == 0))) {
-            MFRC522::StatusCode status = (MFRC522::StatusCode)_nfcShield->PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A,
-                                                                                           currentBlock, key, _nfcShield->uid);
+        if(blocks.sectorStart()) {
+            MFRC522::StatusCode status = authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, currentBlock, key);
             if(status != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
                 Serial.print(F("Error. Block authentication failed for block "));
@@ -399,7 +597,9 @@ bool MifareClassic::write(NdefMessage & m)
             }
         }
 
-        if(_nfcShield->MIFARE_Write(currentBlock, &buffer[index], BLOCK_SIZE) != MFRC522::STATUS_OK) {
+        byte buffer[BLOCK_SIZE];
+        memcpy(buffer, &image[index], BLOCK_SIZE);
+        if(writeBlock(currentBlock, buffer, BLOCK_SIZE) != MFRC522::STATUS_OK) {
 #ifdef NDEF_USE_SERIAL
             Serial.print(F("Write failed "));
             Serial.println(currentBlock);
@@ -411,24 +611,72 @@ bool MifareClassic::write(NdefMessage & m)
         Serial.print(F("Wrote block "));
         Serial.print(currentBlock);
         Serial.print(" - ");
-        PrintHexChar(&buffer[index], BLOCK_SIZE);
+        PrintHexChar(buffer, BLOCK_SIZE);
 #endif
+    }
 
-        index += BLOCK_SIZE;
-        currentBlock++;
+    return true;
+}
 
-        if(((currentBlock < 128) && ((currentBlock + 1) % 4 == 0)) || ((currentBlock >= 128) &&
-                                                                       ((currentBlock + 1) % 16 == 0))) {
-            // can't write to trailer block
-#ifdef MIFARE_CLASSIC_DEBUG
-            Serial.print(F("Skipping block "));
-            Serial.println(currentBlock);
+// Reads what the blocks hold now and writes those that differ, a block at a time. The first block has the TLV
+// length: before the first other block changes it gets length 0, so a reader never takes half updated blocks for
+// a message, and the new length last.
+bool MifareClassic::updateImage(const byte * image, uint16_t size)
+{
+    MFRC522::MIFARE_Key key = {{0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7}};
+    uint64_t sectors = ndefSectors();
+    if(size > _geometry.capacity(sectors)) {
+        return false;
+    }
+    uint8_t count = size / BLOCK_SIZE;
+    byte first[BLOCK_SIZE + 2];     // the block with the TLV length, as on the tag
+    byte current[BLOCK_SIZE + 2];
+    bool emptied = false;
+
+    MifareClassicDataBlocks blocks(_geometry, sectors);
+    uint16_t firstBlock = blocks.block();
+    for(uint8_t i = 0; i < count; i++, blocks.next()) {
+        byte block = blocks.block();
+        byte * data = i == 0 ? first : current;
+        byte dataSize = BLOCK_SIZE + 2;
+        if(authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, block, key) != MFRC522::STATUS_OK
+           || readBlock(block, data, &dataSize) != MFRC522::STATUS_OK) {
+#ifdef NDEF_USE_SERIAL
+            Serial.print(F("Read failed "));
+            Serial.println(block);
 #endif
-            currentBlock++;
+            return false;
+        }
+        if(i == 0 || memcmp(current, &image[i * BLOCK_SIZE], BLOCK_SIZE) == 0) {
+            continue;
         }
 
+        if(!emptied && !(first[0] == 0x03 && first[1] == 0x00)) {
+            first[0] = 0x03;
+            first[1] = 0x00;
+            if(authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, firstBlock, key) != MFRC522::STATUS_OK
+               || writeBlock(firstBlock, first, BLOCK_SIZE) != MFRC522::STATUS_OK) {
+                return false;
+            }
+        }
+        emptied = true;
+        memcpy(current, &image[i * BLOCK_SIZE], BLOCK_SIZE);
+        if(authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, block, key) != MFRC522::STATUS_OK
+           || writeBlock(block, current, BLOCK_SIZE) != MFRC522::STATUS_OK) {
+#ifdef NDEF_USE_SERIAL
+            Serial.print(F("Write failed "));
+            Serial.println(block);
+#endif
+            return false;
+        }
+    }
+    if(memcmp(first, image, BLOCK_SIZE) != 0) {
+        memcpy(first, image, BLOCK_SIZE);
+        if(authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, firstBlock, key) != MFRC522::STATUS_OK
+           || writeBlock(firstBlock, first, BLOCK_SIZE) != MFRC522::STATUS_OK) {
+            return false;
+        }
     }
-
     return true;
 }
 
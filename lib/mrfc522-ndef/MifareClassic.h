@@ -13,23 +13,197 @@
 #include "MFRC522_I2C.h"
 #include "Ndef.h"
 #include "NfcTag.h"
+#include "NdefStreamDecoder.h"
+#include "PreparedNdefWrite.h"
+#include "MifareKeyResolver.h"
+
+// Sectors and blocks of a MIFARE Classic: the first shortSectors have 4 blocks, the others (4K from sector 32 on)
+// 16; the last block of a sector is its trailer. Sector 0, and 16 on a 4K, hold the MIFARE Application Directory,
+// which tells the sectors with NDEF data; formatNDEF() gives NDEF all others. Sets of sectors are bit masks.
+struct MifareClassicGeometry {
+    byte sectors;
+    byte shortSectors;
+
+    constexpr byte blocksIn(byte sector) const
+    {
+        return sector < shortSectors ? 4 : 16;
+    }
+    constexpr uint16_t firstBlock(byte sector) const
+    {
+        return sector < shortSectors ? sector * 4 : shortSectors * 4 + (sector - shortSectors) * 16;
+    }
+    constexpr uint16_t trailer(byte sector) const
+    {
+        return firstBlock(sector) + blocksIn(sector) - 1;
+    }
+    constexpr uint16_t blocks() const
+    {
+        return firstBlock(sectors);
+    }
+    constexpr bool isMad(byte sector) const
+    {
+        return sector == 0 || (sector == 16 && sectors > 16);
+    }
+    // all sectors but the MAD ones
+    constexpr uint64_t dataSectors() const
+    {
+        return ((((uint64_t)1 << sectors) - 1) & ~(uint64_t)1) & ~(sectors > 16 ? (uint64_t)1 << 16 : 0);
+    }
+    // data bytes in the sectors of mask, from sector on
+    constexpr uint16_t capacity(uint64_t mask, byte sector = 0) const
+    {
+        return sector >= sectors ? 0 : ((mask >> sector) & 1 ? (blocksIn(sector) - 1) * BLOCK_SIZE : 0)
+               + capacity(mask, sector + 1);
+    }
+    // the most an NDEF TLV area can have
+    constexpr uint16_t ndefBytes() const
+    {
+        return capacity(dataSectors());
+    }
+    static constexpr byte sectorOf(uint16_t block)
+    {
+        return block < 128 ? block >> 2 : 32 + ((block - 128) >> 4);
+    }
+};
+
+constexpr MifareClassicGeometry MIFARE_CLASSIC_MINI = { 5, 5 };
+constexpr MifareClassicGeometry MIFARE_CLASSIC_1K = { 16, 16 };
+constexpr MifareClassicGeometry MIFARE_CLASSIC_4K = { 40, 32 };
+
+// Walks the data blocks of a set of sectors in order, trailers left out
+class MifareClassicDataBlocks
+{
+    public:
+        MifareClassicDataBlocks(const MifareClassicGeometry & geometry, uint64_t sectors)
+            : _geometry(geometry), _sectors(sectors), _sector(0)
+        {
+            nextSector();
+        };
+        MifareClassicDataBlocks(const MifareClassicGeometry & geometry)
+            : MifareClassicDataBlocks(geometry, geometry.dataSectors()) {};
+        uint16_t block() const
+        {
+            return _block;
+        };
+        byte sector() const
+        {
+            return _sector;
+        };
+        bool atEnd() const
+        {
+            return _sector >= _geometry.sectors;
+        };
+        // the block is the first of its sector
+        bool sectorStart() const
+        {
+            return _block == _geometry.firstBlock(_sector);
+        };
+        void next()
+        {
+            if(++_block == _geometry.trailer(_sector)) {
+                nextSector();
+            }
+        };
+    private:
+        void nextSector()
+        {
+            do {
+                _sector++;
+            } while(_sector < _geometry.sectors && !((_sectors >> _sector) & 1));
+            _block = _geometry.firstBlock(_sector);
+        };
+        const MifareClassicGeometry & _geometry;
+        uint64_t _sectors;
+        byte _sector;
+        uint16_t _block;
+};
+
+// The sector the card is authenticated for, with which key, so operations on the same selected tag only
+// authenticate when they cross into another sector. Whoever ends the Crypto1 session (selects or halts the tag,
+// PCD_StopCrypto1()) must reset() it; NfcAdapter does for its own.
+// Also the NDEF sectors of the last tag whose MAD was read, which reset() keeps: they belong to the UID.
+class MifareClassicSession
+{
+    public:
+        MifareClassicSession() : authentications(0), skipped(0), _sector(NO_SECTOR), _madUidSize(0) {};
+        void reset()
+        {
+            _sector = NO_SECTOR;
+        };
+        bool isAuthenticated(byte command, byte block, const MFRC522::MIFARE_Key & key) const;
+        void authenticated(byte command, byte block, const MFRC522::MIFARE_Key & key);
+        // the MAD of the tag with uid (and its SAK) was read, ndefSectors() has its NDEF sectors
+        bool knowsMad(const MFRC522::Uid & uid) const;
+        void madRead(const MFRC522::Uid & uid, uint64_t ndefSectors);
+        void forgetMad()
+        {
+            _madUidSize = 0;
+        };
+        uint64_t ndefSectors() const
+        {
+            return _ndefSectors;
+        };
+
+        uint32_t authentications;   // PCD_Authenticate round trips done
+        uint32_t skipped;           // round trips saved, the sector was still authenticated
+    private:
+        static const byte NO_SECTOR = 0xFF;
+        byte _sector;
+        byte _command;
+        MFRC522::MIFARE_Key _key;
+        byte _madUid[10];
+        byte _madUidSize;
+        byte _madSak;
+        uint64_t _ndefSectors;
+};
 
 class MifareClassic
 {
     public:
-        MifareClassic(MFRC522 * nfcShield, const MFRC522::MIFARE_Key & key)
-            : _nfcShield(nfcShield), _key(key) {};
+        // reads authenticate with key A key, or with the keys of keys if there is a provider
+        MifareClassic(MFRC522 * nfcShield, const MFRC522::MIFARE_Key & key, MifareClassicSession * session = NULL,
+                      NdefAllocator * allocator = NULL, MifareKeyProvider * keys = NULL)
+            : _nfcShield(nfcShield), _geometry(geometryOf(nfcShield->PICC_GetType(nfcShield->uid.sak))), _key(key),
+              _session(session), _allocator(allocator), _keys(keys) {};
         ~MifareClassic();
         NfcTag read();
+        // feeds the NDEF sectors to decoder block by block, up to the end of the message; false if there is none
+        bool read(NdefStreamDecoder & decoder);
         bool write(NdefMessage & ndefMessage);
+        bool write(const PreparedNdefWrite & prepared);
+        // write only the blocks that differ from the message on the tag
+        bool update(NdefMessage & ndefMessage);
         bool formatNDEF();
         bool formatMifare();
+        // Mini, 4K or else 1K
+        static const MifareClassicGeometry & geometryOf(byte piccType);
+        // CRC-8 of a MIFARE Application Directory over its info byte and AIDs
+        static byte madCrc(const byte * data, byte length);
     private:
         MFRC522 * _nfcShield;
+        const MifareClassicGeometry & _geometry;
         int getBufferSize(int messageLength);
         int getNdefStartIndex(byte * data);
         bool decodeTlv(byte * data, int * messageLength, int * messageStartIndex);
+        bool writeMad(byte madSector, const MFRC522::MIFARE_Key & key);
+        bool readMadSector(byte madSector, const MFRC522::MIFARE_Key & key, byte * data);
+        bool readMad(uint64_t * sectors);
+        uint64_t ndefSectors();
+        MifareClassicSession & session()
+        {
+            return _session ? *_session : _ownSession;
+        };
+        MFRC522::StatusCode authenticate(byte command, byte block, const MFRC522::MIFARE_Key & key);
+        MFRC522::StatusCode authenticateRead(byte block);
+        MFRC522::StatusCode readBlock(byte block, byte * buffer, byte * bufferSize);
+        MFRC522::StatusCode writeBlock(byte block, byte * buffer, byte bufferSize);
+        bool writeImage(const byte * image, uint16_t size);
+        bool updateImage(const byte * image, uint16_t size);
         const MFRC522::MIFARE_Key & _key;
+        MifareClassicSession * _session;    // shared with other operations on the tag, or NULL for _ownSession
+        MifareClassicSession _ownSession;
+        NdefAllocator * _allocator;         // for the NfcTag read() returns
+        MifareKeyProvider * _keys;          // the keys reads try, or NULL for _key
 
 };
 
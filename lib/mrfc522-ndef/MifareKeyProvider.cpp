@@ -0,0 +1,44 @@
+#include "MifareKeyProvider.h"
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+
+#define MIFARE_DIVERSIFICATION_MAX_SYSTEM_ID 16
+
+MifareDiversifiedKeys::MifareDiversifiedKeys(const byte * masterKey, byte command, const byte * systemId,
+        byte systemIdLength)
+    : _cmac(masterKey), _command(command), _systemId(systemId)
+{
+    _systemIdLength = systemIdLength < MIFARE_DIVERSIFICATION_MAX_SYSTEM_ID ? systemIdLength
+                      : MIFARE_DIVERSIFICATION_MAX_SYSTEM_ID;
+}
+
+// AN10922 2.2: the diversification input is at most 31 bytes after the constant, the CMAC runs over 2 blocks
+void MifareDiversifiedKeys::diversify(const MFRC522::Uid & uid, byte sector, byte command, byte * out) const
+{
+    byte input[2 * AES_BLOCK_SIZE];
+    byte length = 0;
+    input[length++] = 0x01;
+    memcpy(&input[length], uid.uidByte, uid.size);
+    length += uid.size;
+    input[length++] = sector;
+    input[length++] = command;
+    if(_systemIdLength) {
+        memcpy(&input[length], _systemId, _systemIdLength);
+        length += _systemIdLength;
+    }
+    _cmac.mac(input, length, 2, out);
+}
+
+bool MifareDiversifiedKeys::key(const MFRC522::Uid & uid, byte sector, byte candidate, MifareSectorKey & key)
+{
+    if(candidate > 0) {
+        return false;
+    }
+    byte diversified[AES_BLOCK_SIZE];
+    diversify(uid, sector, _command, diversified);
+    key.command = _command;
+    memcpy(key.key.keyByte, diversified, MFRC522::MF_KEY_SIZE);
+    key.ref = 0;
+    return true;
+}
+
+#endif
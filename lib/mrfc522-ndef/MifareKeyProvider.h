@@ -0,0 +1,53 @@
+#ifndef MifareKeyProvider_h
+#define MifareKeyProvider_h
+
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+
+#include "MFRC522_I2C.h"
+#include "AesCmac.h"
+
+// A key to authenticate a sector with
+struct MifareSectorKey {
+    byte command;               // PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+    MFRC522::MIFARE_Key key;
+    byte ref;                   // the provider's own, eg which key of its ring
+};
+
+// The keys of the sectors of a tag, for MifareClassic reads. They try candidate 0, 1, ... of a sector until one
+// authenticates, then tell opened(), or key() returns false, then tell failed(); the tag is reselected after each
+// failure.
+class MifareKeyProvider
+{
+    public:
+        virtual ~MifareKeyProvider() {};
+        // the candidate-th key for sector of uid; false when there are no more
+        virtual bool key(const MFRC522::Uid & uid, byte sector, byte candidate, MifareSectorKey & key) = 0;
+        // key opened sector of uid
+        virtual void opened(const MFRC522::Uid &, byte, const MifareSectorKey &) {};
+        // none of the keys opened sector of uid
+        virtual void failed(const MFRC522::Uid &, byte) {};
+        // the operation is over, eg save what was learned
+        virtual void flush() {};
+};
+
+// Keys diversified from the UID with AES-128 CMAC, as NXP AN10922 does for AES keys: the CMAC under the master key
+// of 0x01 || UID || sector || key type (0x60 A, 0x61 B) || system identifier, padded to 32 bytes. A MIFARE Classic
+// key is its first 6 bytes.
+class MifareDiversifiedKeys : public MifareKeyProvider
+{
+    public:
+        // systemId (up to 16 bytes) is not copied
+        MifareDiversifiedKeys(const byte * masterKey, byte command = MFRC522::PICC_CMD_MF_AUTH_KEY_A,
+                              const byte * systemId = NULL, byte systemIdLength = 0);
+        bool key(const MFRC522::Uid & uid, byte sector, byte candidate, MifareSectorKey & key) override;
+        // the diversified AES key for uid, sector and command, 16 bytes
+        void diversify(const MFRC522::Uid & uid, byte sector, byte command, byte * out) const;
+    private:
+        AesCmac _cmac;
+        byte _command;
+        const byte * _systemId;
+        byte _systemIdLength;
+};
+
+#endif
+#endif
@@ -0,0 +1,162 @@
+#include "MifareKeyResolver.h"
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+#ifdef ESP_PLATFORM
+    #include <nvs.h>
+#endif
+
+#ifdef ESP_PLATFORM
+bool MifareKeyNvs::load(byte slot, void * data, size_t size)
+{
+    char name[8];
+    nvs_handle_t handle;
+    snprintf(name, sizeof(name), "tag%u", slot);
+    if(nvs_open(_namespace, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    size_t length = size;
+    bool ok = nvs_get_blob(handle, name, data, &length) == ESP_OK && length == size;
+    nvs_close(handle);
+    return ok;
+}
+
+bool MifareKeyNvs::save(byte slot, const void * data, size_t size)
+{
+    char name[8];
+    nvs_handle_t handle;
+    snprintf(name, sizeof(name), "tag%u", slot);
+    if(nvs_open(_namespace, NVS_READWRITE, &handle) != ESP_OK) {
+        return false;
+    }
+    bool ok = nvs_set_blob(handle, name, data, size) == ESP_OK && nvs_commit(handle) == ESP_OK;
+    nvs_close(handle);
+    return ok;
+}
+#endif
+
+MifareKeyResolver::MifareKeyResolver(MifareKeyStorage * storage)
+    : hits(0), misses(0), saves(0), _storage(storage), _keyCount(0), _clock(0)
+{
+    memset(_entries, 0, sizeof(_entries));
+    memset(_dirty, 0, sizeof(_dirty));
+}
+
+bool MifareKeyResolver::addKey(const MFRC522::MIFARE_Key & key)
+{
+    if(_keyCount >= MIFARE_KEY_RING_SIZE) {
+        return false;
+    }
+    _keys[_keyCount++] = key;
+    return true;
+}
+
+void MifareKeyResolver::begin()
+{
+    for(byte slot = 0; _storage && slot < MIFARE_KEY_CACHE_TAGS; slot++) {
+        MifareKeyCacheEntry & entry = _entries[slot];
+        if(!_storage->load(slot, &entry, sizeof(entry))
+           || (entry.uidSize != 4 && entry.uidSize != 7 && entry.uidSize != 10)) {
+            memset(&entry, 0, sizeof(entry));
+        }
+        if(entry.used > _clock) {
+            _clock = entry.used;
+        }
+    }
+}
+
+MifareKeyCacheEntry * MifareKeyResolver::find(const MFRC522::Uid & uid)
+{
+    for(byte slot = 0; slot < MIFARE_KEY_CACHE_TAGS; slot++) {
+        MifareKeyCacheEntry & entry = _entries[slot];
+        if(entry.uidSize == uid.size && memcmp(entry.uid, uid.uidByte, uid.size) == 0) {
+            return &entry;
+        }
+    }
+    return NULL;
+}
+
+void MifareKeyResolver::flush()
+{
+    for(byte slot = 0; slot < MIFARE_KEY_CACHE_TAGS; slot++) {
+        if(_dirty[slot] && _storage && _storage->save(slot, &_entries[slot], sizeof(_entries[slot]))) {
+            saves++;
+        }
+        _dirty[slot] = false;
+    }
+}
+
+// Ring position 2 * index for key A, 2 * index + 1 for key B
+void MifareKeyResolver::ringKey(byte position, MifareSectorKey & key) const
+{
+    key.command = position & 1 ? MFRC522::PICC_CMD_MF_AUTH_KEY_B : MFRC522::PICC_CMD_MF_AUTH_KEY_A;
+    key.key = _keys[position >> 1];
+    key.ref = position;
+}
+
+bool MifareKeyResolver::key(const MFRC522::Uid & uid, byte sector, byte candidate, MifareSectorKey & key)
+{
+    MifareKeyCacheEntry * entry = find(uid);
+    byte known = entry && sector < MIFARE_CLASSIC_MAX_SECTORS ? entry->sectors[sector] : MIFARE_KEY_UNKNOWN;
+    byte cached = 0xFF;
+    if(known != MIFARE_KEY_UNKNOWN && (known & ~MIFARE_KEY_TYPE_B) < _keyCount) {
+        cached = ((known & ~MIFARE_KEY_TYPE_B) << 1) | (known & MIFARE_KEY_TYPE_B ? 1 : 0);
+    }
+    if(cached != 0xFF) {
+        if(candidate == 0) {
+            hits++;
+            entry->used = ++_clock;
+            ringKey(cached, key);
+            return true;
+        }
+        // then the rest of the ring
+        candidate--;
+        if(candidate >= cached) {
+            candidate++;
+        }
+    }
+    else if(candidate == 0) {
+        misses++;
+    }
+    if(candidate >= 2 * _keyCount) {
+        return false;
+    }
+    ringKey(candidate, key);
+    return true;
+}
+
+void MifareKeyResolver::opened(const MFRC522::Uid & uid, byte sector, const MifareSectorKey & key)
+{
+    if(sector >= MIFARE_CLASSIC_MAX_SECTORS) {
+        return;
+    }
+    MifareKeyCacheEntry * entry = find(uid);
+    if(!entry) {
+        // a free entry, else the least recently used
+        entry = _entries;
+        for(byte slot = 1; slot < MIFARE_KEY_CACHE_TAGS && entry->uidSize != 0; slot++) {
+            if(_entries[slot].uidSize == 0 || _entries[slot].used < entry->used) {
+                entry = &_entries[slot];
+            }
+        }
+        memset(entry, 0, sizeof(*entry));
+        memset(entry->sectors, MIFARE_KEY_UNKNOWN, sizeof(entry->sectors));
+        memcpy(entry->uid, uid.uidByte, uid.size);
+        entry->uidSize = uid.size;
+    }
+    entry->used = ++_clock;
+    byte known = (key.ref >> 1) | (key.ref & 1 ? MIFARE_KEY_TYPE_B : 0);
+    if(entry->sectors[sector] != known) {
+        entry->sectors[sector] = known;
+        _dirty[entry - _entries] = true;
+    }
+}
+
+void MifareKeyResolver::failed(const MFRC522::Uid & uid, byte sector)
+{
+    MifareKeyCacheEntry * entry = find(uid);
+    if(entry && sector < MIFARE_CLASSIC_MAX_SECTORS && entry->sectors[sector] != MIFARE_KEY_UNKNOWN) {
+        entry->sectors[sector] = MIFARE_KEY_UNKNOWN;
+        _dirty[entry - _entries] = true;
+    }
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef MifareKeyResolver_h
+#define MifareKeyResolver_h
+
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+
+#include "MifareKeyProvider.h"
+
+// The most keys in a ring
+#ifndef MIFARE_KEY_RING_SIZE
+#define MIFARE_KEY_RING_SIZE 8
+#endif
+// Tags the cache remembers, the least recently used goes first
+#ifndef MIFARE_KEY_CACHE_TAGS
+#define MIFARE_KEY_CACHE_TAGS 16
+#endif
+
+#define MIFARE_CLASSIC_MAX_SECTORS 40
+#define MIFARE_KEY_UNKNOWN 0xFF
+#define MIFARE_KEY_TYPE_B 0x80
+
+// Which ring key, and key type, opened each sector of a tag
+struct MifareKeyCacheEntry {
+    byte uid[10];
+    byte uidSize;                               // 0 for a free entry
+    uint32_t used;                              // the entry with the lowest is evicted first
+    byte sectors[MIFARE_CLASSIC_MAX_SECTORS];   // ring index, | MIFARE_KEY_TYPE_B, or MIFARE_KEY_UNKNOWN
+};
+
+// Where the cache survives a restart: one record per entry. Entries are saved by flush() when they learned or lost a
+// key, not when they are used, so flash wears with new tags and keys only.
+class MifareKeyStorage
+{
+    public:
+        virtual ~MifareKeyStorage() {};
+        // false if slot holds nothing of size bytes
+        virtual bool load(byte slot, void * data, size_t size) = 0;
+        virtual bool save(byte slot, const void * data, size_t size) = 0;
+};
+
+#ifdef ESP_PLATFORM
+// The cache in ESP32 NVS, a blob per entry in namespace; NVS must be initialised (the Arduino core does)
+class MifareKeyNvs : public MifareKeyStorage
+{
+    public:
+        MifareKeyNvs(const char * nvsNamespace = "mfkeys") : _namespace(nvsNamespace) {};
+        bool load(byte slot, void * data, size_t size) override;
+        bool save(byte slot, const void * data, size_t size) override;
+    private:
+        const char * _namespace;
+};
+#endif
+
+// The keys a site uses, and per tag and sector which one worked. The cached key is the first candidate, so a tag
+// seen before costs one authentication per sector; then each other key of the ring, key A then key B.
+class MifareKeyResolver : public MifareKeyProvider
+{
+    public:
+        MifareKeyResolver(MifareKeyStorage * storage = NULL);
+        // add a key to the ring; false when it is full. Cached indexes refer to the ring, keep its order.
+        bool addKey(const MFRC522::MIFARE_Key & key);
+        byte keyCount() const
+        {
+            return _keyCount;
+        };
+        const MFRC522::MIFARE_Key & ringKey(byte index) const
+        {
+            return _keys[index];
+        };
+        // load the cache from the storage
+        void begin();
+        bool key(const MFRC522::Uid & uid, byte sector, byte candidate, MifareSectorKey & key) override;
+        void opened(const MFRC522::Uid & uid, byte sector, const MifareSectorKey & key) override;
+        // forgets the key of sector, the tag was given another
+        void failed(const MFRC522::Uid & uid, byte sector) override;
+        // save the entries that changed
+        void flush() override;
+
+        uint32_t hits;          // sectors the cache had a key for
+        uint32_t misses;        // sectors it did not
+        uint32_t saves;         // entries written to the storage
+    private:
+        MifareKeyCacheEntry * find(const MFRC522::Uid & uid);
+        void ringKey(byte position, MifareSectorKey & key) const;
+        MifareKeyStorage * _storage;
+        MFRC522::MIFARE_Key _keys[MIFARE_KEY_RING_SIZE];
+        byte _keyCount;
+        uint32_t _clock;        // use stamp of the last cache hit or key learned
+        MifareKeyCacheEntry _entries[MIFARE_KEY_CACHE_TAGS];
+        bool _dirty[MIFARE_KEY_CACHE_TAGS];
+};
+
+#endif
+#endif
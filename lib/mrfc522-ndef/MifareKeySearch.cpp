@@ -0,0 +1,80 @@
+#include "MifareKeySearch.h"
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+
+static_assert(MIFARE_CLASSIC_4K.sectors <= MIFARE_CLASSIC_MAX_SECTORS, "MIFARE Classic sectors");
+
+bool MifareKeyTable::next(MFRC522::MIFARE_Key & key)
+{
+    if(_index >= _count) {
+        return false;
+    }
+    for(byte i = 0; i < MFRC522::MF_KEY_SIZE; i++) {
+        key.keyByte[i] = pgm_read_byte(&_keys[_index][i]);
+    }
+    _index++;
+    return true;
+}
+
+bool MifareKeySearch::complete() const
+{
+    for(byte sector = 0; sector < _sectors; sector++) {
+        if(!_keys[sector].hasKeyA || !_keys[sector].hasKeyB) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MifareKeySearch::search(MifareKeySource & keys)
+{
+    byte piccType = _mfrc522->PICC_GetType(_mfrc522->uid.sak);
+    tried = 0;
+    elapsedUs = 0;
+    _sectors = 0;
+    if(piccType != MFRC522::PICC_TYPE_MIFARE_MINI && piccType != MFRC522::PICC_TYPE_MIFARE_1K
+       && piccType != MFRC522::PICC_TYPE_MIFARE_4K) {
+        return false;
+    }
+    _geometry = &MifareClassic::geometryOf(piccType);
+    _sectors = _geometry->sectors;
+    memset(_keys, 0, sizeof(_keys));
+
+    uint32_t timeoutUs = _mfrc522->PCD_GetTimeout();
+    unsigned long start = micros();
+    _mfrc522->PCD_SetTimeout(MIFARE_KEY_SEARCH_TIMEOUT_US);
+    bool present = true;
+    bool authenticated = false;
+    MFRC522::MIFARE_Key key;
+    while(present && !complete() && keys.next(key)) {
+        for(byte sector = 0; present && sector < _sectors; sector++) {
+            for(byte command = MFRC522::PICC_CMD_MF_AUTH_KEY_A; command <= MFRC522::PICC_CMD_MF_AUTH_KEY_B; command++) {
+                MifareSectorKeys & found = _keys[sector];
+                bool & has = command == MFRC522::PICC_CMD_MF_AUTH_KEY_A ? found.hasKeyA : found.hasKeyB;
+                if(has) {
+                    continue;
+                }
+                tried++;
+                authenticated = _mfrc522->PCD_Authenticate(command, _geometry->trailer(sector), key, _mfrc522->uid)
+                                == MFRC522::STATUS_OK;
+                if(authenticated) {
+                    has = true;
+                    (command == MFRC522::PICC_CMD_MF_AUTH_KEY_A ? found.keyA : found.keyB) = key;
+                }
+                // the tag went IDLE and ignores everything but REQA/WUPA
+                else if(_mfrc522->PICC_Reselect(&_mfrc522->uid) != MFRC522::STATUS_OK) {
+                    present = false;
+                    break;
+                }
+            }
+        }
+    }
+    // end the last authentication, if it worked
+    if(authenticated) {
+        present = _mfrc522->PICC_Reselect(&_mfrc522->uid) == MFRC522::STATUS_OK;
+    }
+    _mfrc522->PCD_SetTimeout(timeoutUs);
+    elapsedUs = micros() - start;
+    return present;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef MifareKeySearch_h
+#define MifareKeySearch_h
+
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+
+#include "MifareClassic.h"
+
+// How long a search waits for the answer to an authentication: a tag given a wrong key never answers
+#ifndef MIFARE_KEY_SEARCH_TIMEOUT_US
+#define MIFARE_KEY_SEARCH_TIMEOUT_US 2000
+#endif
+
+// Where the keys a search tries come from, one after the other: a table, a file, a generator. The search reads
+// them once, so a dictionary never has to fit in RAM.
+class MifareKeySource
+{
+    public:
+        virtual ~MifareKeySource() {};
+        // the next key, false when there are no more
+        virtual bool next(MFRC522::MIFARE_Key & key) = 0;
+};
+
+// Keys in a table, in RAM or in flash (PROGMEM)
+class MifareKeyTable : public MifareKeySource
+{
+    public:
+        MifareKeyTable(const byte (*keys)[MFRC522::MF_KEY_SIZE], uint32_t count)
+            : _keys(keys), _count(count), _index(0) {};
+        bool next(MFRC522::MIFARE_Key & key);
+        void rewind()
+        {
+            _index = 0;
+        };
+    private:
+        const byte (*_keys)[MFRC522::MF_KEY_SIZE];
+        uint32_t _count;
+        uint32_t _index;
+};
+
+struct MifareSectorKeys {
+    MFRC522::MIFARE_Key keyA;
+    MFRC522::MIFARE_Key keyB;
+    bool hasKeyA;
+    bool hasKeyB;
+};
+
+// Finds key A and key B of every sector of the selected MIFARE Classic in a dictionary. Each key goes to all
+// sectors still open before the next is read; a failed authentication leaves the tag IDLE, a reselect (HLTA, WUPA,
+// SELECT with the known UID) gets it back without the anticollision loop. The PCD timeout is cut to
+// MIFARE_KEY_SEARCH_TIMEOUT_US meanwhile, and set back to what it was after.
+class MifareKeySearch
+{
+    public:
+        MifareKeySearch(MFRC522 * mfrc522) : tried(0), elapsedUs(0), _mfrc522(mfrc522), _sectors(0) {};
+        // tries keys until every key of the tag is known or they run out; false if the tag is not a MIFARE Classic
+        // or left the field. The tag is left selected, not authenticated.
+        bool search(MifareKeySource & keys);
+        byte sectors() const
+        {
+            return _sectors;
+        };
+        const MifareSectorKeys & sector(byte sector) const
+        {
+            return _keys[sector];
+        };
+        // all keys of the tag found
+        bool complete() const;
+        uint32_t keysPerSecond() const
+        {
+            return elapsedUs ? (uint64_t)tried * 1000000 / elapsedUs : 0;
+        };
+
+        uint32_t tried;         // authentications tried by the last search
+        uint32_t elapsedUs;     // how long it took
+    private:
+        MFRC522 * _mfrc522;
+        const MifareClassicGeometry * _geometry;
+        byte _sectors;
+        MifareSectorKeys _keys[MIFARE_CLASSIC_MAX_SECTORS];
+};
+
+#endif
+#endif
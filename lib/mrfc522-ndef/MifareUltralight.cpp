@@ -1,8 +1,14 @@
 #include "MifareUltralight.h"
 
-MifareUltralight::MifareUltralight(MFRC522 * nfcShield)
+MifareUltralight::MifareUltralight(MFRC522 * nfcShield, NdefAllocator * ndefAllocator)
 {
     nfc = nfcShield;
+    allocator = ndefAllocator;
+    writeProbed = false;
+    compatibilityWrite = false;
+    versionProbed = false;
+    fastRead = false;
+    tagCapacity = 0;
 }
 
 MifareUltralight::~MifareUltralight()
@@ -11,6 +17,9 @@ MifareUltralight::~MifareUltralight()
 
 NfcTag MifareUltralight::read()
 {
+    if(!readHeader()) {
+        return NfcTag(nfc->uid.uidByte, nfc->uid.size, NfcTag::TYPE_2);
+    }
     if(isUnformatted()) {
 #ifdef NDEF_USE_SERIAL
         Serial.println(F("WARNING: Tag is not formatted."));
@@ -22,115 +31,227 @@ NfcTag MifareUltralight::read()
     uint16_t ndefStartIndex = 0;
     findNdefMessage(&messageLength, &ndefStartIndex);
 
-    uint16_t bufferSize = calculateBufferSize(messageLength, ndefStartIndex);
-
     if(messageLength == 0) {  // data is 0x44 0x03 0x00 0xFE
-        NdefMessage message = NdefMessage();
+        NdefMessage message = NdefMessage(allocator);
         message.addEmptyRecord();
-        return NfcTag(nfc->uid.uidByte, nfc->uid.size, NfcTag::TYPE_2, message);
+        return NfcTag(nfc->uid.uidByte, nfc->uid.size, NfcTag::TYPE_2, message, allocator);
     }
 
-    uint8_t index = 0;
-    byte buffer[bufferSize];
-    for(uint8_t page = ULTRALIGHT_DATA_START_PAGE; page < ULTRALIGHT_MAX_PAGE;
-        page += (ULTRALIGHT_READ_SIZE / ULTRALIGHT_PAGE_SIZE)) {
-        // read the data
-        byte dataSize = ULTRALIGHT_READ_SIZE + 2;
-        MFRC522::StatusCode status = (MFRC522::StatusCode)nfc->MIFARE_Read(page, &buffer[index], &dataSize);
-        if(status == MFRC522::STATUS_OK) {
-#ifdef MIFARE_ULTRALIGHT_DEBUG
-            Serial.print(F("Page "));
-            Serial.print(page);
-            Serial.print(" ");
-            PrintHexChar(&buffer[index], ULTRALIGHT_PAGE_SIZE);
-            PrintHexChar(&buffer[index + ULTRALIGHT_PAGE_SIZE], ULTRALIGHT_PAGE_SIZE);
-            PrintHexChar(&buffer[index + 2 * ULTRALIGHT_PAGE_SIZE], ULTRALIGHT_PAGE_SIZE);
-            PrintHexChar(&buffer[index + 3 * ULTRALIGHT_PAGE_SIZE], ULTRALIGHT_PAGE_SIZE);
+    // more than two READs to go: find out whether FAST_READ does it in fewer frames, GET_VERSION also tells the
+    // capacity. The TLV, its length from the tag and the terminator have to fit before anything is sized by it.
+    uint8_t cached = (ULTRALIGHT_READ_SIZE / ULTRALIGHT_PAGE_SIZE) - 1;
+    uint32_t end = (uint32_t)ndefStartIndex + messageLength;
+    uint32_t twoReads = (cached + 2 * (ULTRALIGHT_READ_SIZE / ULTRALIGHT_PAGE_SIZE)) * ULTRALIGHT_PAGE_SIZE;
+    if(end > twoReads && !identify()) {
+        return NfcTag(nfc->uid.uidByte, nfc->uid.size, NfcTag::TYPE_2);
+    }
+    if(end + 1 > tagCapacity) {
+#ifdef NDEF_USE_SERIAL
+        Serial.println(F("Message length exceeds tag capacity"));
 #endif
+        return NfcTag(nfc->uid.uidByte, nfc->uid.size, NfcTag::TYPE_2);
+    }
+
+    // the message goes straight into the storage of the tag, only a frame is buffered
+    NfcTag tag(nfc->uid.uidByte, nfc->uid.size, NfcTag::TYPE_2, NULL, 0, allocator);
+    byte * message = tag.allocateNdefData(messageLength);
+    if(!message) {
+        return tag;
+    }
+
+    // pages 4-6 came with the header, the message starts in them; read the rest of it
+    uint16_t cachedLength = cached * ULTRALIGHT_PAGE_SIZE - ndefStartIndex;
+    cachedLength = cachedLength < messageLength ? cachedLength : messageLength;
+    memcpy(message, &header[ULTRALIGHT_PAGE_SIZE + ndefStartIndex], cachedLength);
+    uint8_t pages = (end + ULTRALIGHT_PAGE_SIZE - 1) / ULTRALIGHT_PAGE_SIZE;
+    if(pages > cached && !readPages(ULTRALIGHT_DATA_START_PAGE + cached, pages - cached, &message[cachedLength],
+                                    messageLength - cachedLength)) {
+        return NfcTag(nfc->uid.uidByte, nfc->uid.size, NfcTag::TYPE_2);
+    }
+    return tag;
+}
+
+// The header READ brings pages 4-6, then as many pages as the NDEF TLV has left, FAST_READ if the tag knows it.
+// Only one frame is buffered whatever the message length.
+boolean MifareUltralight::read(NdefStreamDecoder & decoder)
+{
+    if(!readHeader() || isUnformatted()) {
+        return false;
+    }
+    uint8_t cached = (ULTRALIGHT_READ_SIZE / ULTRALIGHT_PAGE_SIZE) - 1;
+    decoder.feed(&header[ULTRALIGHT_PAGE_SIZE], cached * ULTRALIGHT_PAGE_SIZE);
+
+    uint16_t page = ULTRALIGHT_DATA_START_PAGE + cached;
+    while(!decoder.done()) {
+        // until the NDEF TLV length is known (lock and memory TLVs first), a READ worth at a time
+        uint16_t remaining = decoder.remaining();
+        uint16_t count = remaining ? (remaining + ULTRALIGHT_PAGE_SIZE - 1) / ULTRALIGHT_PAGE_SIZE
+                         : ULTRALIGHT_READ_SIZE / ULTRALIGHT_PAGE_SIZE;
+        if(count > 2 * (ULTRALIGHT_READ_SIZE / ULTRALIGHT_PAGE_SIZE) && !identify()) {
+            return false;
         }
-        else {
+        uint16_t end = ULTRALIGHT_DATA_START_PAGE + tagCapacity / ULTRALIGHT_PAGE_SIZE;
+        if(page + count > end) {
+            count = end > page ? end - page : 0;
+        }
+        if(count == 0) {
 #ifdef NDEF_USE_SERIAL
-            Serial.print(F("Read failed "));
-            Serial.println(page);
+            Serial.println(F("Message length exceeds tag capacity"));
 #endif
-            return NfcTag(nfc->uid.uidByte, nfc->uid.size, NfcTag::TYPE_2);
+            return false;
         }
-
-        if(index >= (messageLength + ndefStartIndex)) {
-            break;
+        if(!readPages(page, count, NULL, 0, &decoder)) {
+            return false;
         }
-
-        index += ULTRALIGHT_READ_SIZE;
+        page += count;
     }
-
-    return NfcTag(nfc->uid.uidByte, nfc->uid.size, NfcTag::TYPE_2, &buffer[ndefStartIndex], messageLength);
-
+    return decoder.complete();
 }
 
-boolean MifareUltralight::isUnformatted()
+// One READ gets page 3 with the capabilities and pages 4-6, which is enough to find the ndef message
+boolean MifareUltralight::readHeader()
 {
-    uint8_t page = 4;
-    byte dataSize = ULTRALIGHT_READ_SIZE + 2;
-    byte data[dataSize];
-    MFRC522::StatusCode status = (MFRC522::StatusCode)nfc->MIFARE_Read(page, data, &dataSize);
-    if(status == MFRC522::STATUS_OK && dataSize >= 4) {
-        return (data[0] == 0xFF && data[1] == 0xFF && data[2] == 0xFF && data[3] == 0xFF);
-    }
-    else {
+    byte dataSize = sizeof(header);
+    MFRC522::StatusCode status = nfc->MIFARE_Read(ULTRALIGHT_CC_PAGE, header, &dataSize);
+    if(status != MFRC522::STATUS_OK || dataSize < ULTRALIGHT_READ_SIZE) {
 #ifdef NDEF_USE_SERIAL
         Serial.print(F("Error. Failed read page "));
-        Serial.println(page);
+        Serial.println(ULTRALIGHT_CC_PAGE);
 #endif
         return false;
     }
+
+    // See AN1303 - different rules for Mifare Family byte2 = (additional data + 48)/8
+    tagCapacity = header[2] * 8;
+    // READ and WRITE address 256 pages, more would need SECTOR_SELECT
+    if(tagCapacity > (256 - ULTRALIGHT_DATA_START_PAGE) * ULTRALIGHT_PAGE_SIZE) {
+        tagCapacity = (256 - ULTRALIGHT_DATA_START_PAGE) * ULTRALIGHT_PAGE_SIZE;
+    }
+#ifdef MIFARE_ULTRALIGHT_DEBUG
+    Serial.println(F("Pages 3-6"));
+    PrintHexChar(header, ULTRALIGHT_READ_SIZE);
+    Serial.print(F("Tag capacity "));
+    Serial.print(tagCapacity);
+    Serial.println(F(" bytes"));
+#endif
+    // TODO future versions should get lock information
+    return true;
 }
 
-// page 3 has tag capabilities
-uint16_t MifareUltralight::readTagSize()
+// NTAG21x and Ultralight EV1 answer GET_VERSION and know FAST_READ, their version tells the user memory size.
+// Other tags stay silent and go IDLE, so they are selected again.
+boolean MifareUltralight::identify()
 {
-    uint16_t tagCapacity = 0;
-    byte dataSize = ULTRALIGHT_READ_SIZE + 2;
-    byte data[ULTRALIGHT_PAGE_SIZE];
-    MFRC522::StatusCode status = (MFRC522::StatusCode)nfc->MIFARE_Read(3, data, &dataSize);
-    if(status == MFRC522::STATUS_OK && dataSize >= 2) {
-        // See AN1303 - different rules for Mifare Family byte2 = (additional data + 48)/8
-        tagCapacity = data[2] * 8;
+    if(versionProbed) {
+        return true;
+    }
+    versionProbed = true;
+
+    byte version[10];
+    byte size = sizeof(version);
+    if(nfc->MIFARE_Ultralight_GetVersion(version, &size) != MFRC522::STATUS_OK || size < 8) {
+        return nfc->PICC_Reselect(&nfc->uid) == MFRC522::STATUS_OK;
+    }
+
+    // vendor NXP, product type NTAG or Ultralight, storage size
+    fastRead = version[1] == 0x04 && (version[2] == 0x04 || version[2] == 0x03);
+    if(fastRead) {
+        static const byte storage[] = { 0x0B, 0x0E, 0x0F, 0x11, 0x13 };
+        static const uint16_t capacity[] = { 48, 128, 144, 504, 888 };   // MF0UL11, MF0UL21, NTAG213/215/216
+        for(uint8_t i = 0; i < sizeof(storage); i++) {
+            if(version[6] == storage[i]) {
+                tagCapacity = capacity[i];
+            }
+        }
+    }
 #ifdef MIFARE_ULTRALIGHT_DEBUG
-        Serial.print(F("Tag capacity "));
-        Serial.print(tagCapacity);
-        Serial.println(F(" bytes"));
+    Serial.print(F("Version "));
+    PrintHex(version, 8);
+    Serial.print(F("Tag capacity "));
+    Serial.print(tagCapacity);
+    Serial.println(F(" bytes"));
 #endif
+    return true;
+}
 
-        // TODO future versions should get lock information
+// Reads count pages into data, with FAST_READ as many as fit in the FIFO at a time, otherwise 4 per READ. Only the
+// first dataLength bytes are kept, data need not hold whole pages. With a decoder each frame is fed to it instead,
+// and reading stops when it is done.
+boolean MifareUltralight::readPages(uint8_t page, uint8_t count, byte * data, uint16_t dataLength,
+                                   NdefStreamDecoder * decoder)
+{
+    while(count > 0) {
+        byte frame[MFRC522::FIFO_SIZE];
+        byte dataSize = sizeof(frame);
+        uint8_t pages = ULTRALIGHT_READ_SIZE / ULTRALIGHT_PAGE_SIZE;
+        MFRC522::StatusCode status;
+        if(fastRead) {
+            pages = count < ULTRALIGHT_FAST_READ_PAGES ? count : ULTRALIGHT_FAST_READ_PAGES;
+            status = nfc->MIFARE_Ultralight_FastRead(page, page + pages - 1, frame, &dataSize);
+        }
+        else {
+            status = nfc->MIFARE_Read(page, frame, &dataSize);
+        }
+        if(status != MFRC522::STATUS_OK) {
+#ifdef NDEF_USE_SERIAL
+            Serial.print(F("Read failed "));
+            Serial.println(page);
+#endif
+            return false;
+        }
+        if(pages > count) {
+            pages = count;
+        }
+#ifdef MIFARE_ULTRALIGHT_DEBUG
+        Serial.print(F("Page "));
+        Serial.print(page);
+        Serial.print(" ");
+        PrintHexChar(frame, pages * ULTRALIGHT_PAGE_SIZE);
+#endif
+        if(decoder) {
+            decoder->feed(frame, pages * ULTRALIGHT_PAGE_SIZE);
+            if(decoder->done()) {
+                return true;
+            }
+        }
+        else {
+            uint16_t length = pages * ULTRALIGHT_PAGE_SIZE < dataLength ? pages * ULTRALIGHT_PAGE_SIZE : dataLength;
+            memcpy(data, frame, length);
+            data += length;
+            dataLength -= length;
+        }
+        page += pages;
+        count -= pages;
     }
+    return true;
+}
 
-    return tagCapacity;
+// page 4 of a factory tag is all 0xFF; needs readHeader()
+boolean MifareUltralight::isUnformatted()
+{
+    byte * data = &header[ULTRALIGHT_PAGE_SIZE];
+    return (data[0] == 0xFF && data[1] == 0xFF && data[2] == 0xFF && data[3] == 0xFF);
 }
 
-// read enough of the message to find the ndef message length
+// the ndef message length from the TLV at the start of the data area; needs readHeader()
 void MifareUltralight::findNdefMessage(uint16_t * messageLength, uint16_t * ndefStartIndex)
 {
-    byte dataSize = ULTRALIGHT_READ_SIZE + 2;
-    byte data[dataSize]; // 3 pages, but 4 + CRC are returned
-
-    if(nfc->MIFARE_Read(4, data, &dataSize) == MFRC522::STATUS_OK) {
-#ifdef MIFARE_ULTRALIGHT_DEBUG
-        Serial.println(F("Pages 4-7"));
-        PrintHexChar(data, 18);
-        PrintHexChar(data + ULTRALIGHT_PAGE_SIZE, 18);
-        PrintHexChar(data + 2 * ULTRALIGHT_PAGE_SIZE, 18);
-        PrintHexChar(data + 3 * ULTRALIGHT_PAGE_SIZE, 18);
-#endif
+    byte * data = &header[ULTRALIGHT_PAGE_SIZE];
 
-        if(data[0] == 0x03) {
+    if(data[0] == 0x03) {
+        if(data[1] == 0xFF) { // 3 byte length format
+            *messageLength = (data[2] << 8) | data[3];
+            *ndefStartIndex = 4;
+        }
+        else {
             *messageLength = data[1];
             *ndefStartIndex = 2;
         }
-        else if(data[5] == 0x3) { // page 5 byte 1
-            // TODO should really read the lock control TLV to ensure byte[5] is correct
-            *messageLength = data[6];
-            *ndefStartIndex = 7;
-        }
+    }
+    else if(data[5] == 0x3) { // page 5 byte 1
+        // TODO should really read the lock control TLV to ensure byte[5] is correct
+        *messageLength = data[6];
+        *ndefStartIndex = 7;
     }
 
 #ifdef MIFARE_ULTRALIGHT_DEBUG
@@ -141,39 +262,39 @@ void MifareUltralight::findNdefMessage(uint16_t * messageLength, uint16_t * ndef
 #endif
 }
 
-// buffer is larger than the message, need to handle some data before and after
-// message and need to ensure we read full pages
-uint16_t MifareUltralight::calculateBufferSize(uint16_t messageLength, uint16_t ndefStartIndex)
+// The image goes on the heap rather than the stack, a message can be as large as the tag
+boolean MifareUltralight::write(NdefMessage & m)
 {
-    // TLV terminator 0xFE is 1 byte
-    uint16_t bufferSize = messageLength + ndefStartIndex + 1;
-
-    if(bufferSize % ULTRALIGHT_READ_SIZE != 0) {
-        // buffer must be an increment of page size
-        bufferSize = ((bufferSize / ULTRALIGHT_READ_SIZE) + 1) * ULTRALIGHT_READ_SIZE;
-    }
+    PreparedNdefWrite prepared(m);
+    return write(prepared);
+}
 
-    //MFRC522 also return CRC
-    bufferSize += 2;
+boolean MifareUltralight::update(NdefMessage & m)
+{
+    PreparedNdefWrite prepared(m);
+    return prepared.isValid() && writeImage(prepared.image(), prepared.size(), true);
+}
 
-    return bufferSize;
+boolean MifareUltralight::write(const PreparedNdefWrite & prepared)
+{
+    return prepared.isValid() && writeImage(prepared.image(), prepared.size());
 }
 
-boolean MifareUltralight::write(NdefMessage & m)
+// Writes the TLVs the image holds from page 4 on, or with update only the pages that changed
+boolean MifareUltralight::writeImage(const byte * image, uint16_t size, boolean update)
 {
+    if(!readHeader()) { // meta info for tag
+        return false;
+    }
     if(isUnformatted()) {
 #ifdef NDEF_USE_SERIAL
         Serial.println(F("WARNING: Tag is not formatted."));
 #endif
         return false;
     }
-    uint16_t tagCapacity = readTagSize(); // meta info for tag
 
-    uint16_t messageLength  = m.getEncodedSize();
-    uint16_t ndefStartIndex = messageLength < 0xFF ? 2 : 4;
-    uint16_t bufferSize = calculateBufferSize(messageLength, ndefStartIndex);
-
-    if(bufferSize > tagCapacity) {
+    // the image with room for the 2 CRC bytes of a READ
+    if(size + 2 > tagCapacity) {
 #ifdef MIFARE_ULTRALIGHT_DEBUG
         Serial.print(F("Encoded Message length exceeded tag Capacity "));
         Serial.println(tagCapacity);
@@ -181,43 +302,21 @@ boolean MifareUltralight::write(NdefMessage & m)
         return false;
     }
 
-    uint8_t encoded[bufferSize];
-    uint8_t  * src = encoded;
-    unsigned int position = 0;
-    uint8_t page = ULTRALIGHT_DATA_START_PAGE;
-
-    // Set message size. With ultralight should always be less than 0xFF but who knows?
-
-    encoded[0] = 0x3;
-    if(messageLength < 0xFF) {
-        encoded[1] = messageLength;
-    }
-    else {
-        encoded[1] = 0xFF;
-        encoded[2] = ((messageLength >> 8) & 0xFF);
-        encoded[3] = (messageLength & 0xFF);
-    }
-
-    m.encode(encoded + ndefStartIndex);
-    // this is always at least 1 byte copy because of terminator.
-    memset(encoded + ndefStartIndex + messageLength, 0, bufferSize - ndefStartIndex - messageLength);
-    encoded[ndefStartIndex + messageLength] = 0xFE; // terminator
-
 #ifdef MIFARE_ULTRALIGHT_DEBUG
-    Serial.print(F("messageLength "));
-    Serial.println(messageLength);
     Serial.print(F("Tag Capacity "));
     Serial.println(tagCapacity);
-    PrintHex(encoded, bufferSize);
+    PrintHex(image, size);
 #endif
+    if(update) {
+        return updateImage(image, size);
+    }
 
-    while(position < bufferSize) { //bufferSize is always times pagesize so no "last chunk" check
-        // Although we have to provide 16 bytes to MIFARE_Write only 4 of them are written onto the tag
-        byte writeBuffer[16] = {0};
-        memcpy(writeBuffer, src, 4);
-        // write page
-        if(nfc->MIFARE_Write(page, writeBuffer, 16) != MFRC522::STATUS_OK)
+    uint8_t page = ULTRALIGHT_DATA_START_PAGE;
+    for(uint16_t position = 0; position < size; position += ULTRALIGHT_PAGE_SIZE) {
+        const byte * src = &image[position];
+        if(writePage(page, src) != MFRC522::STATUS_OK) {
             return false;
+        }
 #ifdef MIFARE_ULTRALIGHT_DEBUG
         Serial.print(F("Wrote page "));
         Serial.print(page);
@@ -225,8 +324,50 @@ boolean MifareUltralight::write(NdefMessage & m)
         PrintHex(src, ULTRALIGHT_PAGE_SIZE);
 #endif
         page++;
-        src += ULTRALIGHT_PAGE_SIZE;
-        position += ULTRALIGHT_PAGE_SIZE;
+    }
+    return true;
+}
+
+// Reads what the pages hold now and writes those that differ. Page 4 has the TLV length: when other pages change
+// it first gets length 0, so a reader never takes half updated pages for a message, and the new length last.
+boolean MifareUltralight::updateImage(const byte * image, uint16_t size)
+{
+    uint8_t pages = size / ULTRALIGHT_PAGE_SIZE;
+    uint8_t cached = (ULTRALIGHT_READ_SIZE / ULTRALIGHT_PAGE_SIZE) - 1;
+    byte current[size];
+    memcpy(current, &header[ULTRALIGHT_PAGE_SIZE], cached * ULTRALIGHT_PAGE_SIZE);
+    if(pages > cached + 2 * (ULTRALIGHT_READ_SIZE / ULTRALIGHT_PAGE_SIZE) && !identify()) {
+        return false;
+    }
+    if(!readPages(ULTRALIGHT_DATA_START_PAGE + cached, pages - cached, &current[cached * ULTRALIGHT_PAGE_SIZE],
+                  size - cached * ULTRALIGHT_PAGE_SIZE)) {
+        return false;
+    }
+
+    boolean changed = false;
+    for(uint8_t i = 1; i < pages && !changed; i++) {
+        changed = memcmp(&image[i * ULTRALIGHT_PAGE_SIZE], &current[i * ULTRALIGHT_PAGE_SIZE], ULTRALIGHT_PAGE_SIZE) != 0;
+    }
+    if(changed && !(current[0] == 0x03 && current[1] == 0x00)) {
+        byte empty[ULTRALIGHT_PAGE_SIZE] = { 0x03, 0x00, current[2], current[3] };
+        if(writePage(ULTRALIGHT_DATA_START_PAGE, empty) != MFRC522::STATUS_OK) {
+            return false;
+        }
+        memcpy(current, empty, ULTRALIGHT_PAGE_SIZE);
+    }
+    for(uint8_t i = 1; changed && i < pages; i++) {
+        const byte * src = &image[i * ULTRALIGHT_PAGE_SIZE];
+        if(memcmp(src, &current[i * ULTRALIGHT_PAGE_SIZE], ULTRALIGHT_PAGE_SIZE) == 0) {
+            continue;
+        }
+        if(writePage(ULTRALIGHT_DATA_START_PAGE + i, src) != MFRC522::STATUS_OK) {
+            return false;
+        }
+    }
+    if(memcmp(image, current, ULTRALIGHT_PAGE_SIZE) != 0) {
+        if(writePage(ULTRALIGHT_DATA_START_PAGE, image) != MFRC522::STATUS_OK) {
+            return false;
+        }
     }
     return true;
 }
@@ -235,12 +376,14 @@ boolean MifareUltralight::write(NdefMessage & m)
 // zero out tag data like the NXP Tag Write Android application
 boolean MifareUltralight::clean()
 {
-    uint16_t tagCapacity = readTagSize();
+    if(!readHeader()) {
+        return false;
+    }
 
     uint8_t pages = (tagCapacity / ULTRALIGHT_PAGE_SIZE) + ULTRALIGHT_DATA_START_PAGE;
 
     // factory tags have 0xFF, but OTP-CC blocks have already been set so we use 0x00
-    byte data[16] = { 0 };
+    byte data[ULTRALIGHT_PAGE_SIZE] = { 0 };
 
     for(int i = ULTRALIGHT_DATA_START_PAGE; i < pages; i++) {
 #ifdef MIFARE_ULTRALIGHT_DEBUG
@@ -249,9 +392,37 @@ boolean MifareUltralight::clean()
         Serial.print(F(" - "));
         PrintHex(data, ULTRALIGHT_PAGE_SIZE);
 #endif
-        if(nfc->MIFARE_Write(i, data, 16) != MFRC522::STATUS_OK) {
+        if(writePage(i, data) != MFRC522::STATUS_OK) {
             return false;
         }
     }
     return true;
 }
+
+// Writes a page with the single frame WRITE. The first write is the probe: a tag that does not know the command
+// (it NAKs or stays silent, and goes IDLE) is selected again and written with the 16 byte COMPATIBILITY WRITE.
+MFRC522::StatusCode MifareUltralight::writePage(uint8_t page, const byte * data)
+{
+    if(!compatibilityWrite) {
+        byte pageBuffer[ULTRALIGHT_PAGE_SIZE];
+        memcpy(pageBuffer, data, ULTRALIGHT_PAGE_SIZE);
+        MFRC522::StatusCode status = nfc->MIFARE_Ultralight_Write(page, pageBuffer, ULTRALIGHT_PAGE_SIZE);
+        bool unknown = status == MFRC522::STATUS_MIFARE_NACK || status == MFRC522::STATUS_TIMEOUT;
+        if(writeProbed || !unknown) {
+            writeProbed = true;
+            return status;
+        }
+        writeProbed = true;
+        if(nfc->PICC_Reselect(&nfc->uid) != MFRC522::STATUS_OK) {
+            return status;
+        }
+        compatibilityWrite = true;
+#ifdef MIFARE_ULTRALIGHT_DEBUG
+        Serial.println(F("Tag does not support WRITE, using COMPATIBILITY WRITE"));
+#endif
+    }
+    // Although we have to provide 16 bytes to MIFARE_Write only 4 of them are written onto the tag
+    byte writeBuffer[16] = {0};
+    memcpy(writeBuffer, data, ULTRALIGHT_PAGE_SIZE);
+    return nfc->MIFARE_Write(page, writeBuffer, 16);
+}
@@ -3,6 +3,8 @@
 
 #include "MFRC522_I2C.h"
 #include "NfcTag.h"
+#include "NdefStreamDecoder.h"
+#include "PreparedNdefWrite.h"
 #include "Ndef.h"
 
 //#define MIFARE_ULTRALIGHT_DEBUG 1
@@ -10,25 +12,44 @@
 #define ULTRALIGHT_PAGE_SIZE 4
 #define ULTRALIGHT_READ_SIZE 16
 
+#define ULTRALIGHT_CC_PAGE 3
 #define ULTRALIGHT_DATA_START_PAGE 4
 #define ULTRALIGHT_MESSAGE_LENGTH_INDEX 1
 #define ULTRALIGHT_DATA_START_INDEX 2
-#define ULTRALIGHT_MAX_PAGE 63
+// a FAST_READ answer and its CRC_A have to fit in the 64 byte FIFO
+#define ULTRALIGHT_FAST_READ_PAGES 15
 
 class MifareUltralight
 {
     public:
-        MifareUltralight(MFRC522 * nfcShield);
+        MifareUltralight(MFRC522 * nfcShield, NdefAllocator * allocator = NULL);
         ~MifareUltralight();
         NfcTag read();
+        // feeds the data area to decoder as it is read, up to the end of the message; false if there is none
+        boolean read(NdefStreamDecoder & decoder);
         boolean write(NdefMessage & ndefMessage);
+        boolean write(const PreparedNdefWrite & prepared);
+        // write only the pages that differ from the message on the tag
+        boolean update(NdefMessage & ndefMessage);
         boolean clean();
     private:
         MFRC522 * nfc;
+        NdefAllocator * allocator;      // for the NfcTag read() returns
+        boolean writeProbed;            // the first page write told whether the tag knows WRITE
+        boolean compatibilityWrite;     // it does not
+        boolean versionProbed;          // GET_VERSION was sent
+        boolean fastRead;               // and answered, the tag knows FAST_READ
+        uint16_t tagCapacity;           // bytes in the data area, from the CC or GET_VERSION
+        byte header[ULTRALIGHT_READ_SIZE + 2];  // pages 3-6: the CC and the start of the data area
+        boolean readHeader();
+        boolean identify();
+        boolean readPages(uint8_t page, uint8_t count, byte * data, uint16_t dataLength,
+                          NdefStreamDecoder * decoder = NULL);
         boolean isUnformatted();
-        uint16_t readTagSize();
         void findNdefMessage(uint16_t * messageLength, uint16_t * ndefStartIndex);
-        uint16_t calculateBufferSize(uint16_t messageLength, uint16_t ndefStartIndex);
+        boolean writeImage(const byte * image, uint16_t size, boolean update = false);
+        boolean updateImage(const byte * image, uint16_t size);
+        MFRC522::StatusCode writePage(uint8_t page, const byte * data);
 };
 
 #endif
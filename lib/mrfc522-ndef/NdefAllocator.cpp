@@ -0,0 +1,59 @@
+#include "NdefAllocator.h"
+#ifdef ESP_PLATFORM
+    #include <esp_heap_caps.h>
+#endif
+
+static uint32_t heapAllocations;
+static uint32_t heapReleases;
+
+void * NdefArena::allocate(size_t size)
+{
+    // 8 byte aligned, enough for the records themselves
+    size_t misalignment = ((uintptr_t)_buffer + _top) % 8;
+    size_t start = misalignment ? _top + 8 - misalignment : _top;
+    if(start + size > _size) {
+        failures++;
+        return NULL;
+    }
+    allocated(start + size - _top);
+    _top = start + size;
+    return _buffer + start;
+}
+
+void * ndef_allocate(NdefAllocator * allocator, size_t size)
+{
+    if(allocator) {
+        return allocator->allocate(size);
+    }
+    heapAllocations++;
+    return malloc(size);
+}
+
+void ndef_release(NdefAllocator * allocator, void * pointer)
+{
+    if(allocator) {
+        allocator->release(pointer);
+        return;
+    }
+    if(pointer) {
+        heapReleases++;
+    }
+    free(pointer);
+}
+
+NdefHeapInfo ndef_heap_info()
+{
+    NdefHeapInfo info;
+    info.allocations = heapAllocations;
+    info.releases = heapReleases;
+#ifdef ESP_PLATFORM
+    info.freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    info.largestFreeBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    info.minimumFreeBytes = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+#else
+    info.freeBytes = 0;
+    info.largestFreeBlock = 0;
+    info.minimumFreeBytes = 0;
+#endif
+    return info;
+}
@@ -0,0 +1,114 @@
+#ifndef NdefAllocator_h
+#define NdefAllocator_h
+
+#include <Arduino.h>
+
+// Where NdefRecord, NdefMessage and NfcTag keep their data. Without one (NULL) they use the system heap; with an
+// arena reset after each tag, or a pool, reading and decoding a tag makes no heap calls and cannot fragment it.
+// Copies of a record, message or tag use the allocator of the original, assignment keeps the target's.
+class NdefAllocator
+{
+    public:
+        NdefAllocator() : allocations(0), releases(0), failures(0), used(0), highWater(0) {};
+        virtual ~NdefAllocator() {};
+        virtual void * allocate(size_t size) = 0;
+        virtual void release(void * pointer) = 0;
+
+        uint32_t allocations;
+        uint32_t releases;
+        uint32_t failures;      // allocate() returned NULL
+        size_t used;            // bytes handed out and not given back
+        size_t highWater;       // the most bytes used at once
+    protected:
+        void allocated(size_t size)
+        {
+            allocations++;
+            used += size;
+            if(used > highWater) {
+                highWater = used;
+            }
+        };
+};
+
+// A bump allocator over a caller provided buffer: release() does nothing, reset() frees everything at once.
+// Nothing allocated from it may be used after reset().
+class NdefArena : public NdefAllocator
+{
+    public:
+        NdefArena(void * buffer, size_t size) : _buffer((byte *)buffer), _size(size), _top(0) {};
+        void * allocate(size_t size) override;
+        void release(void * pointer) override
+        {
+            if(pointer) {
+                releases++;
+            }
+        };
+        void reset()
+        {
+            _top = 0;
+            used = 0;
+        };
+    private:
+        byte * _buffer;
+        size_t _size;
+        size_t _top;
+};
+
+// blockCount blocks of blockSize bytes each, allocated with the pool. Anything larger than a block cannot be had.
+template <size_t blockSize, size_t blockCount>
+class NdefPool : public NdefAllocator
+{
+    public:
+        NdefPool() : _free(0)
+        {
+            for(size_t i = 0; i < blockCount; i++) {
+                _next[i] = i + 1;
+            }
+        };
+        void * allocate(size_t size) override
+        {
+            if(size > blockSize || _free == blockCount) {
+                failures++;
+                return NULL;
+            }
+            uint16_t block = _free;
+            _free = _next[block];
+            allocated(blockSize);
+            return _blocks[block];
+        };
+        void release(void * pointer) override
+        {
+            if(pointer) {
+                uint16_t block = ((byte *)pointer - _blocks[0]) / sizeof(_blocks[0]);
+                _next[block] = _free;
+                _free = block;
+                releases++;
+                used -= blockSize;
+            }
+        };
+    private:
+        static_assert(blockCount < 0xFFFF, "NdefPool: too many blocks");
+        alignas(8) byte _blocks[blockCount][(blockSize + 7) / 8 * 8];
+        uint16_t _next[blockCount];
+        uint16_t _free;
+};
+
+// The system heap as the NDEF classes see it
+struct NdefHeapInfo {
+    uint32_t allocations;       // malloc calls by the NDEF classes, ie without an NdefAllocator
+    uint32_t releases;
+    size_t freeBytes;           // the whole heap, 0 where not known (host)
+    size_t largestFreeBlock;
+    size_t minimumFreeBytes;    // the least freeBytes since boot, the heap high-water mark
+    // percent of the free memory not in the largest block
+    uint8_t fragmentation() const
+    {
+        return freeBytes ? 100 - largestFreeBlock * 100 / freeBytes : 0;
+    };
+};
+
+void * ndef_allocate(NdefAllocator * allocator, size_t size);
+void ndef_release(NdefAllocator * allocator, void * pointer);
+NdefHeapInfo ndef_heap_info();
+
+#endif
@@ -1,12 +1,15 @@
+#include <new>
 #include "NdefMessage.h"
 
-NdefMessage::NdefMessage(void)
+NdefMessage::NdefMessage(NdefAllocator * allocator)
 {
+    _allocator = allocator;
     _recordCount = 0;
 }
 
-NdefMessage::NdefMessage(const byte * data, const uint16_t numBytes)
+NdefMessage::NdefMessage(const byte * data, const uint16_t numBytes, NdefAllocator * allocator)
 {
+    _allocator = allocator;
 #ifdef NDEF_USE_SERIAL
     Serial.print(F("Decoding "));
     Serial.print(numBytes);
@@ -30,7 +33,13 @@ NdefMessage::NdefMessage(const byte * data, const uint16_t numBytes)
         bool il = tnf_byte & 0x8;
         NdefRecord::TNF tnf = static_cast<NdefRecord::TNF>(tnf_byte & 0x7);
 
-        NdefRecord * record = new NdefRecord();
+        NdefRecord * record = _recordCount < MAX_NDEF_RECORDS ? _newRecord(NdefRecord()) : NULL;
+        if(!record) {
+#ifdef NDEF_USE_SERIAL
+            Serial.println(F("WARNING: Too many records. Increase MAX_NDEF_RECORDS."));
+#endif
+            break;
+        }
         record->setTnf(tnf);
 
         index++;
@@ -43,10 +52,10 @@ NdefMessage::NdefMessage(const byte * data, const uint16_t numBytes)
         }
         else {
             payloadLength =
-                (static_cast<uint32_t>(data[index])   << 24)
-                | (static_cast<uint32_t>(data[index + 1]) << 16)
-                | (static_cast<uint32_t>(data[index + 2]) << 8)
-                |  static_cast<uint32_t>(data[index + 3]);
+                (static_cast<uint32_t>(data[index + 1]) << 24)
+                | (static_cast<uint32_t>(data[index + 2]) << 16)
+                | (static_cast<uint32_t>(data[index + 3]) << 8)
+                |  static_cast<uint32_t>(data[index + 4]);
             index += 4;
         }
 
@@ -78,16 +87,25 @@ NdefMessage::NdefMessage(const byte * data, const uint16_t numBytes)
 
 NdefMessage::NdefMessage(const NdefMessage & rhs)
 {
+    _allocator = rhs._allocator;
     _recordCount = 0;
     for(unsigned int i = 0; i < rhs._recordCount; i++) {
         addRecord(*(rhs._records[i]));
     }
 }
 
+NdefMessage::NdefMessage(NdefMessage && rhs)
+{
+    _allocator = rhs._allocator;
+    _recordCount = rhs._recordCount;
+    memcpy(_records, rhs._records, _recordCount * sizeof(_records[0]));
+    rhs._recordCount = 0;
+}
+
 NdefMessage::~NdefMessage()
 {
     for(int i = 0; i < _recordCount; i++) {
-        delete(_records[i]);
+        _deleteRecord(_records[i]);
     }
 }
 
@@ -98,24 +116,61 @@ NdefMessage & NdefMessage::operator=(const NdefMessage & rhs)
 
         // delete existing records
         for(uint8_t i = 0; i < _recordCount; i++) {
-            delete(_records[i]);
+            _deleteRecord(_records[i]);
             _records[i] = (NdefRecord *)NULL;
         }
 
         _recordCount = 0;
-        for(unsigned int i = 0; i < _recordCount; i++) {
+        for(unsigned int i = 0; i < rhs._recordCount; i++) {
             addRecord(*(rhs._records[i]));
         }
     }
     return *this;
 }
 
-uint8_t NdefMessage::getRecordCount()
+// a copy of record, allocated with the message's allocator; NULL unless all of it could be copied
+NdefRecord * NdefMessage::_newRecord(const NdefRecord & record)
+{
+    void * memory = ndef_allocate(_allocator, sizeof(NdefRecord));
+    NdefRecord * copy = memory ? new(memory) NdefRecord(record, _allocator) : NULL;
+    if(copy && (copy->getTypeLength() != record.getTypeLength()
+                || copy->getPayloadLength() != record.getPayloadLength()
+                || copy->getIdLength() != record.getIdLength())) {
+        _deleteRecord(copy);
+        return NULL;
+    }
+    return copy;
+}
+
+void NdefMessage::_deleteRecord(NdefRecord * record)
+{
+    record->~NdefRecord();
+    ndef_release(_allocator, record);
+}
+
+// Takes over rhs's records if they come from the same allocator, else copies them
+NdefMessage & NdefMessage::operator=(NdefMessage && rhs)
+{
+    if(_allocator != rhs._allocator) {
+        return *this = static_cast<const NdefMessage &>(rhs);
+    }
+    if(this != &rhs) {
+        for(uint8_t i = 0; i < _recordCount; i++) {
+            _deleteRecord(_records[i]);
+        }
+        _recordCount = rhs._recordCount;
+        memcpy(_records, rhs._records, _recordCount * sizeof(_records[0]));
+        rhs._recordCount = 0;
+    }
+    return *this;
+}
+
+uint8_t NdefMessage::getRecordCount() const
 {
     return _recordCount;
 }
 
-unsigned int NdefMessage::getEncodedSize()
+unsigned int NdefMessage::getEncodedSize() const
 {
     unsigned int size = 0;
     for(unsigned int i = 0; i < _recordCount; i++) {
@@ -125,33 +180,33 @@ unsigned int NdefMessage::getEncodedSize()
 }
 
 // TODO change this to return uint8_t*
-void NdefMessage::encode(uint8_t * data)
+void NdefMessage::encode(uint8_t * data) const
 {
     // assert sizeof(data) >= getEncodedSize()
     uint8_t * data_ptr = &data[0];
 
     for(unsigned int i = 0; i < _recordCount; i++) {
-        _records[i]->encode(data_ptr, i == 0, (i + 1) == _recordCount);
-        // TODO can NdefRecord.encode return the record size?
-        data_ptr += _records[i]->getEncodedSize();
+        data_ptr += _records[i]->encode(data_ptr, i == 0, (i + 1) == _recordCount);
     }
 
 }
 
+// false if the message is full or the allocator could not hold all of the copy
 bool NdefMessage::addRecord(NdefRecord & record)
 {
-
-    if(_recordCount < MAX_NDEF_RECORDS) {
-        _records[_recordCount] = new NdefRecord(record);
-        _recordCount++;
-        return true;
-    }
-    else {
+    if(_recordCount == MAX_NDEF_RECORDS) {
 #ifdef NDEF_USE_SERIAL
         Serial.println(F("WARNING: Too many records. Increase MAX_NDEF_RECORDS."));
 #endif
         return false;
     }
+    NdefRecord * copy = _newRecord(record);
+    if(!copy) {
+        return false;
+    }
+    _records[_recordCount] = copy;
+    _recordCount++;
+    return true;
 }
 
 void NdefMessage::addMimeMediaRecord(const char * mimeType, const char * payload)
@@ -161,7 +216,7 @@ void NdefMessage::addMimeMediaRecord(const char * mimeType, const char * payload
 
 void NdefMessage::addMimeMediaRecord(const char * mimeType, byte * payload, const uint16_t payloadLength)
 {
-    NdefRecord r;
+    NdefRecord r(_allocator);
     r.setTnf(NdefRecord::TNF_MIME_MEDIA);
     r.setType((byte *)mimeType, strlen(mimeType) + 1);
     r.setPayload(payload, payloadLength);
@@ -178,7 +233,7 @@ void NdefMessage::addTextRecord(const char * text)
 // Only supports UTF-8 encoding
 void NdefMessage::addTextRecord(const char * text, const char * language)
 {
-    NdefRecord r;
+    NdefRecord r(_allocator);
 
     r.setTnf(NdefRecord::TNF_WELL_KNOWN);
 
@@ -200,7 +255,7 @@ void NdefMessage::addTextRecord(const char * text, const char * language)
 
 void NdefMessage::addUriRecord(const char * uri)
 {
-    NdefRecord r;
+    NdefRecord r(_allocator);
     r.setTnf(NdefRecord::TNF_WELL_KNOWN);
 
     uint8_t RTD_URI[] = { NdefRecord::RTD_URI };
@@ -218,7 +273,7 @@ void NdefMessage::addUriRecord(const char * uri)
 // Type shoulde be something like my.com:xx
 void NdefMessage::addExternalRecord(const char * type, const byte * payload, const uint16_t payloadLength)
 {
-    NdefRecord r;
+    NdefRecord r(_allocator);
     r.setTnf(NdefRecord::TNF_EXTERNAL_TYPE);
 
     r.setType((byte *)type, strlen(type));
@@ -228,7 +283,7 @@ void NdefMessage::addExternalRecord(const char * type, const byte * payload, con
 
 void NdefMessage::addEmptyRecord()
 {
-    NdefRecord r;
+    NdefRecord r(_allocator);
     r.setTnf(NdefRecord::TNF_EMPTY);
     addRecord(r);
 }
@@ -243,13 +298,20 @@ NdefRecord NdefMessage::getRecord(uint8_t index)
     }
 }
 
+// an empty record past the last one
+const NdefRecord & NdefMessage::record(uint8_t index) const
+{
+    static const NdefRecord empty;
+    return index < _recordCount ? *_records[index] : empty;
+}
+
 NdefRecord NdefMessage::operator[](uint8_t index)
 {
     return getRecord(index);
 }
 
 #ifdef NDEF_USE_SERIAL
-void NdefMessage::print()
+void NdefMessage::print() const
 {
     Serial.print(F("\nNDEF Message "));
     Serial.print(_recordCount);
@@ -11,14 +11,16 @@
 class NdefMessage
 {
     public:
-        NdefMessage(void);
-        NdefMessage(const byte * data, const uint16_t numBytes);
+        explicit NdefMessage(NdefAllocator * allocator = NULL);
+        NdefMessage(const byte * data, const uint16_t numBytes, NdefAllocator * allocator = NULL);
         NdefMessage(const NdefMessage & rhs);
+        NdefMessage(NdefMessage && rhs);
         ~NdefMessage();
         NdefMessage & operator=(const NdefMessage & rhs);
+        NdefMessage & operator=(NdefMessage && rhs);
 
-        unsigned int getEncodedSize(); // need so we can pass array to encode
-        void encode(byte * data);
+        unsigned int getEncodedSize() const; // need so we can pass array to encode
+        void encode(byte * data) const;
 
         boolean addRecord(NdefRecord & record);
         void addMimeMediaRecord(const char * mimeType, const char * payload);
@@ -29,14 +31,57 @@ class NdefMessage
         void addExternalRecord(const char * type, const byte * payload, const uint16_t payloadLength);
         void addEmptyRecord();
 
-        uint8_t getRecordCount();
+        // the records, read without copying them: record(i), or for(const NdefRecord & record : message)
+        class Iterator
+        {
+            public:
+                explicit Iterator(NdefRecord * const * record) : _record(record) {};
+                const NdefRecord & operator*() const
+                {
+                    return **_record;
+                };
+                const NdefRecord * operator->() const
+                {
+                    return *_record;
+                };
+                Iterator & operator++()
+                {
+                    _record++;
+                    return *this;
+                };
+                bool operator==(const Iterator & rhs) const
+                {
+                    return _record == rhs._record;
+                };
+                bool operator!=(const Iterator & rhs) const
+                {
+                    return _record != rhs._record;
+                };
+            private:
+                NdefRecord * const * _record;
+        };
+        Iterator begin() const
+        {
+            return Iterator(_records);
+        };
+        Iterator end() const
+        {
+            return Iterator(_records + _recordCount);
+        };
+        const NdefRecord & record(uint8_t index) const;
+
+        uint8_t getRecordCount() const;
+        // copies of the records
         NdefRecord getRecord(uint8_t index);
         NdefRecord operator[](uint8_t index);
 
 #ifdef NDEF_USE_SERIAL
-        void print();
+        void print() const;
 #endif
     private:
+        NdefRecord * _newRecord(const NdefRecord & record);
+        void _deleteRecord(NdefRecord * record);
+        NdefAllocator * _allocator;   // for the records and their data, NULL for the heap
         NdefRecord * _records[MAX_NDEF_RECORDS];
         uint8_t _recordCount;
 };
@@ -0,0 +1,44 @@
+#include "NdefMessageView.h"
+
+NdefMessageView::NdefMessageView(const byte * data, uint16_t numBytes)
+    : _data(data), _length(0), _recordCount(0), _valid(true)
+{
+    NdefRecordView record;
+    while(_length < numBytes && _recordCount < 0xFF) {
+        uint16_t size = record.parse(&data[_length], numBytes - _length);
+        if(size == 0) {
+            _valid = false;
+            break;
+        }
+        _length += size;
+        _recordCount++;
+
+        if(record.isLast()) {
+            break;
+        }
+    }
+}
+
+NdefRecordView NdefMessageView::getRecord(uint8_t index) const
+{
+    Iterator it = begin();
+    for(uint8_t i = 0; i < index && it != end(); i++) {
+        ++it;
+    }
+    return it != end() ? *it : NdefRecordView();
+}
+
+NdefMessageView::Iterator::Iterator(const byte * data, uint16_t length, uint16_t offset)
+    : _data(data), _length(length), _offset(offset), _size(0)
+{
+    if(_offset < _length) {
+        _size = _record.parse(&_data[_offset], _length - _offset);
+    }
+}
+
+NdefMessageView::Iterator & NdefMessageView::Iterator::operator++()
+{
+    _offset = _size ? _offset + _size : _length;    // a record that does not parse ends the iteration
+    _size = _offset < _length ? _record.parse(&_data[_offset], _length - _offset) : 0;
+    return *this;
+}
@@ -0,0 +1,81 @@
+#ifndef NdefMessageView_h
+#define NdefMessageView_h
+
+#include "NdefRecordView.h"
+
+// An encoded NDEF message, read in place without copying or allocating. The records are found once, on
+// construction; iterating parses each again from its offset. The buffer has to outlive the view and its records.
+//
+//     NdefMessageView message(data, length);
+//     for(NdefMessageView::Iterator it = message.begin(); it != message.end(); ++it) {
+//         it->getPayload() ...
+//     }
+//
+// Use NdefMessage to build messages, or to keep one beyond the buffer.
+class NdefMessageView
+{
+    public:
+        class Iterator
+        {
+            public:
+                const NdefRecordView & operator*() const
+                {
+                    return _record;
+                };
+                const NdefRecordView * operator->() const
+                {
+                    return &_record;
+                };
+                Iterator & operator++();
+                bool operator==(const Iterator & rhs) const
+                {
+                    return _offset == rhs._offset;
+                };
+                bool operator!=(const Iterator & rhs) const
+                {
+                    return _offset != rhs._offset;
+                };
+            private:
+                friend class NdefMessageView;
+                Iterator(const byte * data, uint16_t length, uint16_t offset);
+                const byte * _data;
+                uint16_t _length;
+                uint16_t _offset;
+                uint16_t _size;         // of the current record
+                NdefRecordView _record;
+        };
+
+        NdefMessageView() : _data(NULL), _length(0), _recordCount(0), _valid(true) {};
+        NdefMessageView(const byte * data, uint16_t numBytes);
+
+        // false if a record runs past the end of the buffer; the records before it are still there
+        bool isValid() const
+        {
+            return _valid;
+        };
+        uint8_t getRecordCount() const
+        {
+            return _recordCount;
+        };
+        // bytes up to the end of the last record
+        uint16_t getEncodedSize() const
+        {
+            return _length;
+        };
+        NdefRecordView getRecord(uint8_t index) const;
+        Iterator begin() const
+        {
+            return Iterator(_data, _length, 0);
+        };
+        Iterator end() const
+        {
+            return Iterator(_data, _length, _length);
+        };
+    private:
+        const byte * _data;
+        uint16_t _length;
+        uint8_t _recordCount;
+        bool _valid;
+};
+
+#endif
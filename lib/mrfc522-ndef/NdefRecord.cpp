@@ -1,7 +1,8 @@
 #include "NdefRecord.h"
 
-NdefRecord::NdefRecord()
+NdefRecord::NdefRecord(NdefAllocator * allocator)
 {
+    _allocator = allocator;
     _tnf = NdefRecord::TNF_EMPTY;
     _typeLength = 0;
     _payloadLength = 0;
@@ -11,38 +12,36 @@ NdefRecord::NdefRecord()
     _id = NULL;
 }
 
-NdefRecord::NdefRecord(const NdefRecord & rhs)
+NdefRecord::NdefRecord(const NdefRecord & rhs) : NdefRecord(rhs, rhs._allocator)
 {
+}
+
+NdefRecord::NdefRecord(const NdefRecord & rhs, NdefAllocator * allocator)
+{
+    _allocator = allocator;
+    _tnf = rhs._tnf;
+    _copyData(rhs);
+}
+
+NdefRecord::NdefRecord(NdefRecord && rhs)
+{
+    _allocator = rhs._allocator;
     _tnf = rhs._tnf;
     _typeLength = rhs._typeLength;
     _payloadLength = rhs._payloadLength;
     _idLength = rhs._idLength;
-    _type = NULL;
-    _payload = NULL;
-    _id = NULL;
-
-    if(_typeLength) {
-        _type = (byte *)malloc(_typeLength);
-        memcpy(_type, rhs._type, _typeLength);
-    }
-
-    if(_payloadLength) {
-        _payload = (byte *)malloc(_payloadLength);
-        memcpy(_payload, rhs._payload, _payloadLength);
-    }
-
-    if(_idLength) {
-        _id = (byte *)malloc(_idLength);
-        memcpy(_id, rhs._id, _idLength);
-    }
-
+    _type = rhs._type;
+    _payload = rhs._payload;
+    _id = rhs._id;
+    rhs._typeLength = rhs._payloadLength = rhs._idLength = 0;
+    rhs._type = rhs._payload = rhs._id = NULL;
 }
 
 NdefRecord::~NdefRecord()
 {
-    free(_type);
-    free(_payload);
-    free(_id);
+    ndef_release(_allocator, _type);
+    ndef_release(_allocator, _payload);
+    ndef_release(_allocator, _id);
 }
 
 NdefRecord & NdefRecord::operator=(const NdefRecord & rhs)
@@ -51,53 +50,71 @@ NdefRecord & NdefRecord::operator=(const NdefRecord & rhs)
 
     if(this != &rhs) {
         // free existing
-        free(_type);
-        free(_payload);
-        free(_id);
+        ndef_release(_allocator, _type);
+        ndef_release(_allocator, _payload);
+        ndef_release(_allocator, _id);
+
+        _tnf = rhs._tnf;
+        _copyData(rhs);
+    }
+    return *this;
+}
+
+// Takes over rhs's data if it comes from the same allocator, else copies it
+NdefRecord & NdefRecord::operator=(NdefRecord && rhs)
+{
+    if(_allocator != rhs._allocator) {
+        return *this = static_cast<const NdefRecord &>(rhs);
+    }
+    if(this != &rhs) {
+        ndef_release(_allocator, _type);
+        ndef_release(_allocator, _payload);
+        ndef_release(_allocator, _id);
 
         _tnf = rhs._tnf;
         _typeLength = rhs._typeLength;
         _payloadLength = rhs._payloadLength;
         _idLength = rhs._idLength;
-
-        if(_typeLength) {
-            _type = (byte *)malloc(_typeLength);
-            if(_type)
-                memcpy(_type, rhs._type, _typeLength);
-            else
-                Serial.println("No type malloc");
-        }
-        else {
-            _type = NULL;
-        }
-
-        if(_payloadLength) {
-            _payload = (byte *)malloc(_payloadLength);
-            if(_payload)
-                memcpy(_payload, rhs._payload, _payloadLength);
-            else
-                Serial.println("No type malloc");
-        }
-        else {
-            _payload = NULL;
-        }
-
-        if(_idLength) {
-            _id = (byte *)malloc(_idLength);
-            if(_id)
-                memcpy(_id, rhs._id, _idLength);
-            else
-                Serial.println("No type malloc");
-        }
-        else {
-            _id = NULL;
-        }
+        _type = rhs._type;
+        _payload = rhs._payload;
+        _id = rhs._id;
+        rhs._typeLength = rhs._payloadLength = rhs._idLength = 0;
+        rhs._type = rhs._payload = rhs._id = NULL;
     }
     return *this;
 }
 
+// Copies type, payload and id; as the setters do, a part the allocator had no memory for is left empty
+void NdefRecord::_copyData(const NdefRecord & rhs)
+{
+    _type = _copy(rhs._type, rhs._typeLength);
+    _typeLength = _type ? rhs._typeLength : 0;
+    _payload = _copy(rhs._payload, rhs._payloadLength);
+    _payloadLength = _payload ? rhs._payloadLength : 0;
+    _id = _copy(rhs._id, rhs._idLength);
+    _idLength = _id ? rhs._idLength : 0;
+}
+
+// NULL for no bytes, or if the allocator is out of memory
+byte * NdefRecord::_copy(const byte * data, unsigned int numBytes)
+{
+    if(!numBytes) {
+        return NULL;
+    }
+    byte * copy = (byte *)ndef_allocate(_allocator, numBytes);
+    if(copy) {
+        memcpy(copy, data, numBytes);
+    }
+#ifdef NDEF_USE_SERIAL
+    else {
+        Serial.println(F("No memory for record"));
+    }
+#endif
+    return copy;
+}
+
 // size of records in bytes
-unsigned int NdefRecord::getEncodedSize()
+unsigned int NdefRecord::getEncodedSize() const
 {
     unsigned int size = 2; // tnf + typeLength
     if(_payloadLength > 0xFF) {
@@ -116,7 +133,7 @@ unsigned int NdefRecord::getEncodedSize()
     return size;
 }
 
-void NdefRecord::encode(byte * data, bool firstRecord, bool lastRecord)
+unsigned int NdefRecord::encode(byte * data, bool firstRecord, bool lastRecord) const
 {
     // assert data > getEncodedSize()
 
@@ -157,9 +174,10 @@ void NdefRecord::encode(byte * data, bool firstRecord, bool lastRecord)
 
     memcpy(data_ptr, _payload, _payloadLength);
     data_ptr += _payloadLength;
+    return data_ptr - data;
 }
 
-byte NdefRecord::_getTnfByte(bool firstRecord, bool lastRecord)
+byte NdefRecord::_getTnfByte(bool firstRecord, bool lastRecord) const
 {
     int value = _tnf;
 
@@ -187,7 +205,7 @@ byte NdefRecord::_getTnfByte(bool firstRecord, bool lastRecord)
     return value;
 }
 
-NdefRecord::TNF NdefRecord::getTnf()
+NdefRecord::TNF NdefRecord::getTnf() const
 {
     return _tnf;
 }
@@ -197,75 +215,74 @@ void NdefRecord::setTnf(NdefRecord::TNF tnf)
     _tnf = tnf;
 }
 
-unsigned int NdefRecord::getTypeLength()
+unsigned int NdefRecord::getTypeLength() const
 {
     return _typeLength;
 }
 
-unsigned int NdefRecord::getPayloadLength()
+unsigned int NdefRecord::getPayloadLength() const
 {
     return _payloadLength;
 }
 
-unsigned int NdefRecord::getIdLength()
+unsigned int NdefRecord::getIdLength() const
 {
     return _idLength;
 }
 
-const byte * NdefRecord::getType()
+const byte * NdefRecord::getType() const
 {
     return _type;
 }
 
 void NdefRecord::setType(const byte * type, const unsigned int numBytes)
 {
-    free(_type);
+    ndef_release(_allocator, _type);
 
-    _type = (uint8_t *)malloc(numBytes);
-    memcpy(_type, type, numBytes);
-    _typeLength = numBytes;
+    _type = _copy(type, numBytes);
+    _typeLength = _type ? numBytes : 0;
 }
 
-const byte * NdefRecord::getPayload()
+const byte * NdefRecord::getPayload() const
 {
     return _payload;
 }
 
 void NdefRecord::setPayload(const byte * payload, const int numBytes)
 {
-    free(_payload);
+    ndef_release(_allocator, _payload);
 
-    _payload = (byte *)malloc(numBytes);
-    memcpy(_payload, payload, numBytes);
-    _payloadLength = numBytes;
+    _payload = _copy(payload, numBytes);
+    _payloadLength = _payload ? numBytes : 0;
 }
 
 void NdefRecord::setPayload(const byte * header, const int headerLength, const byte * payload, const int payloadLength)
 {
-    free(_payload);
+    ndef_release(_allocator, _payload);
 
-    _payload = (byte *)malloc(headerLength + payloadLength);
-    memcpy(_payload, header, headerLength);
-    memcpy(_payload + headerLength, payload, payloadLength);
-    _payloadLength = headerLength + payloadLength;
+    _payload = (byte *)ndef_allocate(_allocator, headerLength + payloadLength);
+    if(_payload) {
+        memcpy(_payload, header, headerLength);
+        memcpy(_payload + headerLength, payload, payloadLength);
+    }
+    _payloadLength = _payload ? headerLength + payloadLength : 0;
 }
 
-const byte * NdefRecord::getId()
+const byte * NdefRecord::getId() const
 {
     return _id;
 }
 
 void NdefRecord::setId(const byte * id, const unsigned int numBytes)
 {
-    free(_id);
+    ndef_release(_allocator, _id);
 
-    _id = (byte *)malloc(numBytes);
-    memcpy(_id, id, numBytes);
-    _idLength = numBytes;
+    _id = _copy(id, numBytes);
+    _idLength = _id ? numBytes : 0;
 }
 #ifdef NDEF_USE_SERIAL
 
-void NdefRecord::print()
+void NdefRecord::print() const
 {
     Serial.println(F("  NDEF Record"));
     Serial.print(F("    TNF 0x"));
@@ -4,6 +4,7 @@
 #include "Due.h"
 #include <Arduino.h>
 #include "Ndef.h"
+#include "NdefAllocator.h"
 
 class NdefRecord
 {
@@ -12,23 +13,27 @@ class NdefRecord
         enum TNF {TNF_EMPTY, TNF_WELL_KNOWN, TNF_MIME_MEDIA, TNF_ABSOLUTE_URI, TNF_EXTERNAL_TYPE, TNF_UNKNOWN, TNF_UNCHANGED, TNF_RESERVED};
         // Record Type Definition
         enum RTD {RTD_TEXT = 0x54, RTD_URI = 0x55};
-        NdefRecord();
+        explicit NdefRecord(NdefAllocator * allocator = NULL);
         NdefRecord(const NdefRecord & rhs);
+        NdefRecord(const NdefRecord & rhs, NdefAllocator * allocator);
+        NdefRecord(NdefRecord && rhs);
         ~NdefRecord();
         NdefRecord & operator=(const NdefRecord & rhs);
+        NdefRecord & operator=(NdefRecord && rhs);
 
-        unsigned int getEncodedSize();
-        void encode(byte * data, bool firstRecord, bool lastRecord);
+        unsigned int getEncodedSize() const;
+        // returns the bytes written, getEncodedSize()
+        unsigned int encode(byte * data, bool firstRecord, bool lastRecord) const;
 
-        unsigned int getTypeLength();
-        unsigned int getPayloadLength();
-        unsigned int getIdLength();
+        unsigned int getTypeLength() const;
+        unsigned int getPayloadLength() const;
+        unsigned int getIdLength() const;
 
-        NdefRecord::TNF getTnf();
+        NdefRecord::TNF getTnf() const;
 
-        const byte * getType();
-        const byte * getPayload();
-        const byte * getId();
+        const byte * getType() const;
+        const byte * getPayload() const;
+        const byte * getId() const;
 
         void setTnf(NdefRecord::TNF tnf);
         void setType(const byte * type, const unsigned int numBytes);
@@ -37,10 +42,13 @@ class NdefRecord
         void setId(const byte * id, const unsigned int numBytes);
 
 #ifdef NDEF_USE_SERIAL
-        void print();
+        void print() const;
 #endif
     private:
-        byte _getTnfByte(bool firstRecord, bool lastRecord);
+        byte _getTnfByte(bool firstRecord, bool lastRecord) const;
+        void _copyData(const NdefRecord & rhs);
+        byte * _copy(const byte * data, unsigned int numBytes);
+        NdefAllocator * _allocator;
         TNF _tnf; // 3 bit
         unsigned int _typeLength;
         unsigned int _payloadLength;
@@ -0,0 +1,41 @@
+#include "NdefRecordFilter.h"
+
+NdefRecordFilter::NdefRecordFilter(NdefRecord::TNF tnf, const char * type, uint32_t maxPayloadLength)
+    : _predicate(NULL), _context(NULL), _tnf(tnf), _type((const byte *)type), _typeLength(type ? strlen(type) : 0),
+      _maxPayloadLength(maxPayloadLength)
+{
+}
+
+NdefRecordFilter::NdefRecordFilter(NdefRecord::TNF tnf, const byte * type, byte typeLength, uint32_t maxPayloadLength)
+    : _predicate(NULL), _context(NULL), _tnf(tnf), _type(type), _typeLength(typeLength),
+      _maxPayloadLength(maxPayloadLength)
+{
+}
+
+NdefRecordFilter::NdefRecordFilter(NdefRecordPredicate predicate, void * context, uint32_t maxPayloadLength)
+    : _predicate(predicate), _context(context), _tnf(NdefRecord::TNF_EMPTY), _type(NULL), _typeLength(0),
+      _maxPayloadLength(maxPayloadLength)
+{
+}
+
+bool NdefRecordFilter::matches(const NdefStreamRecord & record) const
+{
+    if(record.payloadLength > _maxPayloadLength) {
+        return false;
+    }
+    if(_predicate) {
+        return _predicate(record, _context);
+    }
+    if(record.tnf != _tnf) {
+        return false;
+    }
+    // the decoder keeps the first NDEF_STREAM_MAX_TYPE bytes of the type
+    byte compared = _typeLength < NDEF_STREAM_MAX_TYPE ? _typeLength : NDEF_STREAM_MAX_TYPE;
+    return !_type || (record.typeLength == _typeLength && memcmp(record.type, _type, compared) == 0);
+}
+
+bool NdefRecordFilter::fits(uint32_t remaining) const
+{
+    // a short record header is 3 bytes, then the type
+    return _predicate || remaining >= 3u + _typeLength;
+}
@@ -0,0 +1,34 @@
+#ifndef NdefRecordFilter_h
+#define NdefRecordFilter_h
+
+#include "NdefStreamDecoder.h"
+
+#define NDEF_ANY_PAYLOAD_LENGTH 0xFFFFFFFF
+
+typedef bool (*NdefRecordPredicate)(const NdefStreamRecord & record, void * context);
+
+// Which record a filtered read (NfcAdapter::read(filter, record)) is after: by TNF and type, or a predicate on the
+// record header. Records with a longer payload than maxPayloadLength never match.
+class NdefRecordFilter
+{
+    public:
+        // any record of tnf, or only those of type (a C string, eg "U" or "acme.com:asset")
+        NdefRecordFilter(NdefRecord::TNF tnf, const char * type = NULL,
+                         uint32_t maxPayloadLength = NDEF_ANY_PAYLOAD_LENGTH);
+        NdefRecordFilter(NdefRecord::TNF tnf, const byte * type, byte typeLength,
+                         uint32_t maxPayloadLength = NDEF_ANY_PAYLOAD_LENGTH);
+        NdefRecordFilter(NdefRecordPredicate predicate, void * context = NULL,
+                         uint32_t maxPayloadLength = NDEF_ANY_PAYLOAD_LENGTH);
+        bool matches(const NdefStreamRecord & record) const;
+        // whether a record that matches could still fit in remaining bytes of the NDEF TLV
+        bool fits(uint32_t remaining) const;
+    private:
+        NdefRecordPredicate _predicate;
+        void * _context;
+        NdefRecord::TNF _tnf;
+        const byte * _type;         // NULL for any type
+        byte _typeLength;
+        uint32_t _maxPayloadLength;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#include "NdefRecordView.h"
+
+uint16_t NdefRecordView::parse(const byte * data, uint16_t length)
+{
+    if(length == 0) {
+        return 0;
+    }
+    // TNF and flags, type length, payload length (1 byte short record, else 4), id length if IL
+    bool sr = data[0] & 0x10;
+    bool il = data[0] & 0x8;
+    uint16_t index = 2 + (sr ? 1 : 4) + (il ? 1 : 0);
+    if(length < index) {
+        return 0;
+    }
+
+    uint32_t payloadLength = data[2];
+    if(!sr) {
+        payloadLength = (static_cast<uint32_t>(data[2]) << 24)
+                        | (static_cast<uint32_t>(data[3]) << 16)
+                        | (static_cast<uint32_t>(data[4]) << 8)
+                        |  static_cast<uint32_t>(data[5]);
+    }
+    byte idLength = il ? data[index - 1] : 0;
+
+    // a 32 bit payload length from the buffer could wrap the sum, and does not fit in a view
+    if(payloadLength > length) {
+        return 0;
+    }
+    uint32_t size = index + data[1] + idLength + payloadLength;
+    if(size > length) {
+        return 0;
+    }
+
+    _record = data;
+    _typeOffset = index;
+    _typeLength = data[1];
+    _idLength = idLength;
+    _payloadLength = payloadLength;
+    return size;
+}
+
+NdefRecord NdefRecordView::toRecord(NdefAllocator * allocator) const
+{
+    NdefRecord record(allocator);
+    record.setTnf(getTnf());
+    record.setType(getType(), _typeLength);
+    if(_idLength) {
+        record.setId(getId(), _idLength);
+    }
+    record.setPayload(getPayload(), _payloadLength);
+    return record;
+}
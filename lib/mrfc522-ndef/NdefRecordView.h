@@ -0,0 +1,63 @@
+#ifndef NdefRecordView_h
+#define NdefRecordView_h
+
+#include "NdefRecord.h"
+
+// A record inside an encoded NDEF message, read in place: type, id and payload point into the buffer, which has
+// to outlive the view. Use NdefRecord to build records.
+class NdefRecordView
+{
+    public:
+        NdefRecordView() : _record(NULL), _typeOffset(0), _typeLength(0), _idLength(0), _payloadLength(0) {};
+        // parses the record at data, returns its encoded size or 0 if it does not fit in length bytes
+        uint16_t parse(const byte * data, uint16_t length);
+
+        // TNF_EMPTY for a view of no record, as NdefMessageView::getRecord() returns past the end
+        NdefRecord::TNF getTnf() const
+        {
+            return _record ? static_cast<NdefRecord::TNF>(_record[0] & 0x7) : NdefRecord::TNF_EMPTY;
+        };
+        // message end flag, the last record of the message; true for a view of no record
+        bool isLast() const
+        {
+            return !_record || (_record[0] & 0x40);
+        };
+        unsigned int getTypeLength() const
+        {
+            return _typeLength;
+        };
+        unsigned int getPayloadLength() const
+        {
+            return _payloadLength;
+        };
+        unsigned int getIdLength() const
+        {
+            return _idLength;
+        };
+        const byte * getType() const
+        {
+            return _record + _typeOffset;
+        };
+        const byte * getId() const
+        {
+            return getType() + _typeLength;
+        };
+        const byte * getPayload() const
+        {
+            return getId() + _idLength;
+        };
+        unsigned int getEncodedSize() const
+        {
+            return _typeOffset + _typeLength + _idLength + _payloadLength;
+        };
+        // an owning copy
+        NdefRecord toRecord(NdefAllocator * allocator = NULL) const;
+    private:
+        const byte * _record;   // TNF and flags byte
+        byte _typeOffset;
+        byte _typeLength;
+        byte _idLength;
+        uint16_t _payloadLength;
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "NdefStreamDecoder.h"
+
+#define TLV_NULL 0x00
+#define TLV_NDEF_MESSAGE 0x03
+#define TLV_TERMINATOR 0xFE
+
+void NdefStreamDecoder::reset()
+{
+    _state = TLV_TYPE;
+    _tlvType = TLV_NULL;
+    _tlvRemaining = 0;
+    _fieldRemaining = 0;
+    _complete = false;
+    _stopped = false;
+    _record.index = 0;
+}
+
+void NdefStreamDecoder::emit(NdefStreamEvent::Type type, const byte * data, uint16_t length)
+{
+    if(!_callback) {
+        return;
+    }
+    NdefStreamEvent event;
+    event.type = type;
+    event.record = type == NdefStreamEvent::MESSAGE_END ? NULL : &_record;
+    event.data = data;
+    event.length = length;
+    event.offset = _record.payloadLength - _fieldRemaining;
+    _callback(event, _context);
+}
+
+// the TLV length is in: decode the NDEF message, skip anything else
+void NdefStreamDecoder::tlvLengthComplete()
+{
+    if(_tlvType == TLV_NDEF_MESSAGE) {
+        // an empty NDEF TLV is a formatted tag without a message
+        _state = _tlvRemaining ? RECORD_HEADER : DONE;
+    }
+    else {
+        _state = _tlvRemaining ? TLV_SKIP : TLV_TYPE;
+    }
+}
+
+void NdefStreamDecoder::typeStart()
+{
+    _fieldRemaining = _record.typeLength;
+    _state = RECORD_TYPE;
+    if(_fieldRemaining == 0) {
+        idStart();
+    }
+}
+
+void NdefStreamDecoder::idStart()
+{
+    _fieldRemaining = _record.idLength;
+    _state = RECORD_ID;
+    if(_fieldRemaining == 0) {
+        headerComplete();
+    }
+}
+
+// type and id are in: tell about the record, then go on with its payload
+void NdefStreamDecoder::headerComplete()
+{
+    emit(NdefStreamEvent::RECORD);
+    if(_stopped) {
+        return;
+    }
+    _fieldRemaining = _record.payloadLength;
+    _state = RECORD_PAYLOAD;
+    if(_fieldRemaining == 0) {
+        recordComplete();
+    }
+}
+
+void NdefStreamDecoder::recordComplete()
+{
+    emit(NdefStreamEvent::RECORD_END);
+    if(_stopped) {
+        return;
+    }
+    if(_record.last || _tlvRemaining == 0) {
+        // a TLV that ends before the message does is malformed
+        _complete = _record.last;
+        _state = _complete ? DONE : FAILED;
+        emit(NdefStreamEvent::MESSAGE_END);
+        return;
+    }
+    _record.index++;
+    _state = RECORD_HEADER;
+}
+
+bool NdefStreamDecoder::feed(const byte * data, uint16_t length)
+{
+    uint16_t i = 0;
+    while(i < length && _state < DONE) {
+        uint16_t available = length - i;
+
+        // skipped TLVs and payloads go in pieces, everything else a byte at a time
+        if(_state == TLV_SKIP) {
+            uint16_t skip = available < _tlvRemaining ? available : _tlvRemaining;
+            _tlvRemaining -= skip;
+            i += skip;
+            if(_tlvRemaining == 0) {
+                _state = TLV_TYPE;
+            }
+            continue;
+        }
+        if(_state >= RECORD_HEADER && _tlvRemaining == 0) {
+            _state = FAILED;        // the record runs past the end of the TLV
+            break;
+        }
+        if(_state == RECORD_PAYLOAD) {
+            uint16_t piece = available < _tlvRemaining ? available : _tlvRemaining;
+            if(piece > _fieldRemaining) {
+                piece = _fieldRemaining;
+            }
+            emit(NdefStreamEvent::PAYLOAD, &data[i], piece);
+            _fieldRemaining -= piece;
+            _tlvRemaining -= piece;
+            i += piece;
+            if(_fieldRemaining == 0 && !_stopped) {
+                recordComplete();
+            }
+            continue;
+        }
+
+        byte value = data[i++];
+        if(_state >= RECORD_HEADER) {
+            _tlvRemaining--;
+        }
+        switch(_state) {
+            case TLV_TYPE:
+                _tlvType = value;
+                if(value == TLV_TERMINATOR) {
+                    _state = DONE;
+                }
+                else if(value != TLV_NULL) {
+                    _state = TLV_LENGTH;
+                }
+                break;
+            case TLV_LENGTH:
+                _tlvRemaining = value;
+                if(value == 0xFF) {
+                    _state = TLV_LENGTH_HIGH;
+                }
+                else {
+                    tlvLengthComplete();
+                }
+                break;
+            case TLV_LENGTH_HIGH:
+                _tlvRemaining = value << 8;
+                _state = TLV_LENGTH_LOW;
+                break;
+            case TLV_LENGTH_LOW:
+                _tlvRemaining |= value;
+                tlvLengthComplete();
+                break;
+            case RECORD_HEADER:
+                _record.tnf = static_cast<NdefRecord::TNF>(value & 0x07);
+                _record.last = value & 0x40;
+                _shortRecord = value & 0x10;
+                _hasId = value & 0x08;
+                _record.idLength = 0;
+                _record.payloadLength = 0;
+                _state = RECORD_TYPE_LENGTH;
+                break;
+            case RECORD_TYPE_LENGTH:
+                _record.typeLength = value;
+                _fieldRemaining = _shortRecord ? 1 : 4;
+                _state = RECORD_PAYLOAD_LENGTH;
+                break;
+            case RECORD_PAYLOAD_LENGTH:
+                _record.payloadLength = (_record.payloadLength << 8) | value;
+                if(--_fieldRemaining == 0) {
+                    if(_hasId) {
+                        _state = RECORD_ID_LENGTH;
+                    }
+                    else {
+                        typeStart();
+                    }
+                }
+                break;
+            case RECORD_ID_LENGTH:
+                _record.idLength = value;
+                typeStart();
+                break;
+            case RECORD_TYPE: {
+                byte at = _record.typeLength - _fieldRemaining;
+                if(at < NDEF_STREAM_MAX_TYPE) {
+                    _record.type[at] = value;
+                }
+                if(--_fieldRemaining == 0) {
+                    idStart();
+                }
+                break;
+            }
+            case RECORD_ID: {
+                byte at = _record.idLength - _fieldRemaining;
+                if(at < NDEF_STREAM_MAX_ID) {
+                    _record.id[at] = value;
+                }
+                if(--_fieldRemaining == 0) {
+                    headerComplete();
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return _state != FAILED;
+}
@@ -0,0 +1,109 @@
+#ifndef NdefStreamDecoder_h
+#define NdefStreamDecoder_h
+
+#include "NdefRecord.h"
+
+// The longest record type and id kept for the RECORD event; longer ones are cut, typeLength/idLength tell
+#ifndef NDEF_STREAM_MAX_TYPE
+#define NDEF_STREAM_MAX_TYPE 32
+#endif
+#ifndef NDEF_STREAM_MAX_ID
+#define NDEF_STREAM_MAX_ID 16
+#endif
+
+// A record's header, complete before its payload starts
+struct NdefStreamRecord {
+    uint8_t index;              // 0 for the first record of the message
+    NdefRecord::TNF tnf;
+    bool last;                  // message end flag
+    byte typeLength;
+    byte type[NDEF_STREAM_MAX_TYPE];
+    byte idLength;
+    byte id[NDEF_STREAM_MAX_ID];
+    uint32_t payloadLength;
+};
+
+struct NdefStreamEvent {
+    enum Type { RECORD, PAYLOAD, RECORD_END, MESSAGE_END };
+    Type type;
+    const NdefStreamRecord * record;    // all but MESSAGE_END
+    const byte * data;                  // PAYLOAD: a piece of the payload, in the data given to feed()
+    uint16_t length;
+    uint32_t offset;                    // PAYLOAD: where the piece is in the payload
+};
+
+typedef void (*NdefStreamCallback)(const NdefStreamEvent & event, void * context);
+
+/**
+ * Decodes the TLV area of a tag as it is read, a block or page at a time, in constant memory.
+ *
+ * feed() takes the data area from its first byte on, in pieces of any size. Lock and memory control TLVs are
+ * skipped; the first NDEF message TLV is decoded into RECORD, PAYLOAD and RECORD_END events, then MESSAGE_END.
+ * The payload is passed through in place, in as many pieces as it arrived in. After the message, a terminator
+ * TLV, malformed data or stop(), done() is true and the rest is ignored.
+ */
+class NdefStreamDecoder
+{
+    public:
+        NdefStreamDecoder(NdefStreamCallback callback, void * context = NULL) : _callback(callback), _context(context)
+        {
+            reset();
+        };
+        void reset();
+        // false once the data turned out malformed
+        bool feed(const byte * data, uint16_t length);
+        // ignore the rest, from a callback when the records wanted are in
+        void stop()
+        {
+            _stopped = _state < DONE;
+            _state = _stopped ? DONE : _state;
+        };
+        bool done() const
+        {
+            return _state >= DONE;
+        };
+        bool failed() const
+        {
+            return _state == FAILED;
+        };
+        // a message was decoded to its end
+        bool complete() const
+        {
+            return _complete;
+        };
+        // stop() ended the decoding early
+        bool stopped() const
+        {
+            return _stopped;
+        };
+        // bytes left in the NDEF TLV, 0 while its length is not known yet
+        uint16_t remaining() const
+        {
+            return _state >= RECORD_HEADER && _state < DONE ? _tlvRemaining : 0;
+        };
+    private:
+        enum State {
+            TLV_TYPE, TLV_LENGTH, TLV_LENGTH_HIGH, TLV_LENGTH_LOW, TLV_SKIP,
+            RECORD_HEADER, RECORD_TYPE_LENGTH, RECORD_PAYLOAD_LENGTH, RECORD_ID_LENGTH, RECORD_TYPE, RECORD_ID,
+            RECORD_PAYLOAD, DONE, FAILED
+        };
+        void emit(NdefStreamEvent::Type type, const byte * data = NULL, uint16_t length = 0);
+        void tlvLengthComplete();
+        void typeStart();
+        void idStart();
+        void headerComplete();
+        void recordComplete();
+        NdefStreamCallback _callback;
+        void * _context;
+        State _state;
+        byte _tlvType;
+        uint16_t _tlvRemaining;     // value bytes left in the current TLV
+        uint32_t _fieldRemaining;   // bytes left in the current record field
+        bool _shortRecord;
+        bool _hasId;
+        bool _complete;
+        bool _stopped;
+        NdefStreamRecord _record;
+};
+
+#endif
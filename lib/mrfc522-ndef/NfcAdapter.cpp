@@ -4,6 +4,7 @@ bool NfcAdapter::tagPresent()
 {
     // If tag has already been authenticated nothing else will work until we stop crypto (shouldn't hurt)
     shield->PCD_StopCrypto1();
+    resetSession();
 
     if(!(shield->PICC_IsNewCardPresent() && shield->PICC_ReadCardSerial())) {
         return false;
@@ -13,7 +14,14 @@ bool NfcAdapter::tagPresent()
     Serial.printf("new card sak=0x%x type %s\n", shield->uid.sak, shield->PICC_GetTypeName(piccType));
 
 
-    return ((piccType == MFRC522::PICC_TYPE_MIFARE_1K) || (piccType == MFRC522::PICC_TYPE_MIFARE_UL));
+    return guessTagType() != NfcTag::TYPE_UNKNOWN;
+}
+
+// Same tag as the last tagPresent() still there? Also after haltTag(). Selects it again without anticollision.
+bool NfcAdapter::tagStillPresent()
+{
+    resetSession();
+    return shield->PICC_IsCardStillPresent();
 }
 
 bool NfcAdapter::erase()
@@ -26,8 +34,8 @@ bool NfcAdapter::erase()
 bool NfcAdapter::format()
 {
 #ifdef NDEF_SUPPORT_MIFARE_CLASSIC
-    if(shield->PICC_GetType(shield->uid.sak) == MFRC522::PICC_TYPE_MIFARE_1K) {
-        MifareClassic mifareClassic = MifareClassic(shield, _key);
+    if(guessTagType() == NfcTag::TYPE_MIFARE_CLASSIC) {
+        MifareClassic mifareClassic = MifareClassic(shield, _key, &_classicSession);
         return mifareClassic.formatNDEF();
     }
     else
@@ -55,7 +63,7 @@ bool NfcAdapter::clean()
 #ifdef NDEF_DEBUG
         Serial.println(F("Cleaning Mifare Classic"));
 #endif
-        MifareClassic mifareClassic = MifareClassic(shield, _key);
+        MifareClassic mifareClassic = MifareClassic(shield, _key, &_classicSession);
         return mifareClassic.formatMifare();
     }
     else
@@ -86,7 +94,7 @@ NfcTag NfcAdapter::read()
 #ifdef NDEF_DEBUG
         Serial.println(F("Reading Mifare Classic"));
 #endif
-        MifareClassic mifareClassic = MifareClassic(shield, _key);
+        MifareClassic mifareClassic = MifareClassic(shield, _key, &_classicSession, _allocator, _keyProvider);
         return mifareClassic.read();
     }
     else
@@ -95,7 +103,7 @@ NfcTag NfcAdapter::read()
 #ifdef NDEF_DEBUG
             Serial.println(F("Reading Mifare Ultralight"));
 #endif
-            MifareUltralight ultralight = MifareUltralight(shield);
+            MifareUltralight ultralight = MifareUltralight(shield, _allocator);
             return ultralight.read();
         }
         else if(type == NfcTag::TYPE_UNKNOWN) {
@@ -112,6 +120,86 @@ NfcTag NfcAdapter::read()
 
 }
 
+bool NfcAdapter::read(NdefStreamDecoder & decoder)
+{
+    uint8_t type = guessTagType();
+    decoder.reset();
+
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+    if(type == NfcTag::TYPE_MIFARE_CLASSIC) {
+        MifareClassic mifareClassic = MifareClassic(shield, _key, &_classicSession, _allocator, _keyProvider);
+        return mifareClassic.read(decoder);
+    }
+#endif
+    if(type == NfcTag::TYPE_2) {
+        MifareUltralight ultralight = MifareUltralight(shield, _allocator);
+        return ultralight.read(decoder);
+    }
+#ifdef NDEF_USE_SERIAL
+    Serial.print(F("Can not determine tag type"));
+#endif
+    return false;
+}
+
+// A filtered read in progress
+struct NfcRecordSearch {
+    const NdefRecordFilter * filter;
+    NdefRecord * record;
+    NdefStreamDecoder * decoder;
+    NdefAllocator * allocator;
+    byte * payload;         // of the matching record, while it comes in
+    bool matching;
+    bool found;
+};
+
+static void searchRecord(const NdefStreamEvent & event, void * context)
+{
+    NfcRecordSearch & search = *static_cast<NfcRecordSearch *>(context);
+    const NdefStreamRecord * record = event.record;
+
+    if(event.type == NdefStreamEvent::RECORD && search.filter->matches(*record)) {
+        // the length is the tag's word: a payload longer than the rest of the TLV is malformed, not allocated
+        if(record->payloadLength > search.decoder->remaining()) {
+            search.decoder->stop();
+            return;
+        }
+        if(record->payloadLength) {
+            search.payload = (byte *)ndef_allocate(search.allocator, record->payloadLength);
+        }
+        if(record->payloadLength && !search.payload) {
+            search.decoder->stop();
+            return;
+        }
+        search.matching = true;
+    }
+    else if(event.type == NdefStreamEvent::PAYLOAD && search.matching) {
+        memcpy(&search.payload[event.offset], event.data, event.length);
+    }
+    else if(event.type == NdefStreamEvent::RECORD_END && search.matching) {
+        search.record->setTnf(record->tnf);
+        search.record->setType(record->type, record->typeLength < NDEF_STREAM_MAX_TYPE ? record->typeLength
+                               : NDEF_STREAM_MAX_TYPE);
+        search.record->setId(record->id, record->idLength < NDEF_STREAM_MAX_ID ? record->idLength : NDEF_STREAM_MAX_ID);
+        search.record->setPayload(search.payload, record->payloadLength);
+        search.found = true;
+        search.decoder->stop();
+    }
+    else if(event.type == NdefStreamEvent::RECORD_END && !search.filter->fits(search.decoder->remaining())) {
+        // too few bytes left in the TLV for another record of the type
+        search.decoder->stop();
+    }
+}
+
+bool NfcAdapter::read(const NdefRecordFilter & filter, NdefRecord & record)
+{
+    NfcRecordSearch search = { &filter, &record, NULL, _allocator, NULL, false, false };
+    NdefStreamDecoder decoder(searchRecord, &search);
+    search.decoder = &decoder;
+    read(decoder);
+    ndef_release(_allocator, search.payload);
+    return search.found;
+}
+
 bool NfcAdapter::write(NdefMessage & ndefMessage)
 {
     uint8_t type = guessTagType();
@@ -121,7 +209,7 @@ bool NfcAdapter::write(NdefMessage & ndefMessage)
 #ifdef NDEF_DEBUG
         Serial.println(F("Writing Mifare Classic"));
 #endif
-        MifareClassic mifareClassic = MifareClassic(shield, _key);
+        MifareClassic mifareClassic = MifareClassic(shield, _key, &_classicSession);
         return mifareClassic.write(ndefMessage);
     }
     else
@@ -148,19 +236,97 @@ bool NfcAdapter::write(NdefMessage & ndefMessage)
         }
 }
 
+bool NfcAdapter::update(NdefMessage & ndefMessage)
+{
+    uint8_t type = guessTagType();
+
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+    if(type == NfcTag::TYPE_MIFARE_CLASSIC) {
+        MifareClassic mifareClassic = MifareClassic(shield, _key, &_classicSession);
+        return mifareClassic.update(ndefMessage);
+    }
+#endif
+    if(type == NfcTag::TYPE_2) {
+        MifareUltralight mifareUltralight = MifareUltralight(shield);
+        return mifareUltralight.update(ndefMessage);
+    }
+#ifdef NDEF_USE_SERIAL
+    Serial.print(F("Can not determine tag type"));
+#endif
+    return false;
+}
+
+bool NfcAdapter::write(const PreparedNdefWrite & prepared)
+{
+    uint8_t type = guessTagType();
+
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+    if(type == NfcTag::TYPE_MIFARE_CLASSIC) {
+        MifareClassic mifareClassic = MifareClassic(shield, _key, &_classicSession);
+        return mifareClassic.write(prepared);
+    }
+#endif
+    if(type == NfcTag::TYPE_2) {
+        MifareUltralight mifareUltralight = MifareUltralight(shield);
+        return mifareUltralight.write(prepared);
+    }
+#ifdef NDEF_USE_SERIAL
+    Serial.print(F("Can not determine tag type"));
+#endif
+    return false;
+}
+
 // Current tag will not be "visible" until removed from the RFID field
 void NfcAdapter::haltTag()
 {
+    resetSession();
     shield->PICC_HaltA();
     shield->PCD_StopCrypto1();
 }
 
+// More tags than NFC_MAX_INVENTORY: the first ones are reported, the rest stay in the field untouched
+byte NfcAdapter::inventory()
+{
+    shield->PCD_StopCrypto1();
+    resetSession();
+    MFRC522::StatusCode status = shield->PICC_Inventory(_inventory, NFC_MAX_INVENTORY, &_inventoryCount);
+#ifdef NDEF_USE_SERIAL
+    if(status != MFRC522::STATUS_OK) {
+        Serial.print(F("Inventory stopped: "));
+        Serial.println(shield->GetStatusCodeName(status));
+    }
+#else
+    (void)status;
+#endif
+    return _inventoryCount;
+}
+
+// Selects this tag by its full UID, the others stay halted
+bool NfcAdapter::selectTag(byte index)
+{
+    if(index >= _inventoryCount) {
+        return false;
+    }
+    resetSession();
+    shield->uid = _inventory[index].uid;
+    return shield->PICC_Reselect(&shield->uid) == MFRC522::STATUS_OK;
+}
+
+// The tag is selected again or halted: it is no longer authenticated
+void NfcAdapter::resetSession()
+{
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+    _classicSession.reset();
+#endif
+}
+
 NfcTag::TagType NfcAdapter::guessTagType()
 {
 
     MFRC522::PICC_Type piccType = (MFRC522::PICC_Type)shield->PICC_GetType(shield->uid.sak);
 
-    if(piccType == MFRC522::PICC_TYPE_MIFARE_1K) {
+    if(piccType == MFRC522::PICC_TYPE_MIFARE_MINI || piccType == MFRC522::PICC_TYPE_MIFARE_1K
+       || piccType == MFRC522::PICC_TYPE_MIFARE_4K) {
         return NfcTag::TYPE_MIFARE_CLASSIC;
     }
     else if(piccType == MFRC522::PICC_TYPE_MIFARE_UL) {
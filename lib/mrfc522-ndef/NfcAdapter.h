@@ -4,6 +4,7 @@
 #include "MFRC522_I2C.h"
 #include "NfcTag.h"
 #include "Ndef.h"
+#include "NdefRecordFilter.h"
 
 // Drivers
 #include "MifareClassic.h"
@@ -11,10 +12,18 @@
 
 //#define NDEF_DEBUG 1
 
+// The most tags inventory() reports
+#ifndef NFC_MAX_INVENTORY
+#define NFC_MAX_INVENTORY 8
+#endif
+
 class NfcAdapter
 {
     public:
-        NfcAdapter(MFRC522 * interface) : shield(interface)
+        NfcAdapter(MFRC522 * interface) : shield(interface), _allocator(NULL), _inventoryCount(0)
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+            , _keyProvider(NULL)
+#endif
         {
             _key = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
         };
@@ -42,8 +51,27 @@ class NfcAdapter
 #endif
         };
         bool tagPresent(); // tagAvailable
+        bool tagStillPresent();
+        // the UID of the current tag
+        const MFRC522::Uid & uid()
+        {
+            return shield->uid;
+        };
         NfcTag read();
+        // decode the message while it is read, without buffering it; false if the tag has none
+        bool read(NdefStreamDecoder & decoder);
+        // the first record filter matches into record; reading stops as soon as it is in, or cannot come anymore
+        bool read(const NdefRecordFilter & filter, NdefRecord & record);
+        // where the tags read() returns keep their message, NULL (the default) for the heap
+        void setAllocator(NdefAllocator * allocator)
+        {
+            _allocator = allocator;
+        };
         bool write(NdefMessage & ndefMessage);
+        // the same message for many tags: encoded once, patched per tag
+        bool write(const PreparedNdefWrite & prepared);
+        // write only the blocks or pages that differ from what the tag holds, the TLV length last
+        bool update(NdefMessage & ndefMessage);
         // erase tag by writing an empty NDEF record
         bool erase();
         // format a tag as NDEF
@@ -51,11 +79,44 @@ class NfcAdapter
         // reset tag back to factory state
         bool clean();
         void haltTag();
+        // find all tags in the field, they are left halted; returns how many
+        byte inventory();
+        byte inventoryCount()
+        {
+            return _inventoryCount;
+        };
+        const MFRC522::PICC_Info & inventoryTag(byte index)
+        {
+            return _inventory[index];
+        };
+        // make a tag found by inventory() the one read(), write() etc work on
+        bool selectTag(byte index);
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+        // MIFARE Classic authentications done and saved so far
+        const MifareClassicSession & classicSession()
+        {
+            return _classicSession;
+        };
+        // the keys MIFARE Classic reads try instead of the one begin() got, NULL for that one again: a
+        // MifareKeyResolver, MifareDiversifiedKeys or one of your own
+        void setKeyProvider(MifareKeyProvider * provider)
+        {
+            _keyProvider = provider;
+        };
+#endif
     private:
         MFRC522 * shield;
         NfcTag::TagType guessTagType();
         bool _verbose;
         MFRC522::MIFARE_Key _key;
+        NdefAllocator * _allocator;
+        MFRC522::PICC_Info _inventory[NFC_MAX_INVENTORY];
+        byte _inventoryCount;
+#ifdef NDEF_SUPPORT_MIFARE_CLASSIC
+        MifareClassicSession _classicSession;
+        MifareKeyProvider * _keyProvider;
+#endif
+        void resetSession();
 };
 
 #endif
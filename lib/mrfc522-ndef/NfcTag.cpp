@@ -1,3 +1,4 @@
+#include <new>
 #include "NfcTag.h"
 
 NfcTag::NfcTag(byte * uid, uint8_t  uidLength, TagType tagType)
@@ -5,7 +6,11 @@ NfcTag::NfcTag(byte * uid, uint8_t  uidLength, TagType tagType)
     _uid = uid;
     _uidLength = uidLength;
     _tagType = tagType;
-    _ndefMessage = (NdefMessage *)NULL;
+    _allocator = NULL;
+    _ndefData = NULL;
+    _ndefMessage = NULL;
+    _ndefDataLength = 0;
+    _hasNdefMessage = false;
     _isFormatted = false;
 }
 
@@ -14,45 +19,150 @@ NfcTag::NfcTag(byte * uid, uint8_t  uidLength, TagType tagType, bool isFormatted
     _uid = uid;
     _uidLength = uidLength;
     _tagType = tagType;
-    _ndefMessage = (NdefMessage *)NULL;
+    _allocator = NULL;
+    _ndefData = NULL;
+    _ndefMessage = NULL;
+    _ndefDataLength = 0;
+    _hasNdefMessage = false;
     _isFormatted = isFormatted;
 }
 
-NfcTag::NfcTag(byte * uid, uint8_t  uidLength, TagType tagType, NdefMessage & ndefMessage)
+NfcTag::NfcTag(byte * uid, uint8_t  uidLength, TagType tagType, NdefMessage & ndefMessage,
+               NdefAllocator * allocator)
 {
     _uid = uid;
     _uidLength = uidLength;
     _tagType = tagType;
-    _ndefMessage = new NdefMessage(ndefMessage);
+    _allocator = allocator;
+    _ndefData = NULL;
+    _ndefMessage = NULL;
+    byte * data = allocateNdefData(ndefMessage.getEncodedSize());
+    if(data) {
+        ndefMessage.encode(data);
+    }
     _isFormatted = true; // If it has a message it's formatted
 }
 
-NfcTag::NfcTag(byte * uid, uint8_t uidLength, TagType tagType, const byte * ndefData, const uint16_t ndefDataLength)
+NfcTag::NfcTag(byte * uid, uint8_t uidLength, TagType tagType, const byte * ndefData, const uint16_t ndefDataLength,
+               NdefAllocator * allocator)
 {
     _uid = uid;
     _uidLength = uidLength;
     _tagType = tagType;
-    _ndefMessage = new NdefMessage(ndefData, ndefDataLength);
+    _allocator = allocator;
+    _ndefData = NULL;
+    _ndefMessage = NULL;
+    setNdefData(ndefData, ndefDataLength);
     _isFormatted = true; // If it has a message it's formatted
 }
 
+NfcTag::NfcTag(const NfcTag & rhs)
+{
+    _uid = rhs._uid;
+    _uidLength = rhs._uidLength;
+    _tagType = rhs._tagType;
+    _allocator = rhs._allocator;
+    _ndefData = NULL;
+    _ndefMessage = NULL;
+    _ndefDataLength = 0;
+    _hasNdefMessage = false;
+    if(rhs._hasNdefMessage) {
+        setNdefData(rhs._ndefData, rhs._ndefDataLength);
+    }
+    _isFormatted = rhs._isFormatted;
+}
+
+NfcTag::NfcTag(NfcTag && rhs)
+{
+    _uid = rhs._uid;
+    _uidLength = rhs._uidLength;
+    _tagType = rhs._tagType;
+    _allocator = rhs._allocator;
+    _ndefData = rhs._ndefData;
+    _ndefDataLength = rhs._ndefDataLength;
+    _hasNdefMessage = rhs._hasNdefMessage;
+    _ndefMessage = rhs._ndefMessage;
+    _isFormatted = rhs._isFormatted;
+    rhs._ndefData = NULL;
+    rhs._ndefMessage = NULL;
+    rhs.releaseNdef();
+}
+
 NfcTag::~NfcTag()
 {
-    delete _ndefMessage;
+    releaseNdef();
 }
 
 NfcTag & NfcTag::operator=(const NfcTag & rhs)
 {
     if(this != &rhs) {
-        delete _ndefMessage;
         _uid = rhs._uid;
         _uidLength = rhs._uidLength;
         _tagType = rhs._tagType;
-        _ndefMessage = new NdefMessage(*rhs._ndefMessage);
+        releaseNdef();
+        if(rhs._hasNdefMessage) {
+            setNdefData(rhs._ndefData, rhs._ndefDataLength);
+        }
+        _isFormatted = rhs._isFormatted;
+    }
+    return *this;
+}
+
+// Takes over rhs's message if it comes from the same allocator, else copies it
+NfcTag & NfcTag::operator=(NfcTag && rhs)
+{
+    if(_allocator != rhs._allocator) {
+        return *this = static_cast<const NfcTag &>(rhs);
+    }
+    if(this != &rhs) {
+        releaseNdef();
+        _uid = rhs._uid;
+        _uidLength = rhs._uidLength;
+        _tagType = rhs._tagType;
+        _ndefData = rhs._ndefData;
+        _ndefDataLength = rhs._ndefDataLength;
+        _hasNdefMessage = rhs._hasNdefMessage;
+        _ndefMessage = rhs._ndefMessage;
+        _isFormatted = rhs._isFormatted;
+        rhs._ndefData = NULL;
+        rhs._ndefMessage = NULL;
+        rhs.releaseNdef();
     }
     return *this;
 }
 
+// frees the encoded message and the one decoded from it
+void NfcTag::releaseNdef()
+{
+    if(_ndefMessage) {
+        _ndefMessage->~NdefMessage();
+        ndef_release(_allocator, _ndefMessage);
+        _ndefMessage = NULL;
+    }
+    ndef_release(_allocator, _ndefData);
+    _ndefData = NULL;
+    _ndefDataLength = 0;
+    _hasNdefMessage = false;
+}
+
+// copies the encoded message, _ndefData must not hold one yet
+void NfcTag::setNdefData(const byte * ndefData, uint16_t ndefDataLength)
+{
+    byte * data = allocateNdefData(ndefDataLength);
+    if(data) {
+        memcpy(data, ndefData, ndefDataLength);
+    }
+}
+
+// Room for the encoded message, to be filled by the caller; NULL if it is empty or could not be had
+byte * NfcTag::allocateNdefData(uint16_t ndefDataLength)
+{
+    _ndefData = ndefDataLength ? (byte *)ndef_allocate(_allocator, ndefDataLength) : NULL;
+    _ndefDataLength = _ndefData ? ndefDataLength : 0;
+    _hasNdefMessage = _ndefData || !ndefDataLength;
+    return _ndefData;
+}
+
 uint8_t NfcTag::getUidLength()
 {
     return _uidLength;
@@ -89,14 +199,34 @@ NfcTag::TagType NfcTag::getTagType()
 
 boolean NfcTag::hasNdefMessage()
 {
-    return (_ndefMessage != NULL);
+    return _hasNdefMessage;
 }
 
 NdefMessage NfcTag::getNdefMessage()
 {
+    return _ndefData ? NdefMessage(_ndefData, _ndefDataLength, _allocator) : NdefMessage(_allocator);
+}
+
+// Without memory for it (the allocator is exhausted) the message is empty
+const NdefMessage & NfcTag::message() const
+{
+    if(!_ndefMessage) {
+        void * memory = ndef_allocate(_allocator, sizeof(NdefMessage));
+        if(!memory) {
+            static const NdefMessage empty;
+            return empty;
+        }
+        _ndefMessage = _ndefData ? new(memory) NdefMessage(_ndefData, _ndefDataLength, _allocator)
+                       : new(memory) NdefMessage(_allocator);
+    }
     return *_ndefMessage;
 }
 
+NdefMessageView NfcTag::getNdefMessageView()
+{
+    return NdefMessageView(_ndefData, _ndefDataLength);
+}
+
 bool NfcTag::isFormatted()
 {
     return _isFormatted;
@@ -109,11 +239,11 @@ void NfcTag::print()
     Serial.println(_tagType);
     Serial.print(F("UID "));
     Serial.println(getUidString());
-    if(_ndefMessage == NULL) {
+    if(!_hasNdefMessage) {
         Serial.println(F("\nNo NDEF Message"));
     }
     else {
-        _ndefMessage->print();
+        getNdefMessage().print();
     }
 }
 #endif
@@ -4,6 +4,7 @@
 #include <inttypes.h>
 #include <Arduino.h>
 #include "NdefMessage.h"
+#include "NdefMessageView.h"
 
 class NfcTag
 {
@@ -11,25 +12,46 @@ class NfcTag
         enum TagType { TYPE_MIFARE_CLASSIC = 0, TYPE_1, TYPE_2, TYPE_3, TYPE_4, TYPE_UNKNOWN = 99 };
         NfcTag(byte * uid, uint8_t uidLength, TagType tagType);
         NfcTag(byte * uid, uint8_t uidLength, TagType tagType, bool isFormatted);
-        NfcTag(byte * uid, uint8_t uidLength, TagType tagType, NdefMessage & ndefMessage);
-        NfcTag(byte * uid, uint8_t uidLength, TagType tagType, const byte * ndefData, const uint16_t ndefDataLength);
+        NfcTag(byte * uid, uint8_t uidLength, TagType tagType, NdefMessage & ndefMessage,
+               NdefAllocator * allocator = NULL);
+        NfcTag(byte * uid, uint8_t uidLength, TagType tagType, const byte * ndefData, const uint16_t ndefDataLength,
+               NdefAllocator * allocator = NULL);
+        NfcTag(const NfcTag & rhs);
+        NfcTag(NfcTag && rhs);
         ~NfcTag(void);
         NfcTag & operator=(const NfcTag & rhs);
+        NfcTag & operator=(NfcTag && rhs);
         uint8_t getUidLength();
         void getUid(byte * uid, uint8_t * uidLength);
         String getUidString();
         TagType getTagType();
         bool hasNdefMessage();
+        // a copy of the message
         NdefMessage getNdefMessage();
+        // the message, decoded on the first call and kept with the tag
+        const NdefMessage & message() const;
+        // the message read in place, valid as long as the tag
+        NdefMessageView getNdefMessageView();
         bool isFormatted();
 #ifdef NDEF_USE_SERIAL
         void print();
 #endif
     private:
+        // their read() fills the message in place, with allocateNdefData()
+        friend class MifareClassic;
+        friend class MifareUltralight;
         byte * _uid;
         uint8_t _uidLength;
         TagType _tagType; // Mifare Classic, NFC Forum Type {1,2,3,4}, Unknown
-        NdefMessage * _ndefMessage;
+        // the encoded message; NdefMessage is only decoded from it on request
+        NdefAllocator * _allocator;     // for both, NULL for the heap
+        byte * _ndefData;
+        uint16_t _ndefDataLength;
+        bool _hasNdefMessage;
+        mutable NdefMessage * _ndefMessage;     // decoded by message()
+        void setNdefData(const byte * ndefData, uint16_t ndefDataLength);
+        byte * allocateNdefData(uint16_t ndefDataLength);
+        void releaseNdef();
         /**
          * if tag is not formatted it is most probably in HALTED state as soon as we realize that
          * because authentication failed => We need to call PICC_WakeupA
@@ -0,0 +1,147 @@
+#include "NfcTagMonitor.h"
+
+NfcTagMonitor::NfcTagMonitor(NfcAdapter * adapter) : _nfc(adapter), _present(false), _arrivedMs(0), _lastSeenMs(0),
+    _reportedMs(0), _misses(0), _idleMs(0), _callbackCount(0)
+{
+    _uid.size = 0;
+#ifdef ESP_PLATFORM
+    _queueCount = 0;
+    _task = NULL;
+    _stop = false;
+    _done = NULL;
+#endif
+}
+
+#ifdef ESP_PLATFORM
+NfcTagMonitor::~NfcTagMonitor()
+{
+    end();
+    if(_done) {
+        vSemaphoreDelete(_done);
+    }
+}
+#endif
+
+// Subscribe before begin(), the list is not locked
+bool NfcTagMonitor::subscribe(NfcTagEventCallback callback, void * context)
+{
+    if(_callbackCount == NFC_MONITOR_SUBSCRIBERS) {
+        return false;
+    }
+    _callbacks[_callbackCount] = callback;
+    _contexts[_callbackCount] = context;
+    _callbackCount++;
+    return true;
+}
+
+// One look at the reader, events are emitted from here. Returns the time in ms until the next one is due.
+uint32_t NfcTagMonitor::poll()
+{
+    if(!_present) {
+        if(!_nfc->tagPresent()) {
+            _idleMs = _idleMs < config.fastPollMs ? config.fastPollMs : _idleMs * 2;
+            if(_idleMs > config.idlePollMs) {
+                _idleMs = config.idlePollMs;
+            }
+            return _idleMs;
+        }
+        uint32_t now = millis();
+        _present = true;
+        _uid = _nfc->uid();
+        _arrivedMs = now;
+        _lastSeenMs = now;
+        _reportedMs = now;
+        _misses = 0;
+        emit(NfcTagEvent::ARRIVED, now);
+        return config.presentPollMs;
+    }
+
+    if(_nfc->tagStillPresent()) {
+        uint32_t now = millis();
+        _lastSeenMs = now;
+        _misses = 0;
+        if(config.stillPresentMs && now - _reportedMs >= config.stillPresentMs) {
+            _reportedMs = now;
+            emit(NfcTagEvent::STILL_PRESENT, now);
+        }
+        return config.presentPollMs;
+    }
+    if(++_misses < config.departMisses) {
+        return config.fastPollMs;   // look again soon, it may have been a bad frame
+    }
+    _present = false;
+    _idleMs = 0;
+    emit(NfcTagEvent::DEPARTED, millis());
+    return config.fastPollMs;
+}
+
+void NfcTagMonitor::emit(NfcTagEvent::Type type, uint32_t timeMs)
+{
+    NfcTagEvent event;
+    event.type = type;
+    event.uid = _uid;
+    event.timeMs = timeMs;
+    event.presentMs = (type == NfcTagEvent::DEPARTED ? _lastSeenMs : timeMs) - _arrivedMs;
+    for(byte i = 0; i < _callbackCount; i++) {
+        _callbacks[i](event, _contexts[i]);
+    }
+#ifdef ESP_PLATFORM
+    for(byte i = 0; i < _queueCount; i++) {
+        xQueueSend(_queues[i], &event, 0);
+    }
+#endif
+}
+
+#ifdef ESP_PLATFORM
+bool NfcTagMonitor::subscribe(QueueHandle_t queue)
+{
+    if(_queueCount == NFC_MONITOR_SUBSCRIBERS) {
+        return false;
+    }
+    _queues[_queueCount++] = queue;
+    return true;
+}
+
+bool NfcTagMonitor::begin(UBaseType_t priority, uint32_t stackSize, BaseType_t core)
+{
+    if(_task) {
+        return false;
+    }
+    if(!_done && !(_done = xSemaphoreCreateBinary())) {
+        return false;
+    }
+    _stop = false;
+    TaskHandle_t task;
+    if(xTaskCreatePinnedToCore(run, "NfcTagMonitor", stackSize, this, priority, &task, core) != pdPASS) {
+        return false;
+    }
+    _task = task;
+    return true;
+}
+
+// Waits until the task is done with the poll it is in, if any, and has exited. Called from a callback, which runs
+// in the task, it can only ask it to stop: the next end() or the destructor collects it.
+void NfcTagMonitor::end()
+{
+    TaskHandle_t task = _task;
+    if(!task) {
+        return;
+    }
+    _stop = true;
+    if(task == xTaskGetCurrentTaskHandle()) {
+        return;
+    }
+    xSemaphoreTake(_done, portMAX_DELAY);
+    _task = NULL;
+}
+
+void NfcTagMonitor::run(void * arg)
+{
+    NfcTagMonitor * monitor = (NfcTagMonitor *)arg;
+    while(!monitor->_stop) {
+        vTaskDelay(pdMS_TO_TICKS(monitor->poll()));
+    }
+    xSemaphoreGive(monitor->_done);     // the monitor may be gone from here on
+    vTaskDelete(NULL);
+}
+#endif
@@ -0,0 +1,89 @@
+#ifndef NfcTagMonitor_h
+#define NfcTagMonitor_h
+
+#include "NfcAdapter.h"
+
+#ifdef ESP_PLATFORM
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#endif
+
+// The most callbacks (and queues) subscribe() accepts
+#ifndef NFC_MONITOR_SUBSCRIBERS
+#define NFC_MONITOR_SUBSCRIBERS 4
+#endif
+
+struct NfcTagEvent {
+    enum Type { ARRIVED, STILL_PRESENT, DEPARTED };
+    Type type;
+    MFRC522::Uid uid;
+    uint32_t timeMs;        // millis() when the event was detected
+    uint32_t presentMs;     // time since the tag arrived; DEPARTED: until it was last seen
+};
+
+typedef void (*NfcTagEventCallback)(const NfcTagEvent & event, void * context);
+
+/**
+ * Watches the reader for a tag arriving, resting and leaving, and tells subscribers.
+ *
+ * Without a tag the reader is polled with REQA (NfcAdapter::tagPresent()), starting at fastPollMs after a tag
+ * left and backing off to idlePollMs. A tag on the reader is checked every presentPollMs by reselecting its
+ * UID (NfcAdapter::tagStillPresent()), which is much cheaper and does not re-read it. It has departed after
+ * departMisses checks in a row failed, so a single bad frame does not end a visit.
+ *
+ * begin() runs the monitor in its own FreeRTOS task, which then owns the NfcAdapter: other tasks must not
+ * use it. Callbacks run in that task, so an ARRIVED callback can read or write the tag, which is selected.
+ * end(), and the destructor, wait for the task to finish its poll and exit. Without a task, call poll() and wait
+ * the time it returns.
+ */
+class NfcTagMonitor
+{
+    public:
+        struct Config {
+            uint16_t fastPollMs = 20;       // no tag, just after one left: the next often follows
+            uint16_t idlePollMs = 250;      // no tag for a while
+            uint16_t presentPollMs = 100;   // presence checks of a tag on the reader
+            uint16_t stillPresentMs = 1000; // STILL_PRESENT events at most this often, 0 for none
+            byte departMisses = 2;          // failed presence checks in a row before DEPARTED
+        };
+        Config config;
+
+        NfcTagMonitor(NfcAdapter * adapter);
+#ifdef ESP_PLATFORM
+        ~NfcTagMonitor();
+#endif
+        bool subscribe(NfcTagEventCallback callback, void * context = NULL);
+#ifdef ESP_PLATFORM
+        bool subscribe(QueueHandle_t queue);    // NfcTagEvent items, dropped when the queue is full
+        bool begin(UBaseType_t priority = 1, uint32_t stackSize = 8192, BaseType_t core = tskNO_AFFINITY);
+        void end();
+#endif
+        uint32_t poll();
+        bool tagPresent()
+        {
+            return _present;
+        };
+    private:
+        NfcAdapter * _nfc;
+        bool _present;
+        MFRC522::Uid _uid;
+        uint32_t _arrivedMs;
+        uint32_t _lastSeenMs;
+        uint32_t _reportedMs;
+        byte _misses;
+        uint16_t _idleMs;           // the current back off without a tag
+        NfcTagEventCallback _callbacks[NFC_MONITOR_SUBSCRIBERS];
+        void * _contexts[NFC_MONITOR_SUBSCRIBERS];
+        byte _callbackCount;
+#ifdef ESP_PLATFORM
+        QueueHandle_t _queues[NFC_MONITOR_SUBSCRIBERS];
+        byte _queueCount;
+        TaskHandle_t volatile _task;
+        volatile bool _stop;
+        SemaphoreHandle_t _done;    // given by the task as it exits
+        static void run(void * arg);
+#endif
+        void emit(NfcTagEvent::Type type, uint32_t timeMs);
+};
+
+#endif
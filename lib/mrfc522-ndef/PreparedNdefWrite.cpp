@@ -0,0 +1,104 @@
+#include "PreparedNdefWrite.h"
+
+PreparedNdefWrite::PreparedNdefWrite(const NdefMessage & message, NdefAllocator * allocator)
+    : _allocator(allocator), _patchCount(0)
+{
+    // the TLV length and the image size are 16 bits, a longer message gets no image
+    unsigned int messageLength = message.getEncodedSize();
+    _messageLength = messageLength <= 0xFFFF - 4 - NDEF_IMAGE_BLOCK_SIZE ? messageLength : 0;
+    _messageStart = _messageLength < 0xFF ? 2 : 4;
+    _size = _messageLength == messageLength ? imageSize(_messageLength) : 0;
+    _image = _size ? (byte *)ndef_allocate(_allocator, _size) : NULL;
+    if(_image) {
+        encodeImage(message, _messageLength, _image);
+    }
+    else {
+        _size = 0;
+#ifdef NDEF_USE_SERIAL
+        Serial.println(F("No memory for the prepared message"));
+#endif
+    }
+}
+
+PreparedNdefWrite::~PreparedNdefWrite()
+{
+    ndef_release(_allocator, _image);
+}
+
+uint16_t PreparedNdefWrite::imageSize(uint16_t messageLength)
+{
+    // TLV header 2 or 4 bytes, message, terminator
+    uint16_t size = (messageLength < 0xFF ? 2 : 4) + messageLength + 1;
+    return (size + NDEF_IMAGE_BLOCK_SIZE - 1) / NDEF_IMAGE_BLOCK_SIZE * NDEF_IMAGE_BLOCK_SIZE;
+}
+
+// image holds imageSize(messageLength) bytes
+void PreparedNdefWrite::encodeImage(const NdefMessage & message, uint16_t messageLength, byte * image)
+{
+    uint16_t start = 2;
+    image[0] = 0x3;
+    if(messageLength < 0xFF) {
+        image[1] = messageLength;
+    }
+    else {
+        image[1] = 0xFF;
+        image[2] = ((messageLength >> 8) & 0xFF);
+        image[3] = (messageLength & 0xFF);
+        start = 4;
+    }
+    message.encode(&image[start]);
+    uint16_t end = start + messageLength;
+    image[end] = 0xFE; // terminator
+    memset(&image[end + 1], 0, imageSize(messageLength) - end - 1);
+}
+
+int8_t PreparedNdefWrite::addPatch(const char * placeholder)
+{
+    return addPatch((const byte *)placeholder, strlen(placeholder));
+}
+
+int8_t PreparedNdefWrite::addPatch(const byte * placeholder, uint16_t length)
+{
+    if(!_image || _patchCount == NDEF_PREPARED_MAX_PATCHES || length == 0 || length > _messageLength) {
+        return -1;
+    }
+    for(uint16_t i = _messageStart; i + length <= _messageStart + _messageLength; i++) {
+        if(memcmp(&_image[i], placeholder, length) == 0) {
+            _patches[_patchCount].offset = i;
+            _patches[_patchCount].length = length;
+            return _patchCount++;
+        }
+    }
+    return -1;
+}
+
+bool PreparedNdefWrite::patch(int8_t index, const byte * value)
+{
+    if(index < 0 || index >= _patchCount) {
+        return false;
+    }
+    memcpy(&_image[_patches[index].offset], value, _patches[index].length);
+    return true;
+}
+
+bool PreparedNdefWrite::patch(int8_t index, const char * value)
+{
+    if(index < 0 || index >= _patchCount || strlen(value) != _patches[index].length) {
+        return false;
+    }
+    return patch(index, (const byte *)value);
+}
+
+bool PreparedNdefWrite::patchHex(int8_t index, const byte * data, uint8_t length)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    if(index < 0 || index >= _patchCount || 2 * length != _patches[index].length) {
+        return false;
+    }
+    byte * field = &_image[_patches[index].offset];
+    for(uint8_t i = 0; i < length; i++) {
+        field[2 * i] = digits[data[i] >> 4];
+        field[2 * i + 1] = digits[data[i] & 0xF];
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef PreparedNdefWrite_h
+#define PreparedNdefWrite_h
+
+#include "NdefMessage.h"
+
+// The most patch points a prepared write has
+#ifndef NDEF_PREPARED_MAX_PATCHES
+#define NDEF_PREPARED_MAX_PATCHES 4
+#endif
+
+// What the drivers write to the data area, blocks of 16 bytes (4 Ultralight pages or one Classic block)
+#define NDEF_IMAGE_BLOCK_SIZE 16
+
+/**
+ * A message encoded once, as the drivers write it: NDEF TLV, message, terminator TLV, zeros up to a whole block.
+ *
+ * For writing the same message to many tags. Fields that differ per tag (a serial number, a URL with the UID in
+ * it) are placeholders in the message, made patch points with addPatch(), and overwritten in the image before
+ * each write with patch() or patchHex(). A patch keeps the placeholder's length so nothing else moves.
+ */
+class PreparedNdefWrite
+{
+    public:
+        explicit PreparedNdefWrite(const NdefMessage & message, NdefAllocator * allocator = NULL);
+        ~PreparedNdefWrite();
+        // false if there was no memory for the image
+        bool isValid() const
+        {
+            return _image != NULL;
+        };
+        // the first bytes of the message that equal placeholder become a patch point; its index, -1 if none
+        int8_t addPatch(const char * placeholder);
+        int8_t addPatch(const byte * placeholder, uint16_t length);
+        // value has the placeholder's length
+        bool patch(int8_t index, const byte * value);
+        bool patch(int8_t index, const char * value);
+        // data in upper case hex, length bytes for a placeholder of 2 * length characters
+        bool patchHex(int8_t index, const byte * data, uint8_t length);
+
+        const byte * image() const
+        {
+            return _image;
+        };
+        uint16_t size() const
+        {
+            return _size;
+        };
+        uint16_t messageLength() const
+        {
+            return _messageLength;
+        };
+
+        // what the drivers write for a message of messageLength bytes
+        static uint16_t imageSize(uint16_t messageLength);
+        static void encodeImage(const NdefMessage & message, uint16_t messageLength, byte * image);
+    private:
+        PreparedNdefWrite(const PreparedNdefWrite & rhs);
+        PreparedNdefWrite & operator=(const PreparedNdefWrite & rhs);
+        struct Patch {
+            uint16_t offset;
+            uint16_t length;
+        };
+        NdefAllocator * _allocator;
+        byte * _image;
+        uint16_t _size;
+        uint16_t _messageLength;
+        uint16_t _messageStart;
+        Patch _patches[NDEF_PREPARED_MAX_PATCHES];
+        uint8_t _patchCount;
+};
+
+#endif
@@ -0,0 +1,383 @@
+#include "Arduino.h"
+
+HostSerial Serial;
+
+uint64_t HostClock::_nowNs = 0;
+uint64_t HostClock::_idleNs = 0;
+HostClock::Pending HostClock::_events[HostClock::MAX_EVENTS];
+uint8_t HostClock::_eventCount = 0;
+
+uint64_t HostClock::now()
+{
+    return _nowNs / 1000;
+}
+
+uint64_t HostClock::nowNs()
+{
+    return _nowNs;
+}
+
+void HostClock::advance(uint64_t us)
+{
+    runUntil(_nowNs + us * 1000);
+}
+
+void HostClock::advanceNs(uint64_t ns)
+{
+    runUntil(_nowNs + ns);
+}
+
+void HostClock::reset()
+{
+    _nowNs = 0;
+    _idleNs = 0;
+    _eventCount = 0;
+}
+
+/**
+ * Runs event(context) once the clock reaches atNs. Returns false if too many events are pending.
+ */
+bool HostClock::schedule(uint64_t atNs, Event event, void * context)
+{
+    if(_eventCount == MAX_EVENTS) {
+        return false;
+    }
+    _events[_eventCount].atNs = atNs < _nowNs ? _nowNs : atNs;
+    _events[_eventCount].event = event;
+    _events[_eventCount].context = context;
+    _eventCount++;
+    return true;
+}
+
+void HostClock::cancel(Event event, void * context)
+{
+    for(uint8_t i = 0; i < _eventCount;) {
+        if(_events[i].event == event && _events[i].context == context) {
+            _events[i] = _events[--_eventCount];
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+uint8_t HostClock::pending()
+{
+    return _eventCount;
+}
+
+/**
+ * Blocks until the next event has run or untilNs is reached, whichever comes first. The time is idle time.
+ */
+void HostClock::sleep(uint64_t untilNs)
+{
+    uint64_t target = untilNs;
+    for(uint8_t i = 0; i < _eventCount; i++) {
+        if(_events[i].atNs < target) {
+            target = _events[i].atNs;
+        }
+    }
+    if(target > _nowNs) {
+        _idleNs += target - _nowNs;
+    }
+    runUntil(target);
+}
+
+uint64_t HostClock::idleNs()
+{
+    return _idleNs;
+}
+
+// Moves the clock to ns, running due events in time order. Events may schedule further events.
+void HostClock::runUntil(uint64_t ns)
+{
+    while(true) {
+        int8_t next = -1;
+        for(uint8_t i = 0; i < _eventCount; i++) {
+            if(_events[i].atNs <= ns && (next < 0 || _events[i].atNs < _events[next].atNs)) {
+                next = i;
+            }
+        }
+        if(next < 0) {
+            break;
+        }
+        Pending due = _events[next];
+        _events[next] = _events[--_eventCount];
+        if(due.atNs > _nowNs) {
+            _nowNs = due.atNs;
+        }
+        due.event(due.context);
+    }
+    if(ns > _nowNs) {
+        _nowNs = ns;
+    }
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(HostClock::now() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)HostClock::now();
+}
+
+void delay(unsigned long ms)
+{
+    HostClock::advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    HostClock::advance(us);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// String
+/////////////////////////////////////////////////////////////////////////////////////
+
+String::String(const char * cstr) : _buffer(NULL), _length(0)
+{
+    append(cstr ? cstr : "", cstr ? strlen(cstr) : 0);
+}
+
+String::String(const String & rhs) : _buffer(NULL), _length(0)
+{
+    append(rhs._buffer, rhs._length);
+}
+
+String::String(char c) : _buffer(NULL), _length(0)
+{
+    append(&c, 1);
+}
+
+String::String(unsigned int value, unsigned char base) : _buffer(NULL), _length(0)
+{
+    char digits[8 * sizeof(value) + 1];
+    char * p = &digits[sizeof(digits) - 1];
+    *p = '\0';
+    do {
+        unsigned int digit = value % base;
+        *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while(value);
+    append(p, strlen(p));
+}
+
+String::String(int value, unsigned char base) : _buffer(NULL), _length(0)
+{
+    if(value < 0 && base == DEC) {
+        append("-", 1);
+        *this += String((unsigned int)(-(long)value), base);
+    }
+    else {
+        *this += String((unsigned int)value, base);
+    }
+}
+
+String::~String()
+{
+    free(_buffer);
+}
+
+String & String::operator=(const String & rhs)
+{
+    if(this != &rhs) {
+        free(_buffer);
+        _buffer = NULL;
+        _length = 0;
+        append(rhs._buffer, rhs._length);
+    }
+    return *this;
+}
+
+String & String::operator+=(const String & rhs)
+{
+    append(rhs._buffer, rhs._length);
+    return *this;
+}
+
+String & String::operator+=(const char * cstr)
+{
+    append(cstr, strlen(cstr));
+    return *this;
+}
+
+String & String::operator+=(char c)
+{
+    append(&c, 1);
+    return *this;
+}
+
+bool String::operator==(const String & rhs) const
+{
+    return _length == rhs._length && memcmp(_buffer, rhs._buffer, _length) == 0;
+}
+
+bool String::operator==(const char * cstr) const
+{
+    return strcmp(_buffer, cstr) == 0;
+}
+
+unsigned int String::length() const
+{
+    return _length;
+}
+
+const char * String::c_str() const
+{
+    return _buffer;
+}
+
+char String::operator[](unsigned int index) const
+{
+    return index < _length ? _buffer[index] : '\0';
+}
+
+void String::toUpperCase()
+{
+    for(size_t i = 0; i < _length; i++) {
+        if(_buffer[i] >= 'a' && _buffer[i] <= 'z') {
+            _buffer[i] -= 'a' - 'A';
+        }
+    }
+}
+
+void String::append(const char * cstr, size_t length)
+{
+    char * grown = (char *)realloc(_buffer, _length + length + 1);
+    if(grown == NULL) {
+        return;
+    }
+    _buffer = grown;
+    memcpy(_buffer + _length, cstr, length);
+    _length += length;
+    _buffer[_length] = '\0';
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Print
+/////////////////////////////////////////////////////////////////////////////////////
+
+size_t Print::write(const uint8_t * buffer, size_t size)
+{
+    size_t n = 0;
+    while(size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char * str)
+{
+    return str ? write((const uint8_t *)str, strlen(str)) : 0;
+}
+
+size_t Print::print(const __FlashStringHelper * str)
+{
+    return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const String & str)
+{
+    return write((const uint8_t *)str.c_str(), str.length());
+}
+
+size_t Print::print(const char * str)
+{
+    return write(str);
+}
+
+size_t Print::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base)
+{
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base)
+{
+    return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base)
+{
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base)
+{
+    if(value < 0 && base == DEC) {
+        return print('-') + printNumber((unsigned long)(-value), base);
+    }
+    return printNumber((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+    return printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits)
+{
+    char text[48];
+    snprintf(text, sizeof(text), "%.*f", digits, value);
+    return write(text);
+}
+
+size_t Print::println()
+{
+    return write("\r\n");
+}
+
+size_t Print::printf(const char * format, ...)
+{
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if(length < 0) {
+        return 0;
+    }
+    return write((const uint8_t *)text, (size_t)length < sizeof(text) ? (size_t)length : sizeof(text) - 1);
+}
+
+size_t Print::printNumber(unsigned long value, int base)
+{
+    char digits[8 * sizeof(value) + 1];
+    char * p = &digits[sizeof(digits) - 1];
+    *p = '\0';
+    if(base < 2) {
+        base = DEC;
+    }
+    do {
+        unsigned long digit = value % base;
+        *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        value /= base;
+    } while(value);
+    return write(p);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// HostSerial
+/////////////////////////////////////////////////////////////////////////////////////
+
+size_t HostSerial::write(uint8_t c)
+{
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HostSerial::write(const uint8_t * buffer, size_t size)
+{
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HostSerial::flush()
+{
+    fflush(stdout);
+}
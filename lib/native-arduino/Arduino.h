@@ -0,0 +1,146 @@
+/**
+ * Arduino.h - minimal Arduino core stand-in for host (PlatformIO "native") builds.
+ *
+ * Provides just enough of the Arduino API for lib/mrfc522-ndef and the host benchmarks to compile and run
+ * on Linux: the integer typedefs, PROGMEM/F() no-ops, a small String, Print and a Serial that writes to
+ * stdout. millis()/micros()/delay() run on the virtual clock in HostClock.h.
+ *
+ * Like the ESP32 core it pulls in the FreeRTOS task API (a single task, see freertos/task.h) and offers
+ * GPIO interrupts; simulated devices drive input pins through HostGpio.h.
+ */
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "HostClock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define LOW  0x0
+#define HIGH 0x1
+
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+#define IRAM_ATTR
+#define digitalPinToInterrupt(p) (p)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void * arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+class String
+{
+    public:
+        String(const char * cstr = "");
+        String(const String & rhs);
+        explicit String(char c);
+        explicit String(unsigned int value, unsigned char base = DEC);
+        explicit String(int value, unsigned char base = DEC);
+        ~String();
+        String & operator=(const String & rhs);
+        String & operator+=(const String & rhs);
+        String & operator+=(const char * cstr);
+        String & operator+=(char c);
+        bool operator==(const String & rhs) const;
+        bool operator==(const char * cstr) const;
+        unsigned int length() const;
+        const char * c_str() const;
+        char operator[](unsigned int index) const;
+        void toUpperCase();
+    private:
+        void append(const char * cstr, size_t length);
+        char * _buffer;
+        size_t _length;
+};
+
+class Print
+{
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t * buffer, size_t size);
+        size_t write(const char * str);
+
+        size_t print(const __FlashStringHelper * str);
+        size_t print(const String & str);
+        size_t print(const char * str);
+        size_t print(char c);
+        size_t print(unsigned char value, int base = DEC);
+        size_t print(int value, int base = DEC);
+        size_t print(unsigned int value, int base = DEC);
+        size_t print(long value, int base = DEC);
+        size_t print(unsigned long value, int base = DEC);
+        size_t print(double value, int digits = 2);
+
+        size_t println();
+        template<typename T> size_t println(const T & value)
+        {
+            size_t n = print(value);
+            return n + println();
+        }
+        template<typename T> size_t println(const T & value, int format)
+        {
+            size_t n = print(value, format);
+            return n + println();
+        }
+
+        size_t printf(const char * format, ...) __attribute__((format(printf, 2, 3)));
+    private:
+        size_t printNumber(unsigned long value, int base);
+};
+
+// Serial port stand-in, everything goes to stdout.
+class HostSerial : public Print
+{
+    public:
+        void begin(unsigned long) {}
+        void flush();
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t * buffer, size_t size) override;
+        using Print::write;
+        operator bool() const
+        {
+            return true;
+        }
+};
+
+extern HostSerial Serial;
+
+#endif
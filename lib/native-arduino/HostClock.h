@@ -0,0 +1,49 @@
+#ifndef HostClock_h
+#define HostClock_h
+
+#include <stdint.h>
+
+/**
+ * Virtual time base of the host build.
+ *
+ * Nothing on the host really waits: millis()/micros() report a counter that only moves when a simulated
+ * peripheral (eg the Wire stand-in clocking out bytes) or delay() advances it. Benchmarks therefore report
+ * the time the same code would need on the target, independent of how fast the host is.
+ * The counter has nanosecond resolution so that sub-microsecond bus bit times add up correctly.
+ *
+ * Simulated peripherals that do something on their own (a command finishing, an IRQ line going low) schedule
+ * an event; it runs as soon as the clock passes its due time. A task that blocks (see freertos/task.h) sleeps
+ * to the next event, and that time is counted as idle so benchmarks can tell busy waiting from blocking.
+ */
+class HostClock
+{
+    public:
+        typedef void (*Event)(void * context);
+        static const uint8_t MAX_EVENTS = 8;
+
+        static uint64_t now();              // microseconds
+        static uint64_t nowNs();
+        static void advance(uint64_t us);
+        static void advanceNs(uint64_t ns);
+        static void reset();
+
+        static bool schedule(uint64_t atNs, Event event, void * context);
+        static void cancel(Event event, void * context);
+        static uint8_t pending();
+        static void sleep(uint64_t untilNs);
+        static uint64_t idleNs();
+    private:
+        static void runUntil(uint64_t ns);
+
+        struct Pending {
+            uint64_t atNs;
+            Event event;
+            void * context;
+        };
+        static uint64_t _nowNs;
+        static uint64_t _idleNs;
+        static Pending _events[MAX_EVENTS];
+        static uint8_t _eventCount;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "Arduino.h"
+#include "HostGpio.h"
+
+HostGpio::Pin HostGpio::_pins[HostGpio::PIN_COUNT];
+
+void HostGpio::mode(uint8_t pin, uint8_t mode)
+{
+    if(pin < PIN_COUNT && mode == INPUT_PULLUP) {
+        _pins[pin].level = HIGH;
+    }
+}
+
+void HostGpio::drive(uint8_t pin, uint8_t level)
+{
+    if(pin >= PIN_COUNT || _pins[pin].level == level) {
+        return;
+    }
+    _pins[pin].level = level;
+    Pin & p = _pins[pin];
+    if(p.handler && (p.interruptMode == CHANGE || (p.interruptMode == RISING && level == HIGH)
+                     || (p.interruptMode == FALLING && level == LOW))) {
+        p.handler(p.arg);
+    }
+}
+
+uint8_t HostGpio::level(uint8_t pin)
+{
+    return pin < PIN_COUNT ? _pins[pin].level : LOW;
+}
+
+void HostGpio::attach(uint8_t pin, void (*handler)(void *), void * arg, int mode)
+{
+    if(pin < PIN_COUNT) {
+        _pins[pin].handler = handler;
+        _pins[pin].arg = arg;
+        _pins[pin].interruptMode = mode;
+    }
+}
+
+void HostGpio::detach(uint8_t pin)
+{
+    if(pin < PIN_COUNT) {
+        _pins[pin].handler = NULL;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Arduino GPIO API
+/////////////////////////////////////////////////////////////////////////////////////
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    HostGpio::mode(pin, mode);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    HostGpio::drive(pin, value ? HIGH : LOW);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return HostGpio::level(pin);
+}
+
+// Plain handlers are called through a trampoline so HostGpio only deals with one signature.
+static void callHandler(void * arg)
+{
+    ((void (*)(void))arg)();
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode)
+{
+    HostGpio::attach(pin, callHandler, (void *)handler, mode);
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void * arg, int mode)
+{
+    HostGpio::attach(pin, handler, arg, mode);
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    HostGpio::detach(pin);
+}
@@ -0,0 +1,33 @@
+#ifndef HostGpio_h
+#define HostGpio_h
+
+#include <stdint.h>
+
+/**
+ * The pins of the host build.
+ *
+ * The sketch side uses the usual pinMode()/digitalRead()/attachInterrupt(); a simulated device connected
+ * to a pin calls drive() to change the level it sees. Edges run the attached handler right away, the way
+ * the GPIO ISR would on the target.
+ */
+class HostGpio
+{
+    public:
+        static const uint8_t PIN_COUNT = 64;
+
+        static void mode(uint8_t pin, uint8_t mode);
+        static void drive(uint8_t pin, uint8_t level);
+        static uint8_t level(uint8_t pin);
+        static void attach(uint8_t pin, void (*handler)(void *), void * arg, int mode);
+        static void detach(uint8_t pin);
+    private:
+        struct Pin {
+            uint8_t level;
+            int interruptMode;
+            void (*handler)(void *);
+            void * arg;
+        };
+        static Pin _pins[PIN_COUNT];
+};
+
+#endif
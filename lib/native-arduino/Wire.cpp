@@ -0,0 +1,178 @@
+#include "Wire.h"
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+    : _frequency(100000), _txAddress(0), _txLength(0), _rxLength(0), _rxIndex(0), _busClaimed(false),
+      _deviceCount(0)
+{
+    resetStats();
+}
+
+bool TwoWire::begin()
+{
+    return true;
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency)
+{
+    (void)sda;
+    (void)scl;
+    if(frequency) {
+        setClock(frequency);
+    }
+    return true;
+}
+
+void TwoWire::setClock(uint32_t frequency)
+{
+    _frequency = frequency;
+}
+
+uint32_t TwoWire::getClock()
+{
+    return _frequency;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _txAddress = address;
+    _txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if(_txLength >= BUFFER_LENGTH) {
+        return 0;
+    }
+    _txBuffer[_txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t * data, size_t length)
+{
+    size_t written = 0;
+    while(written < length && write(data[written])) {
+        written++;
+    }
+    return written;
+}
+
+/**
+ * Sends the queued bytes. Returns 0 on success, 2 if no device acknowledged the address (like Arduino).
+ */
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    HostI2CDevice * slave = device(_txAddress);
+    condition(true);
+    clockBytes(1);
+    if(slave == NULL) {
+        _stats.nacks++;
+        condition(false);
+        return 2;
+    }
+    clockBytes(_txLength);
+    slave->i2cWrite(_txBuffer, _txLength);
+    _txLength = 0;
+    if(sendStop) {
+        condition(false);
+    }
+    return 0;
+}
+
+/**
+ * Reads quantity bytes into the receive buffer. Returns the number of bytes read.
+ */
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop)
+{
+    HostI2CDevice * slave = device(address);
+    _rxLength = 0;
+    _rxIndex = 0;
+    condition(true);
+    clockBytes(1);
+    if(slave == NULL) {
+        _stats.nacks++;
+        condition(false);
+        return 0;
+    }
+    if(quantity > BUFFER_LENGTH) {
+        quantity = BUFFER_LENGTH;
+    }
+    clockBytes(quantity);
+    slave->i2cRead(_rxBuffer, quantity);
+    _rxLength = quantity;
+    if(sendStop) {
+        condition(false);
+    }
+    return quantity;
+}
+
+int TwoWire::available()
+{
+    return _rxLength - _rxIndex;
+}
+
+int TwoWire::read()
+{
+    if(_rxIndex >= _rxLength) {
+        return -1;
+    }
+    return _rxBuffer[_rxIndex++];
+}
+
+void TwoWire::attach(uint8_t address, HostI2CDevice * device)
+{
+    for(uint8_t i = 0; i < _deviceCount; i++) {
+        if(_addresses[i] == address) {
+            _devices[i] = device;
+            return;
+        }
+    }
+    if(_deviceCount < MAX_DEVICES) {
+        _addresses[_deviceCount] = address;
+        _devices[_deviceCount] = device;
+        _deviceCount++;
+    }
+}
+
+const HostI2CStats & TwoWire::stats() const
+{
+    return _stats;
+}
+
+void TwoWire::resetStats()
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+HostI2CDevice * TwoWire::device(uint8_t address)
+{
+    for(uint8_t i = 0; i < _deviceCount; i++) {
+        if(_addresses[i] == address) {
+            return _devices[i];
+        }
+    }
+    return NULL;
+}
+
+// A START (or repeated START if the bus is still claimed) or a STOP condition.
+// Each takes about one bit time on the wire.
+void TwoWire::condition(bool isStart)
+{
+    if(isStart) {
+        _stats.starts++;
+        _busClaimed = true;
+    }
+    else {
+        _stats.transactions++;
+        _busClaimed = false;
+    }
+    HostClock::advanceNs(1000000000ULL / _frequency);
+}
+
+// Eight data bits plus ACK per byte.
+void TwoWire::clockBytes(size_t count)
+{
+    _stats.bytes += count;
+    HostClock::advanceNs(count * 9 * 1000000000ULL / _frequency);
+}
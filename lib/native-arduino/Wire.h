@@ -0,0 +1,87 @@
+/**
+ * Wire.h - I2C master stand-in for host (PlatformIO "native") builds.
+ *
+ * Implements the subset of the Arduino TwoWire API the MFRC522 driver uses, with proper repeated START
+ * semantics: endTransmission(false) / requestFrom(..., false) leave the bus claimed and the next
+ * beginTransmission()/requestFrom() issues a repeated START instead of STOP + START.
+ *
+ * Every condition and byte is clocked on the virtual clock (HostClock.h) at the configured bus frequency,
+ * and counted, so the cost of a driver operation can be measured without hardware:
+ *
+ *      Wire.resetStats();
+ *      mfrc522.MIFARE_Read(4, buffer, &size);
+ *      Serial.println(Wire.stats().transactions);
+ *
+ * Slaves are HostI2CDevice implementations attached to an address.
+ */
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include "Arduino.h"
+
+/**
+ * An I2C slave on the host bus.
+ */
+class HostI2CDevice
+{
+    public:
+        virtual ~HostI2CDevice() {}
+        // A write phase: the bytes the master sent after the address byte, up to the next repeated START or STOP.
+        virtual void i2cWrite(const uint8_t * data, size_t length) = 0;
+        // A read phase: provide the bytes the master clocks in.
+        virtual void i2cRead(uint8_t * data, size_t length) = 0;
+};
+
+// Bus activity counters.
+struct HostI2CStats {
+    uint32_t transactions;      // START ... STOP sequences, ie bus arbitrations
+    uint32_t starts;            // START and repeated START conditions
+    uint32_t bytes;             // bytes on the wire, address bytes included
+    uint32_t nacks;             // transfers addressed to a device that is not attached
+};
+
+class TwoWire
+{
+    public:
+        static const size_t BUFFER_LENGTH = 128;
+        static const uint8_t MAX_DEVICES = 4;
+
+        TwoWire();
+        bool begin();
+        bool begin(int sda, int scl, uint32_t frequency = 0);
+        void setClock(uint32_t frequency);
+        uint32_t getClock();
+
+        void beginTransmission(uint8_t address);
+        size_t write(uint8_t data);
+        size_t write(const uint8_t * data, size_t length);
+        uint8_t endTransmission(bool sendStop = true);
+        uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+        int available();
+        int read();
+
+        void attach(uint8_t address, HostI2CDevice * device);
+        const HostI2CStats & stats() const;
+        void resetStats();
+    private:
+        HostI2CDevice * device(uint8_t address);
+        void condition(bool isStart);
+        void clockBytes(size_t count);
+
+        uint32_t _frequency;
+        uint8_t _txAddress;
+        uint8_t _txBuffer[BUFFER_LENGTH];
+        size_t _txLength;
+        uint8_t _rxBuffer[BUFFER_LENGTH];
+        size_t _rxLength;
+        size_t _rxIndex;
+        bool _busClaimed;           // a transfer ended without STOP, next START is a repeated START
+        uint8_t _addresses[MAX_DEVICES];
+        HostI2CDevice * _devices[MAX_DEVICES];
+        uint8_t _deviceCount;
+        HostI2CStats _stats;
+};
+
+extern TwoWire Wire;
+
+#endif
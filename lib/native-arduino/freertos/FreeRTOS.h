@@ -0,0 +1,28 @@
+/**
+ * FreeRTOS.h - the FreeRTOS types and macros the host build needs.
+ *
+ * There is one task and no scheduler: a blocking call sleeps the virtual clock until an event (usually a
+ * simulated interrupt) wakes it, see task.h.
+ */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE  ((BaseType_t)1)
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define configTICK_RATE_HZ 1000
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+#endif
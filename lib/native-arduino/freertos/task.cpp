@@ -0,0 +1,49 @@
+#include "task.h"
+#include "../HostClock.h"
+
+struct HostTask {
+    uint32_t notifications;
+};
+
+static HostTask mainTask = { 0 };
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return &mainTask;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    HostTask * task = xTaskGetCurrentTaskHandle();
+    if(xTicksToWait == portMAX_DELAY) {
+        // nothing else can notify a single task, so give up once nothing is scheduled any more
+        while(task->notifications == 0 && HostClock::pending()) {
+            HostClock::sleep(UINT64_MAX);
+        }
+    }
+    else {
+        uint64_t deadline = HostClock::nowNs() + (uint64_t)xTicksToWait * portTICK_PERIOD_MS * 1000000ULL;
+        while(task->notifications == 0 && HostClock::nowNs() < deadline) {
+            HostClock::sleep(deadline);
+        }
+    }
+    uint32_t value = task->notifications;
+    if(value) {
+        task->notifications = xClearCountOnExit ? 0 : value - 1;
+    }
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    xTaskToNotify->notifications++;
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t * pxHigherPriorityTaskWoken)
+{
+    xTaskToNotify->notifications++;
+    if(pxHigherPriorityTaskWoken) {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+}
@@ -0,0 +1,20 @@
+/**
+ * task.h - FreeRTOS direct-to-task notifications for the host build.
+ *
+ * ulTaskNotifyTake() on the single host task sleeps (HostClock::sleep()) until a notification arrives
+ * from a simulated ISR or the timeout expires.
+ */
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+struct HostTask;
+typedef HostTask * TaskHandle_t;
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t * pxHigherPriorityTaskWoken);
+
+#endif
@@ -0,0 +1,68 @@
+#include "bench.h"
+
+static HostI2CStats startStats;
+static uint64_t startTime;
+static uint64_t startIdle;
+
+void bench_begin()
+{
+    startStats = Wire.stats();
+    startTime = HostClock::now();
+    startIdle = HostClock::idleNs();
+}
+
+BenchCost bench_end()
+{
+    const HostI2CStats & stats = Wire.stats();
+    BenchCost cost;
+    cost.transactions = stats.transactions - startStats.transactions;
+    cost.starts = stats.starts - startStats.starts;
+    cost.bytes = stats.bytes - startStats.bytes;
+    cost.us = HostClock::now() - startTime;
+    cost.busyUs = cost.us - (HostClock::idleNs() - startIdle) / 1000;
+    return cost;
+}
+
+void bench_report(const char * what, const BenchCost & cost)
+{
+    Serial.printf("  %-34s %5u transactions %5u starts %6u bytes %8llu us %8llu us busy\n", what, cost.transactions,
+                  cost.starts, cost.bytes, (unsigned long long)cost.us, (unsigned long long)cost.busyUs);
+}
+
+// Wakes up and selects the card in the field, also one that is halted.
+bool bench_select(MFRC522 & mfrc522)
+{
+    byte atqa[2];
+    byte size = sizeof(atqa);
+    return mfrc522.PICC_WakeupA(atqa, &size) == MFRC522::STATUS_OK && mfrc522.PICC_ReadCardSerial();
+}
+
+int main()
+{
+    Wire.begin();
+    Wire.setClock(BENCH_I2C_CLOCK);
+#ifdef MFRC522_TRANSPORT_SIM
+    Serial.println(F("MFRC522 host benchmarks, simulator transport"));
+#else
+    Serial.printf("MFRC522 host benchmarks, I2C at %u Hz\n", BENCH_I2C_CLOCK);
+#endif
+
+    bool ok = true;
+    ok &= bench_transactions();
+    ok &= bench_irq();
+    ok &= bench_crc();
+    ok &= bench_nfc();
+    ok &= bench_inventory();
+    ok &= bench_monitor();
+    ok &= bench_ultralight();
+    ok &= bench_ndef();
+    ok &= bench_stream();
+    ok &= bench_keys();
+    ok &= bench_dump();
+
+    if(!ok) {
+        Serial.println(F("\nSome checks failed"));
+    }
+    Serial.flush();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+// Host benchmarks for the MFRC522 driver and the NDEF stack.
+//
+// Built by the bench-native environment (pio run -e bench-native && .pio/build/bench-native/program).
+// Time is virtual (see lib/native-arduino/HostClock.h): the numbers are what the same code costs on the
+// target bus, not how fast the host is. Results are checked as well: the program exits with 1 if one is wrong.
+#ifndef bench_h
+#define bench_h
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "MFRC522_I2C.h"
+
+#define BENCH_PCD_ADDRESS 0x28
+#define BENCH_I2C_CLOCK 400000
+#define BENCH_PCD_IRQ_PIN 4
+
+// The MFRC522_Transport for a simulated PCD: its I2C address on the host Wire, or the device itself when
+// built with the simulator transport (bench-native-sim), which has no bus cost.
+#ifdef MFRC522_TRANSPORT_SIM
+    #define BENCH_PCD_BUS(device) (&(device))
+#else
+    #define BENCH_PCD_BUS(device) BENCH_PCD_ADDRESS
+#endif
+
+// Bus cost of one operation.
+struct BenchCost {
+    uint32_t transactions;
+    uint32_t starts;
+    uint32_t bytes;
+    uint64_t us;
+    uint64_t busyUs;        // us minus the time the task was blocked
+};
+
+void bench_begin();
+BenchCost bench_end();
+void bench_report(const char * what, const BenchCost & cost);
+bool bench_select(MFRC522 & mfrc522);
+
+// Each returns false if one of its checks failed
+bool bench_transactions();
+bool bench_irq();
+bool bench_crc();
+bool bench_nfc();
+bool bench_inventory();
+bool bench_monitor();
+bool bench_ultralight();
+bool bench_ndef();
+bool bench_stream();
+bool bench_keys();
+bool bench_dump();
+
+#endif
@@ -0,0 +1,116 @@
+// CRC_A: a CalcCRC command cycle per frame vs the chip appending and checking it within the Transceive vs the MCU
+// computing it from a table.
+#include <chrono>
+#include "bench.h"
+#include "MFRC522_CRC.h"
+#include "MFRC522Sim.h"
+#include "SimMifareUltralight.h"
+
+static const byte uid[] = { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+
+static bool run(MFRC522 & mfrc522, MFRC522::PCD_CrcMode mode, const char * name)
+{
+    char label[40];
+    byte buffer[18];
+    byte size = sizeof(buffer);
+
+    mfrc522.PCD_SetCrcMode(mode);
+
+    snprintf(label, sizeof(label), "Select (%s)", name);
+    bench_begin();
+    bool selected = bench_select(mfrc522);
+    bench_report(label, bench_end());
+    if(!selected) {
+        Serial.println(F("  no card selected"));
+    }
+
+    snprintf(label, sizeof(label), "MIFARE_Read (%s)", name);
+    bench_begin();
+    MFRC522::StatusCode status = mfrc522.MIFARE_Read(4, buffer, &size);
+    bench_report(label, bench_end());
+    if(status != MFRC522::STATUS_OK) {
+        Serial.print(F("  MIFARE_Read failed: "));
+        Serial.println(mfrc522.GetStatusCodeName(status));
+    }
+
+    snprintf(label, sizeof(label), "MIFARE_Ultralight_Write (%s)", name);
+    bench_begin();
+    MFRC522::StatusCode written = mfrc522.MIFARE_Ultralight_Write(4, buffer, 4);
+    bench_report(label, bench_end());
+    if(written != MFRC522::STATUS_OK) {
+        Serial.print(F("  MIFARE_Ultralight_Write failed: "));
+        Serial.println(mfrc522.GetStatusCodeName(written));
+    }
+
+    snprintf(label, sizeof(label), "PICC_HaltA (%s)", name);
+    bench_begin();
+    mfrc522.PICC_HaltA();
+    bench_report(label, bench_end());
+    return selected && status == MFRC522::STATUS_OK && written == MFRC522::STATUS_OK;
+}
+
+// The bit by bit CRC_A, for comparison with the table
+static uint16_t crcBitwise(const byte * data, size_t length)
+{
+    uint16_t crc = MFRC522_CrcA::PRESET;
+    for(size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for(byte bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+// The only cost of PCD_CRC_SOFTWARE is MCU time, so this one is measured on the host CPU (not virtual time).
+template <typename Crc> static void cpu(const char * what, Crc crc)
+{
+    const uint32_t frames = 1000000;
+    byte frame[18];
+    for(byte i = 0; i < sizeof(frame); i++) {
+        frame[i] = i * 37;
+    }
+    volatile uint16_t sink = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < frames; i++) {
+        frame[0] = (byte)i;
+        sink = sink ^ crc(frame, sizeof(frame));
+    }
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+    Serial.printf("  %-34s %8.1f ns per 18 byte frame (host CPU)\n", what, (double)elapsed.count() / frames);
+}
+
+bool bench_crc()
+{
+    MFRC522Sim pcd;
+    SimMifareUltralight tag(SimMifareUltralight::NTAG213, uid);
+    pcd.addPicc(&tag);
+    pcd.connectIrq(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+    MFRC522 mfrc522(BENCH_PCD_BUS(pcd), BENCH_PCD_IRQ_PIN);
+    mfrc522.PCD_Init();
+
+    Serial.println(F("\nCRC_A per frame"));
+
+    bool ok = run(mfrc522, MFRC522::PCD_CRC_CALC, "CalcCRC");
+    ok &= run(mfrc522, MFRC522::PCD_CRC_FRAMED, "framed");
+    ok &= run(mfrc522, MFRC522::PCD_CRC_SOFTWARE, "software");
+    detachInterrupt(BENCH_PCD_IRQ_PIN);
+
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+
+    cpu("CRC_A table", [](const byte * data, size_t length) {
+        return MFRC522_CrcA::compute(data, length);
+    });
+    cpu("CRC_A bit by bit", crcBitwise);
+
+    byte frame[18];
+    for(byte i = 0; i < sizeof(frame); i++) {
+        frame[i] = i * 37;
+    }
+    if(MFRC522_CrcA::compute(frame, sizeof(frame)) != crcBitwise(frame, sizeof(frame))) {
+        Serial.println(F("  CRC_A table and bit by bit differ"));
+        ok = false;
+    }
+    return ok;
+}
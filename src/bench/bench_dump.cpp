@@ -0,0 +1,143 @@
+// Full card dumps through the sinks of MFRC522_Dump.h: the .mfd image of a MIFARE Classic 1K and 4K, the text table
+// PICC_DumpToSerial() prints, and the .bin image of Ultralight and NTAG tags. The output goes to a Print that
+// counts its writes: the table used to be one Serial.print() per field, the sinks write a line or a block at once.
+#include "bench.h"
+#include "MFRC522_Dump.h"
+#include "MFRC522Sim.h"
+#include "SimMifareClassic.h"
+#include "SimMifareUltralight.h"
+
+static const byte classicUid[] = { 0x44, 0x55, 0x4D, 0x50 };
+static const byte ultralightUid[] = { 0x04, 0x44, 0x55, 0x4D, 0x50, 0x30, 0x31 };
+
+// Keeps what it gets in memory
+class ImagePrint : public Print
+{
+    public:
+        ImagePrint() : writes(0), length(0) {}
+        size_t write(uint8_t c)
+        {
+            return write(&c, 1);
+        }
+        size_t write(const uint8_t * buffer, size_t size)
+        {
+            writes++;
+            size_t n = size < sizeof(data) - length ? size : sizeof(data) - length;
+            memcpy(&data[length], buffer, n);
+            length += n;
+            return n;
+        }
+
+        uint32_t writes;
+        size_t length;
+        byte data[32768];
+};
+
+static void fill(byte * data, size_t length)
+{
+    for(size_t i = 0; i < length; i++) {
+        data[i] = i * 7 + (i >> 4);
+    }
+}
+
+// Data in all blocks but the manufacturer block and the trailers
+static void fill(SimMifareClassic & card)
+{
+    for(uint16_t block = 1; block < card.blockCount(); block++) {
+        if(block != SimMifareClassic::trailerOf(SimMifareClassic::sectorOf(block))) {
+            fill(card.block(block), 16);
+        }
+    }
+}
+
+// The image matches the card, with a zero block for each block of the sectors key A does not open
+static bool matches(const ImagePrint & out, SimMifareClassic & card, uint16_t lockedSector)
+{
+    static const byte zeros[16] = {};
+    bool ok = out.length == card.blockCount() * 16u;
+    for(uint16_t block = 0; ok && block < card.blockCount(); block++) {
+        const byte * expected = SimMifareClassic::sectorOf(block) == lockedSector ? zeros : card.block(block);
+        ok = memcmp(&out.data[block * 16], expected, 16) == 0;
+    }
+    return ok;
+}
+
+static bool classic(const char * what, MFRC522Sim & pcd, MFRC522 & mfrc522, SimMifareClassic & card,
+                    uint16_t lockedSector = 0xFFFF)
+{
+    MFRC522::MIFARE_Key key = {{0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
+    ImagePrint out;
+    MFRC522_DumpImage image(out);
+    pcd.addPicc(&card);
+    bool ok = bench_select(mfrc522);
+    byte piccType = mfrc522.PICC_GetType(mfrc522.uid.sak);
+    bench_begin();
+    MFRC522::StatusCode status = mfrc522.PICC_DumpMifareClassic(mfrc522.uid, piccType, key, image);
+    bench_report(what, bench_end());
+    ok = ok && (lockedSector == 0xFFFF ? status == MFRC522::STATUS_OK && image.unread == 0 : image.unread > 0);
+    ok = ok && matches(out, card, lockedSector);
+    Serial.printf("    %u bytes in %u writes, %u blocks unread%s\n", (unsigned)out.length, out.writes, image.unread,
+                  ok ? "" : ", failed");
+    bool dumped = ok;
+
+    // the text table of the same card
+    ImagePrint text;
+    MFRC522_DumpPrinter printer(text);
+    ok = bench_select(mfrc522)
+         && mfrc522.PICC_DumpMifareClassic(mfrc522.uid, piccType, key, printer) == status;
+    Serial.printf("    text: %u bytes in %u writes%s\n", (unsigned)text.length, text.writes, ok ? "" : ", failed");
+    pcd.removePicc(&card);
+    return dumped && ok;
+}
+
+static bool ultralight(const char * what, MFRC522Sim & pcd, MFRC522 & mfrc522, SimMifareUltralight & tag)
+{
+    ImagePrint out;
+    MFRC522_DumpImage image(out);
+    fill(tag.page(4), (tag.userEnd() - 4) * 4);
+    pcd.addPicc(&tag);
+    bool ok = bench_select(mfrc522);
+    uint32_t frames = pcd.stats().framesSent;
+    bench_begin();
+    ok = ok && mfrc522.PICC_DumpMifareUltralight(mfrc522.uid, image) == MFRC522::STATUS_OK;
+    bench_report(what, bench_end());
+    frames = pcd.stats().framesSent - frames;
+    ok = ok && out.length == tag.pageCount() * 4u && memcmp(out.data, tag.page(0), out.length) == 0;
+    Serial.printf("    %u pages, %u frames%s\n", tag.pageCount(), frames, ok ? "" : ", failed");
+    mfrc522.PICC_HaltA();
+    pcd.removePicc(&tag);
+    return ok;
+}
+
+bool bench_dump()
+{
+    MFRC522Sim pcd;
+    pcd.connectIrq(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+    MFRC522 mfrc522(BENCH_PCD_BUS(pcd), BENCH_PCD_IRQ_PIN);
+    mfrc522.PCD_Init();
+    mfrc522.PCD_SetCrcMode(MFRC522::PCD_CRC_FRAMED);
+
+    Serial.println(F("\nFull card dumps"));
+
+    SimMifareClassic classic1k(SimMifareClassic::CLASSIC_1K, classicUid);
+    fill(classic1k);
+    bool ok = classic("1K .mfd image", pcd, mfrc522, classic1k);
+
+    SimMifareClassic classic4k(SimMifareClassic::CLASSIC_4K, classicUid);
+    fill(classic4k);
+    ok &= classic("4K .mfd image", pcd, mfrc522, classic4k);
+
+    // sector 33 has another key A: its 16 blocks are zeros, the sectors after it are still read
+    memset(classic4k.block(SimMifareClassic::trailerOf(33)), 0x33, MFRC522::MF_KEY_SIZE);
+    ok &= classic("4K .mfd image, a sector locked", pcd, mfrc522, classic4k, 33);
+
+    SimMifareUltralight original(SimMifareUltralight::ULTRALIGHT, ultralightUid);
+    ok &= ultralight("Ultralight .bin image (READ)", pcd, mfrc522, original);
+    SimMifareUltralight ntag216(SimMifareUltralight::NTAG216, ultralightUid);
+    ok &= ultralight("NTAG216 .bin image (FAST_READ)", pcd, mfrc522, ntag216);
+
+    detachInterrupt(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+    return ok;
+}
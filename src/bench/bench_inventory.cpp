@@ -0,0 +1,97 @@
+// Inventory of several cards in the field at once: anticollision, select and halt for each.
+#include "bench.h"
+#include "NfcAdapter.h"
+#include "MFRC522Sim.h"
+#include "SimMifareClassic.h"
+#include "SimMifareUltralight.h"
+
+// NTAGs share the manufacturer byte (and the cascade tag), so their first cascade levels collide late.
+static const byte ntagUids[4][7] = {
+    { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 },
+    { 0x04, 0x11, 0x22, 0xB3, 0x44, 0x55, 0x67 },
+    { 0x04, 0x91, 0x02, 0x33, 0x10, 0x20, 0x30 },
+    { 0x04, 0x11, 0x23, 0x33, 0x10, 0x20, 0x31 }
+};
+static const byte classicUids[4][4] = {
+    { 0xDE, 0xAD, 0xBE, 0xEF },
+    { 0xDE, 0xAD, 0xBE, 0xE7 },
+    { 0x5E, 0xAD, 0xBE, 0xEF },
+    { 0x12, 0x34, 0x56, 0x78 }
+};
+
+static bool found(NfcAdapter & nfc, const SimPicc & card)
+{
+    for(byte i = 0; i < nfc.inventoryCount(); i++) {
+        const MFRC522::Uid & uid = nfc.inventoryTag(i).uid;
+        if(uid.size == card.uidSize() && memcmp(uid.uidByte, card.uid(), uid.size) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool run(byte cards)
+{
+    SimMifareUltralight * ntags[4];
+    SimMifareClassic * classics[4];
+    SimPicc * field[8];
+    for(byte i = 0; i < 4; i++) {
+        ntags[i] = new SimMifareUltralight(SimMifareUltralight::NTAG213, ntagUids[i]);
+        classics[i] = new SimMifareClassic(SimMifareClassic::CLASSIC_1K, classicUids[i]);
+        field[2 * i] = ntags[i];
+        field[2 * i + 1] = classics[i];
+    }
+
+    MFRC522Sim pcd;
+    for(byte i = 0; i < cards; i++) {
+        pcd.addPicc(field[i]);
+    }
+    pcd.connectIrq(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+    MFRC522 mfrc522(BENCH_PCD_BUS(pcd), BENCH_PCD_IRQ_PIN);
+    mfrc522.PCD_Init();
+    mfrc522.PCD_SetCrcMode(MFRC522::PCD_CRC_FRAMED);
+    NfcAdapter nfc(&mfrc522);
+
+    char label[40];
+    snprintf(label, sizeof(label), "inventory of %u", cards);
+    pcd.resetStats();
+    bench_begin();
+    byte count = nfc.inventory();
+    bench_report(label, bench_end());
+    bool ok = count == cards;
+    for(byte i = 0; i < cards; i++) {
+        ok = ok && found(nfc, *field[i]);
+    }
+    if(!ok) {
+        Serial.printf("  found %u of %u cards\n", count, cards);
+    }
+
+    // Each one can be picked again, the others stay halted
+    for(byte i = 0; i < count; i++) {
+        if(!nfc.selectTag(i) || mfrc522.PICC_HaltA() != MFRC522::STATUS_OK) {
+            Serial.printf("  selectTag(%u) failed\n", i);
+            ok = false;
+        }
+    }
+
+    detachInterrupt(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+    for(byte i = 0; i < 4; i++) {
+        delete ntags[i];
+        delete classics[i];
+    }
+    return ok;
+}
+
+bool bench_inventory()
+{
+    Serial.println(F("\nInventory, NTAG213 and MIFARE Classic 1K cards in turn"));
+
+    const byte counts[] = { 1, 2, 3, 4, 6, 8 };
+    bool ok = true;
+    for(byte i = 0; i < sizeof(counts); i++) {
+        ok &= run(counts[i]);
+    }
+    return ok;
+}
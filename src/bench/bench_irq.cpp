@@ -0,0 +1,89 @@
+// Waiting for command completion: polling ComIrqReg/DivIrqReg vs blocking on the IRQ pin.
+#include "bench.h"
+#include "MFRC522Sim.h"
+#include "SimMifareUltralight.h"
+
+static const byte uid[] = { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+
+// Takes 50 ms to answer READ, longer than the wait for a command used to be whatever the timeout
+class SlowTag : public SimMifareUltralight
+{
+    public:
+        SlowTag() : SimMifareUltralight(NTAG213, ::uid), slow(false) {}
+        bool slow;
+    protected:
+        bool transceive(const byte * data, uint16_t length, SimFrame & response, uint32_t & delayNs) override
+        {
+            bool answered = SimMifareUltralight::transceive(data, length, response, delayNs);
+            if(slow && data[0] == MFRC522::PICC_CMD_MF_READ) {
+                delayNs = 50000000;
+            }
+            return answered;
+        }
+};
+
+static bool run(MFRC522 & mfrc522, SlowTag & tag, const char * mode)
+{
+    char label[40];
+    byte buffer[18];
+    byte size = sizeof(buffer);
+
+    mfrc522.PCD_Init();
+    bool ok = bench_select(mfrc522);
+
+    snprintf(label, sizeof(label), "MIFARE_Read (%s)", mode);
+    bench_begin();
+    ok = ok && mfrc522.MIFARE_Read(4, buffer, &size) == MFRC522::STATUS_OK;
+    bench_report(label, bench_end());
+
+    byte crc[2];
+    snprintf(label, sizeof(label), "PCD_CalculateCRC (%s)", mode);
+    bench_begin();
+    ok = ok && mfrc522.PCD_CalculateCRC(buffer, 16, crc) == MFRC522::STATUS_OK;
+    bench_report(label, bench_end());
+
+    // a timeout longer than the answer takes, and one shorter
+    tag.slow = true;
+    mfrc522.PCD_SetTimeout(100000);
+    size = sizeof(buffer);
+    snprintf(label, sizeof(label), "MIFARE_Read, 50 ms answer (%s)", mode);
+    bench_begin();
+    ok = ok && mfrc522.MIFARE_Read(4, buffer, &size) == MFRC522::STATUS_OK;
+    bench_report(label, bench_end());
+    mfrc522.PCD_SetTimeout(25000);
+    size = sizeof(buffer);
+    ok = ok && mfrc522.MIFARE_Read(4, buffer, &size) == MFRC522::STATUS_TIMEOUT;
+    tag.slow = false;
+    mfrc522.PICC_HaltA();
+    ok = ok && bench_select(mfrc522);
+
+    snprintf(label, sizeof(label), "PICC_HaltA (%s)", mode);
+    bench_begin();
+    mfrc522.PICC_HaltA();
+    bench_report(label, bench_end());
+    if(!ok) {
+        Serial.printf("  %s failed\n", mode);
+    }
+    return ok;
+}
+
+bool bench_irq()
+{
+    MFRC522Sim pcd;
+    SlowTag tag;
+    pcd.addPicc(&tag);
+    pcd.connectIrq(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+
+    Serial.println(F("\nCommand completion"));
+
+    MFRC522 polled(BENCH_PCD_BUS(pcd));
+    bool ok = run(polled, tag, "poll");
+
+    MFRC522 interrupt(BENCH_PCD_BUS(pcd), BENCH_PCD_IRQ_PIN);
+    ok &= run(interrupt, tag, "irq");
+    detachInterrupt(BENCH_PCD_IRQ_PIN);
+
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+    return ok;
+}
@@ -0,0 +1,226 @@
+// Key recovery on a MIFARE Classic 1K whose sectors use keys from a dictionary: the old example's loop, one key per
+// card detection on block 0, vs MifareKeySearch on every sector with key A and B, reselecting after each failure.
+// Then how fast MifareDiversifiedKeys derives a sector key (AES-128 CMAC, AN10922).
+#include <chrono>
+#include "bench.h"
+#include "MifareKeySearch.h"
+#include "MifareKeyProvider.h"
+#include "MFRC522Sim.h"
+#include "SimMifareClassic.h"
+
+static const byte uid[] = { 0x4B, 0x45, 0x59, 0x53 };
+
+// The dictionary of test_default_keys
+static const byte knownKeys[][MFRC522::MF_KEY_SIZE] PROGMEM = {
+    {0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5},
+    {0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5},
+    {0x4d, 0x3a, 0x99, 0xc3, 0x51, 0xdd},
+    {0x1a, 0x98, 0x2c, 0x7e, 0x45, 0x9a},
+    {0xd3, 0xf7, 0xd3, 0xf7, 0xd3, 0xf7},
+    {0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0xa0, 0xb0, 0xc0, 0xd0, 0xe0, 0xf0},
+    {0xa1, 0xb1, 0xc1, 0xd1, 0xe1, 0xf1},
+    {0x71, 0x4c, 0x5c, 0x88, 0x6e, 0x97},
+    {0x58, 0x7e, 0xe5, 0xf9, 0x35, 0x0f},
+    {0xa0, 0x47, 0x8c, 0xc3, 0x90, 0x91},
+    {0x53, 0x3c, 0xb6, 0xc7, 0x23, 0xf6},
+    {0x8f, 0xd0, 0xa4, 0xf2, 0x56, 0xe9},
+    {0xff, 0xff, 0xff, 0xff, 0xff, 0xff}
+};
+static const byte KNOWN_KEYS = sizeof(knownKeys) / sizeof(knownKeys[0]);
+
+// A dictionary too large for RAM, made up on the fly: the known keys after 1000 that fit nothing
+class GeneratedKeys : public MifareKeySource
+{
+    public:
+        GeneratedKeys() : _index(0), _known(knownKeys, KNOWN_KEYS) {}
+        bool next(MFRC522::MIFARE_Key & key)
+        {
+            if(_index >= 1000) {
+                return _known.next(key);
+            }
+            for(byte i = 0; i < MFRC522::MF_KEY_SIZE; i++) {
+                key.keyByte[i] = 0x10 + i + (_index >> (i & 1 ? 8 : 0));
+            }
+            _index++;
+            return true;
+        }
+    private:
+        uint32_t _index;
+        MifareKeyTable _known;
+};
+
+// Sector s gets key A from the dictionary entry 3 * s - 1, key B from the entry after: sector 0 has the last two
+static const byte * keyA(byte sector)
+{
+    return knownKeys[(3 * sector + KNOWN_KEYS - 1) % KNOWN_KEYS];
+}
+
+static const byte * keyB(byte sector)
+{
+    return knownKeys[(3 * sector) % KNOWN_KEYS];
+}
+
+static void prepare(SimMifareClassic & card)
+{
+    for(byte sector = 0; sector < 16; sector++) {
+        byte * trailer = card.block(SimMifareClassic::trailerOf(sector));
+        memcpy(trailer, keyA(sector), MFRC522::MF_KEY_SIZE);
+        memcpy(&trailer[10], keyB(sector), MFRC522::MF_KEY_SIZE);
+    }
+}
+
+// test_default_keys before: for each key detect the card, authenticate block 0 with key A, read it, halt
+static bool perDetection(MFRC522 & mfrc522)
+{
+    byte buffer[18];
+    byte keys = 0;
+    bool found = false;
+    bench_begin();
+    while(!found && keys < KNOWN_KEYS) {
+        MFRC522::MIFARE_Key key;
+        memcpy(key.keyByte, knownKeys[keys++], MFRC522::MF_KEY_SIZE);
+        if(!bench_select(mfrc522)) {
+            break;
+        }
+        byte size = sizeof(buffer);
+        found = mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 0, key, mfrc522.uid) == MFRC522::STATUS_OK
+                && mfrc522.MIFARE_Read(0, buffer, &size) == MFRC522::STATUS_OK;
+        mfrc522.PICC_HaltA();
+        mfrc522.PCD_StopCrypto1();
+    }
+    BenchCost cost = bench_end();
+    bench_report("sector 0 key A, detect per key", cost);
+    Serial.printf("    %u keys tried, %.0f keys/s, plus 1 s delay() per failure in the example%s\n", keys,
+                  keys * 1000000.0 / cost.us, found ? "" : ", failed");
+    return found;
+}
+
+static bool search(const char * what, MFRC522 & mfrc522, MifareKeySource & keys)
+{
+    MifareKeySearch search(&mfrc522);
+    bool ok = bench_select(mfrc522);
+    mfrc522.PCD_SetTimeout(10000);      // not the default, the search has to give back what it found
+    bench_begin();
+    ok = ok && search.search(keys) && search.complete();
+    bench_report(what, bench_end());
+    ok = ok && mfrc522.PCD_GetTimeout() == 10000;
+    mfrc522.PCD_SetTimeout(25000);
+    for(byte sector = 0; ok && sector < search.sectors(); sector++) {
+        const MifareSectorKeys & found = search.sector(sector);
+        ok = memcmp(found.keyA.keyByte, keyA(sector), MFRC522::MF_KEY_SIZE) == 0
+             && memcmp(found.keyB.keyByte, keyB(sector), MFRC522::MF_KEY_SIZE) == 0;
+    }
+    Serial.printf("    %u keys tried, %u keys/s%s\n", search.tried, search.keysPerSecond(), ok ? "" : ", failed");
+    mfrc522.PICC_HaltA();
+    return ok;
+}
+
+// FIPS-197 appendix C.1, and the four examples of RFC 4493: no block, one whole block, a padded last block, four
+static bool knownAnswers()
+{
+    static const byte fipsKey[] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+    };
+    static const byte fipsPlain[] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+    };
+    static const byte fipsCipher[] = {
+        0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A
+    };
+    static const byte rfcKey[] = {
+        0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+    };
+    static const byte rfcMessage[] = {
+        0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+        0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51,
+        0x30, 0xC8, 0x1C, 0x46, 0xA3, 0x5C, 0xE4, 0x11, 0xE5, 0xFB, 0xC1, 0x19, 0x1A, 0x0A, 0x52, 0xEF,
+        0xF6, 0x9F, 0x24, 0x45, 0xDF, 0x4F, 0x9B, 0x17, 0xAD, 0x2B, 0x41, 0x7B, 0xE6, 0x6C, 0x37, 0x10
+    };
+    static const struct {
+        byte length;
+        byte mac[AES_BLOCK_SIZE];
+    } rfcExamples[] = {
+        {  0, { 0xBB, 0x1D, 0x69, 0x29, 0xE9, 0x59, 0x37, 0x28, 0x7F, 0xA3, 0x7D, 0x12, 0x9B, 0x75, 0x67, 0x46 } },
+        { 16, { 0x07, 0x0A, 0x16, 0xB4, 0x6B, 0x4D, 0x41, 0x44, 0xF7, 0x9B, 0xDD, 0x9D, 0xD0, 0x4A, 0x28, 0x7C } },
+        { 40, { 0xDF, 0xA6, 0x67, 0x47, 0xDE, 0x9A, 0xE6, 0x30, 0x30, 0xCA, 0x32, 0x61, 0x14, 0x97, 0xC8, 0x27 } },
+        { 64, { 0x51, 0xF0, 0xBE, 0xBF, 0x7E, 0x3B, 0x9D, 0x92, 0xFC, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3C, 0xFE } }
+    };
+    byte out[AES_BLOCK_SIZE];
+    Aes128(fipsKey).encrypt(fipsPlain, out);
+    bool ok = memcmp(out, fipsCipher, sizeof(out)) == 0;
+    AesCmac cmac(rfcKey);
+    for(byte i = 0; i < sizeof(rfcExamples) / sizeof(rfcExamples[0]); i++) {
+        cmac.mac(rfcMessage, rfcExamples[i].length, out);
+        ok &= memcmp(out, rfcExamples[i].mac, sizeof(out)) == 0;
+    }
+    Serial.printf("  FIPS-197 C.1, RFC 4493 examples 1-4%s\n", ok ? "" : ", failed");
+    return ok;
+}
+
+// The AN10922 example: AES-128 master key, UID 04782E21801D80, application and system identifier
+static bool an10922()
+{
+    static const byte masterKey[] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+    };
+    static const byte input[] = {
+        0x01, 0x04, 0x78, 0x2E, 0x21, 0x80, 0x1D, 0x80, 0x30, 0x42, 0xF5, 0x4E, 0x58, 0x50, 0x20, 0x41, 0x62, 0x75
+    };
+    static const byte expected[] = {
+        0xA8, 0xDD, 0x63, 0xA3, 0xB8, 0x9D, 0x54, 0xB3, 0x7C, 0xA8, 0x02, 0x47, 0x3F, 0xDA, 0x91, 0x75
+    };
+    byte diversified[AES_BLOCK_SIZE];
+    AesCmac(masterKey).mac(input, sizeof(input), 2, diversified);
+    return memcmp(diversified, expected, sizeof(expected)) == 0;
+}
+
+// Derivation is MCU work only, so it is measured on the host CPU (not virtual time)
+static bool derivations()
+{
+    static const byte masterKey[AES_BLOCK_SIZE] = { 0x4D, 0x41, 0x53, 0x54, 0x45, 0x52 };
+    const uint32_t count = 200000;
+    MifareDiversifiedKeys keys(masterKey);
+    MFRC522::Uid uid = {};
+    uid.size = 7;
+    memcpy(uid.uidByte, "\x04\x11\x22\x33\x44\x55\x66", 7);
+    MifareSectorKey key;
+    volatile byte sink = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < count; i++) {
+        uid.uidByte[6] = i >> 4;
+        keys.key(uid, i & 0x0F, 0, key);
+        sink = sink ^ key.key.keyByte[0];
+    }
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+    bool ok = an10922();
+    Serial.printf("  %-34s %8.0f ns per key %10.0f keys/s (host CPU)%s\n", "MifareDiversifiedKeys",
+                  (double)elapsed.count() / count, count * 1e9 / elapsed.count(), ok ? "" : ", failed");
+    return ok;
+}
+
+bool bench_keys()
+{
+    MFRC522Sim pcd;
+    SimMifareClassic card(SimMifareClassic::CLASSIC_1K, uid);
+    prepare(card);
+    pcd.addPicc(&card);
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+    MFRC522 mfrc522(BENCH_PCD_BUS(pcd));
+    mfrc522.PCD_Init();
+
+    Serial.println(F("\nMIFARE Classic key search, 1K, 15 key dictionary"));
+    bool ok = perDetection(mfrc522);
+    MifareKeyTable table(knownKeys, KNOWN_KEYS);
+    ok &= search("32 keys (A and B, 16 sectors)", mfrc522, table);
+    GeneratedKeys generated;
+    ok &= search("32 keys, 1015 key dictionary", mfrc522, generated);
+
+    Serial.println(F("\nSector key diversification, AES-128 CMAC"));
+    ok &= knownAnswers();
+    ok &= derivations();
+
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+    return ok;
+}
@@ -0,0 +1,109 @@
+// A tag put on the reader, left there for a while and taken away: the delay(1000) poll loop of src/reader vs
+// NfcTagMonitor. Latency to notice the tag, and what the rest of the time costs on the bus.
+#include "bench.h"
+#include "NfcTagMonitor.h"
+#include "MFRC522Sim.h"
+#include "SimMifareUltralight.h"
+
+static const byte uid[] = { 0x04, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77 };
+
+static const uint32_t ARRIVE_MS = 500;
+static const uint32_t DEPART_MS = 3500;
+static const uint32_t END_MS = 5000;
+
+struct Visit {
+    MFRC522Sim * pcd;
+    SimPicc * card;
+    NfcAdapter * nfc;
+    uint32_t arrivedMs;
+    uint32_t departedMs;
+    uint32_t reads;
+};
+
+static void arrive(void * context)
+{
+    Visit * visit = (Visit *)context;
+    visit->pcd->addPicc(visit->card);
+}
+
+static void depart(void * context)
+{
+    Visit * visit = (Visit *)context;
+    visit->pcd->removePicc(visit->card);
+}
+
+static void onTag(const NfcTagEvent & event, void * context)
+{
+    Visit * visit = (Visit *)context;
+    if(event.type == NfcTagEvent::ARRIVED) {
+        visit->arrivedMs = event.timeMs;
+        visit->nfc->read();
+        visit->reads++;
+    }
+    else if(event.type == NfcTagEvent::DEPARTED) {
+        visit->departedMs = event.timeMs;
+    }
+}
+
+// Both start at time 0 with the card coming at ARRIVE_MS and leaving at DEPART_MS. False if the arrival went
+// unnoticed, or the departure when departure is set
+template <typename Loop> static bool run(const char * name, bool departure, Loop loop)
+{
+    MFRC522Sim pcd;
+    SimMifareUltralight card(SimMifareUltralight::NTAG213, uid);
+    pcd.connectIrq(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+    MFRC522 mfrc522(BENCH_PCD_BUS(pcd), BENCH_PCD_IRQ_PIN);
+    mfrc522.PCD_Init();
+    NfcAdapter nfc(&mfrc522);
+    nfc.begin(false);
+
+    Visit visit = { &pcd, &card, &nfc, 0, 0, 0 };
+    HostClock::reset();
+    HostClock::schedule((uint64_t)ARRIVE_MS * 1000000, arrive, &visit);
+    HostClock::schedule((uint64_t)DEPART_MS * 1000000, depart, &visit);
+
+    bench_begin();
+    loop(visit);
+    bench_report(name, bench_end());
+    Serial.printf("    arrival noticed after %u ms, departure ", visit.arrivedMs - ARRIVE_MS);
+    if(visit.departedMs) {
+        Serial.printf("after %u ms", visit.departedMs - DEPART_MS);
+    }
+    else {
+        Serial.print(F("not noticed"));
+    }
+    bool ok = visit.reads > 0 && (visit.departedMs || !departure);
+    Serial.printf(", %u reads%s\n", visit.reads, ok ? "" : ", failed");
+
+    detachInterrupt(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+    return ok;
+}
+
+bool bench_monitor()
+{
+    Serial.printf("\nTag on the reader from %u to %u ms, %u ms in total\n", ARRIVE_MS, DEPART_MS, END_MS);
+
+    bool ok = run("tagPresent + delay(1000)", false, [](Visit & visit) {
+        while(millis() < END_MS) {
+            if(visit.nfc->tagPresent()) {
+                if(visit.reads == 0) {
+                    visit.arrivedMs = millis();
+                }
+                visit.nfc->read();
+                visit.reads++;
+            }
+            delay(1000);
+        }
+    });
+
+    ok &= run("NfcTagMonitor", true, [](Visit & visit) {
+        NfcTagMonitor monitor(visit.nfc);
+        monitor.subscribe(onTag, &visit);
+        while(millis() < END_MS) {
+            delay(monitor.poll());
+        }
+    });
+    return ok;
+}
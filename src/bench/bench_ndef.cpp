@@ -0,0 +1,342 @@
+// Parsing a 20 record message read from a tag: NdefMessage, a heap copy of every record and a deep copy per
+// getRecord(), vs NdefMessageView, in place. Host CPU time, not virtual time: parsing costs no bus traffic.
+// Then a soak of read-decode-discard cycles with the NDEF classes on the heap, an arena and a pool, and bulk
+// provisioning: the message with the tag's UID in its URL encoded per tag vs a PreparedNdefWrite patched per tag.
+#include <chrono>
+#include <utility>
+#include "bench.h"
+#include "NdefMessage.h"
+#include "NdefMessageView.h"
+#include "NfcAdapter.h"
+#include "MFRC522Sim.h"
+#include "SimMifareUltralight.h"
+
+#ifdef __GLIBC__
+// Counts the heap allocations by replacing malloc and friends with glibc's own
+extern "C" {
+    void * __libc_malloc(size_t size);
+    void * __libc_calloc(size_t count, size_t size);
+    void * __libc_realloc(void * pointer, size_t size);
+    void __libc_free(void * pointer);
+}
+
+static uint32_t allocations;
+
+extern "C" void * malloc(size_t size)
+{
+    allocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void * calloc(size_t count, size_t size)
+{
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void * realloc(void * pointer, size_t size)
+{
+    allocations++;
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void * pointer)
+{
+    __libc_free(pointer);
+}
+#else
+static uint32_t allocations;    // not counted
+#endif
+
+static const uint8_t RECORDS = 20;
+
+// Returns what parse returns, the same for every parser of the message
+template <typename Parse> static uint32_t cpu(const char * what, const byte * data, uint16_t length, Parse parse)
+{
+    const uint32_t parses = 100000;
+    volatile uint32_t sink = 0;
+    uint32_t before = allocations;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < parses; i++) {
+        sink = sink + parse(data, length);
+    }
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+    double seconds = elapsed.count() / 1e9;
+    Serial.printf("  %-34s %8.0f ns per parse %10.0f records/s %6.1f allocations per parse (host CPU)\n", what,
+                  elapsed.count() / (double)parses, parses * RECORDS / seconds, (allocations - before) / (double)parses);
+    return parse(data, length);
+}
+
+static const byte uid[] = { 0x04, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56 };
+static const uint32_t CYCLES = 1000;
+
+static bool soak(const char * what, NfcAdapter & nfc, NdefAllocator * allocator, NdefArena * arena)
+{
+    nfc.setAllocator(allocator);
+    NdefHeapInfo heap = ndef_heap_info();
+    uint32_t systemHeap = allocations;
+    uint32_t records = 0;
+    bool ok = true;
+    for(uint32_t i = 0; i < CYCLES && ok; i++) {
+        ok = nfc.tagStillPresent();
+        {
+            NfcTag tag = nfc.read();
+            NdefMessage message = tag.getNdefMessage();
+            for(uint8_t r = 0; r < message.getRecordCount(); r++) {
+                records += message.getRecord(r).getPayloadLength() > 0;
+            }
+            ok = ok && message.getRecordCount() == 3;
+        }
+        if(arena) {
+            arena->reset();
+        }
+    }
+    NdefHeapInfo after = ndef_heap_info();
+    Serial.printf("  %-34s %6.1f NDEF heap calls %6.1f system heap calls per cycle, %u records%s\n", what,
+                  (after.allocations - heap.allocations) / (double)CYCLES, (allocations - systemHeap) / (double)CYCLES,
+                  records, ok ? "" : ", failed");
+    if(allocator) {
+        Serial.printf("    %u allocations, %u failed, high-water %u bytes\n", allocator->allocations, allocator->failures,
+                      (unsigned)allocator->highWater);
+    }
+    if(after.freeBytes) {
+        Serial.printf("    heap %u free, largest block %u, %u%% fragmented, low water %u\n", (unsigned)after.freeBytes,
+                      (unsigned)after.largestFreeBlock, after.fragmentation(), (unsigned)after.minimumFreeBytes);
+    }
+    nfc.setAllocator(NULL);
+    return ok;
+}
+
+static bool soak()
+{
+    MFRC522Sim pcd;
+    SimMifareUltralight tag(SimMifareUltralight::NTAG213, uid);
+    pcd.addPicc(&tag);
+    pcd.connectIrq(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+    MFRC522 mfrc522(BENCH_PCD_BUS(pcd), BENCH_PCD_IRQ_PIN);
+    mfrc522.PCD_Init();
+    NfcAdapter nfc(&mfrc522);
+    nfc.begin(false);
+
+    NdefMessage message;
+    message.addUriRecord("https://github.com/");
+    message.addTextRecord("Hello from the simulator");
+    message.addExternalRecord("example.com:soak", (const byte *)"12345678", 8);
+    bool ok = nfc.tagPresent() && nfc.write(message);
+    if(!ok) {
+        Serial.println(F("  soak: write failed"));
+    }
+
+    Serial.printf("\nRead, decode, discard; %u cycles on a simulated NTAG213\n", CYCLES);
+    ok &= soak("heap", nfc, NULL, NULL);
+    byte buffer[1024];
+    NdefArena arena(buffer, sizeof(buffer));
+    ok &= soak("arena, reset per cycle", nfc, &arena, &arena);
+    NdefPool<96, 16> pool;
+    ok &= soak("pool, 16 blocks of 96 bytes", nfc, &pool, NULL);
+
+    detachInterrupt(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+    return ok;
+}
+
+static const char * const PROVISIONING_URL = "https://acme.com/asset/UUUUUUUUUUUUUU";
+
+static void provisioningMessage(NdefMessage & message, const char * url)
+{
+    message.addUriRecord(url);
+    message.addTextRecord("Property of ACME");
+    message.addMimeMediaRecord("application/vnd.acme.asset", "batch=11;line=3");
+}
+
+// Host CPU per tag to have the bytes to write, then the writes on simulated tags checked by reading back
+static bool provisioning()
+{
+    const uint32_t tags = 100000;
+    byte tagUid[7] = { 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80 };
+    volatile uint32_t sink = 0;
+
+    Serial.println(F("\nProvisioning, image of a 3 record message with the UID in the URL"));
+    uint32_t before = allocations;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < tags; i++) {
+        memcpy(&tagUid[1], &i, sizeof(i));
+        char url[64];
+        snprintf(url, sizeof(url), "https://acme.com/asset/%02X%02X%02X%02X%02X%02X%02X", tagUid[0], tagUid[1],
+                 tagUid[2], tagUid[3], tagUid[4], tagUid[5], tagUid[6]);
+        NdefMessage message;
+        provisioningMessage(message, url);
+        uint16_t length = message.getEncodedSize();
+        byte image[PreparedNdefWrite::imageSize(length)];
+        PreparedNdefWrite::encodeImage(message, length, image);
+        sink = sink + image[length];
+    }
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+    Serial.printf("  %-34s %8.0f ns per tag %6.1f allocations per tag (host CPU)\n", "NdefMessage per tag",
+                  elapsed.count() / (double)tags, (allocations - before) / (double)tags);
+
+    NdefMessage message;
+    provisioningMessage(message, PROVISIONING_URL);
+    PreparedNdefWrite prepared(message);
+    int8_t serial = prepared.addPatch("UUUUUUUUUUUUUU");
+    before = allocations;
+    start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < tags; i++) {
+        memcpy(&tagUid[1], &i, sizeof(i));
+        prepared.patchHex(serial, tagUid, sizeof(tagUid));
+        sink = sink + prepared.image()[prepared.messageLength()];
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    Serial.printf("  %-34s %8.0f ns per tag %6.1f allocations per tag (host CPU)\n", "PreparedNdefWrite, patchHex",
+                  elapsed.count() / (double)tags, (allocations - before) / (double)tags);
+
+    // the same on the bus, and what the tags got
+    MFRC522Sim pcd;
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+    MFRC522 mfrc522(BENCH_PCD_BUS(pcd));
+    mfrc522.PCD_Init();
+    mfrc522.PCD_SetCrcMode(MFRC522::PCD_CRC_FRAMED);
+    NfcAdapter nfc(&mfrc522);
+    nfc.begin(false);
+    uint8_t written = 0;
+    bench_begin();
+    for(uint8_t i = 0; i < 10; i++) {
+        byte id[7] = { 0x04, 0x10, 0x20, 0x30, 0x40, 0x50, i };
+        SimMifareUltralight tag(SimMifareUltralight::NTAG213, id);
+        pcd.addPicc(&tag);
+        if(nfc.tagPresent() && prepared.patchHex(serial, nfc.uid().uidByte, nfc.uid().size) && nfc.write(prepared)
+           && nfc.tagStillPresent()) {
+            NfcTag read = nfc.read();
+            char expected[64];
+            snprintf(expected, sizeof(expected), "https://acme.com/asset/041020304050%02X", i);
+            const NdefRecord & uri = read.message().record(0);
+            written += uri.getPayloadLength() == strlen(expected) + 1
+                       && memcmp(uri.getPayload() + 1, expected, strlen(expected)) == 0;
+        }
+        nfc.haltTag();
+        pcd.removePicc(&tag);
+    }
+    bench_report("10 NTAG213 prepared, with read back", bench_end());
+    Serial.printf("    %u of 10 tags have their own URL%s\n", written, written == 10 ? "" : ", failed");
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+    return written == 10;
+}
+
+// Views of a record whose 32 bit payload length wraps the size, and of records that are not there
+static bool malformed(const byte * data, uint16_t length)
+{
+    static const byte wrapped[] = { 0xC1, 0x00, 0xFF, 0xFF, 0xFF, 0xFF };
+    NdefMessageView view(wrapped, sizeof(wrapped));
+    uint8_t records = 0;
+    for(NdefMessageView::Iterator it = view.begin(); it != view.end() && records < 10; ++it) {
+        records++;
+    }
+    bool ok = !view.isValid() && view.getRecordCount() == 0 && records == 0;
+
+    NdefRecordView none;
+    NdefRecordView past = NdefMessageView(data, length).getRecord(RECORDS);
+    ok = ok && none.getTnf() == NdefRecord::TNF_EMPTY && none.isLast() && none.getPayloadLength() == 0
+         && past.getTnf() == NdefRecord::TNF_EMPTY && past.isLast();
+    Serial.printf("  %-34s %s\n", "malformed views", ok ? "rejected" : "failed");
+    return ok;
+}
+
+// A pool that runs out halfway through copying a record: the record is not added, or keeps only what it got
+static bool exhausted()
+{
+    NdefPool<64, 3> pool;
+    NdefMessage message(&pool);
+    message.addTextRecord("hello world");
+    byte data[64];
+    uint16_t length = message.getEncodedSize();
+    bool ok = message.getRecordCount() == 0 && length <= sizeof(data);
+    if(ok) {
+        message.encode(data);
+    }
+
+    NdefRecord record;
+    record.setType((const byte *)"T", 1);
+    record.setPayload((const byte *)"payload", 7);
+    NdefPool<64, 1> one;
+    NdefRecord copy(record, &one);
+    NdefRecord assigned(&one);
+    assigned = record;
+    ok = ok && copy.getTypeLength() == 1 && copy.getPayloadLength() == 0 && copy.getPayload() == NULL
+         && assigned.getTypeLength() == 0 && assigned.getPayloadLength() == 0 && copy.getEncodedSize() <= sizeof(data);
+    if(ok) {
+        copy.encode(data, true, true);
+    }
+    Serial.printf("  %-34s %s\n", "records copied into a full pool", ok ? "left out" : "failed");
+    return ok;
+}
+
+bool bench_ndef()
+{
+    NdefMessage message;
+    char text[32];
+    for(uint8_t i = 0; i < RECORDS; i++) {
+        snprintf(text, sizeof(text), "record %u", i);
+        if(i % 2) {
+            message.addTextRecord(text);
+        }
+        else {
+            message.addUriRecord("https://github.com/");
+        }
+    }
+    uint16_t length = message.getEncodedSize();
+    byte data[length];
+    message.encode(data);
+
+    Serial.printf("\nNDEF message, %u records, %u bytes\n", RECORDS, length);
+
+    uint32_t bytes = cpu("NdefMessage, getRecord()", data, length, [](const byte * data, uint16_t length) {
+        NdefMessage message(data, length);
+        uint32_t bytes = 0;
+        for(uint8_t i = 0; i < message.getRecordCount(); i++) {
+            bytes += message.getRecord(i).getPayloadLength();
+        }
+        return bytes;
+    });
+    bool ok = cpu("NdefMessageView, iterator", data, length, [](const byte * data, uint16_t length) {
+        NdefMessageView message(data, length);
+        uint32_t bytes = 0;
+        for(NdefMessageView::Iterator it = message.begin(); it != message.end(); ++it) {
+            bytes += it->getPayloadLength();
+        }
+        return bytes;
+    }) == bytes;
+
+
+    // What reader.cpp does with a tag read(): returned by value, then every record looked at
+    static byte uidBytes[] = { 0x04, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56 };
+    ok &= cpu("NfcTag, getNdefMessage() copies", data, length, [](const byte * data, uint16_t length) {
+        NfcTag read(uidBytes, sizeof(uidBytes), NfcTag::TYPE_2, data, length);
+        NfcTag tag = read;
+        NdefMessage message = tag.getNdefMessage();
+        uint32_t bytes = 0;
+        for(uint8_t i = 0; i < message.getRecordCount(); i++) {
+            NdefRecord record = message.getRecord(i);
+            bytes += record.getPayloadLength();
+        }
+        return bytes;
+    }) == bytes;
+    ok &= cpu("NfcTag, moved, message() references", data, length, [](const byte * data, uint16_t length) {
+        NfcTag read(uidBytes, sizeof(uidBytes), NfcTag::TYPE_2, data, length);
+        NfcTag tag = std::move(read);
+        uint32_t bytes = 0;
+        for(const NdefRecord & record : tag.message()) {
+            bytes += record.getPayloadLength();
+        }
+        return bytes;
+    }) == bytes;
+    if(!ok) {
+        Serial.println(F("  the parsers disagree"));
+    }
+    ok &= malformed(data, length);
+    ok &= exhausted();
+
+    ok &= soak();
+    ok &= provisioning();
+    return ok;
+}
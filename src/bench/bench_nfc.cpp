@@ -0,0 +1,447 @@
+// NDEF read and write on simulated cards: what NfcAdapter costs end to end, card presented to result.
+// Then a counter in a text record bumped with write() vs update(), which only writes what changed, the
+// largest message each MIFARE Classic takes, a 1K NDEF shares with another application, and tags keyed per batch
+// or per UID and sector read through a key provider.
+#include "bench.h"
+#include "NfcAdapter.h"
+#include "MFRC522Sim.h"
+#include "SimMifareClassic.h"
+#include "SimMifareUltralight.h"
+
+static const byte classicUid[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+static const byte sharedUid[] = { 0x5A, 0x4E, 0x41, 0x52 };
+static const byte batchUid[] = { 0xBA, 0x7C, 0x40, 0x03 };
+static const byte diversifiedUid[] = { 0x04, 0x78, 0x2E, 0x21, 0x80, 0x1D, 0x80 };
+static const byte ntagUid[] = { 0x04, 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0x80 };
+// formatNDEF() sets key A of the NDEF sectors to the public NFC Forum key, read() authenticates with the adapter's
+static const MFRC522::MIFARE_Key ndefKey = {{ 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 }};
+
+// The card enters the field, the adapter finds it, runs what, and halts it again.
+template <typename Operation>
+static bool run(const char * what, MFRC522Sim & pcd, SimPicc & card, NfcAdapter & nfc, Operation operation)
+{
+    pcd.removePicc(&card);
+    pcd.addPicc(&card);
+    MifareClassicSession before = nfc.classicSession();
+    bench_begin();
+    bool ok = nfc.tagPresent() && operation();
+    nfc.haltTag();
+    BenchCost cost = bench_end();
+    bench_report(what, cost);
+    if(!ok) {
+        Serial.printf("  %s failed\n", what);
+    }
+    const MifareClassicSession & after = nfc.classicSession();
+    if(after.authentications != before.authentications) {
+        Serial.printf("    %u authentications, %u saved\n", after.authentications - before.authentications,
+                      after.skipped - before.skipped);
+    }
+    return ok;
+}
+
+static bool card(const char * name, MFRC522Sim & pcd, SimPicc & card, NfcAdapter & nfc, bool format)
+{
+    char label[40];
+    NdefMessage message;
+    message.addUriRecord("https://github.com/");
+    message.addTextRecord("Hello from the simulator");
+
+    bool ok = true;
+    pcd.addPicc(&card);
+    if(format) {
+        snprintf(label, sizeof(label), "format (%s)", name);
+        ok = run(label, pcd, card, nfc, [&]() {
+            return nfc.format();
+        });
+    }
+    snprintf(label, sizeof(label), "write (%s)", name);
+    ok &= run(label, pcd, card, nfc, [&]() {
+        return nfc.write(message);
+    });
+    snprintf(label, sizeof(label), "read (%s)", name);
+    ok &= run(label, pcd, card, nfc, [&]() {
+        NfcTag tag = nfc.read();
+        return tag.hasNdefMessage() && tag.getNdefMessage().getRecordCount() == message.getRecordCount();
+    });
+    snprintf(label, sizeof(label), "write + read (%s)", name);
+    ok &= run(label, pcd, card, nfc, [&]() {
+        NfcTag tag = nfc.write(message) ? nfc.read() : NfcTag(NULL, 0, NfcTag::TYPE_UNKNOWN);
+        return tag.hasNdefMessage() && tag.getNdefMessage().getRecordCount() == message.getRecordCount();
+    });
+    pcd.removePicc(&card);
+    return ok;
+}
+
+static bool report(const char * what, const BenchCost & cost, bool ok)
+{
+    bench_report(what, cost);
+    if(!ok) {
+        Serial.printf("  %s: unexpected result\n", what);
+    }
+    return ok;
+}
+
+// A tag resting on the reader, found again: REQA and anticollision vs reselecting the UID already known.
+static bool resting(MFRC522Sim & pcd, SimPicc & card, NfcAdapter & nfc)
+{
+    pcd.addPicc(&card);
+    nfc.tagPresent();
+
+    // REQA makes the active tag fall back to IDLE silently, the second poll finds it
+    bench_begin();
+    bool found = nfc.tagPresent() || nfc.tagPresent();
+    bool ok = report("poll active tag: tagPresent", bench_end(), found);
+
+    bench_begin();
+    found = nfc.tagStillPresent();
+    ok &= report("poll active tag: tagStillPresent", bench_end(), found);
+
+    nfc.haltTag();
+    bench_begin();
+    found = nfc.tagStillPresent();
+    ok &= report("poll halted tag: tagStillPresent", bench_end(), found);
+
+    pcd.removePicc(&card);
+    bench_begin();
+    found = nfc.tagStillPresent();
+    ok &= report("poll removed tag: tagStillPresent", bench_end(), !found);
+    return ok;
+}
+
+// Counts the WRITE commands a simulated card gets
+template <typename Card> class CountingCard : public Card
+{
+    public:
+        template <typename... Args> CountingCard(Args... args) : Card(args...), writes(0) {}
+        uint32_t writes;
+    protected:
+        bool transceive(const byte * data, uint16_t length, SimFrame & response, uint32_t & delayNs)
+        {
+            // COMPATIBILITY WRITE and Classic WRITE: command and address, the data follows in a second frame
+            if((data[0] == MFRC522::PICC_CMD_MF_WRITE && length <= 4) || data[0] == MFRC522::PICC_CMD_UL_WRITE) {
+                writes++;
+            }
+            return Card::transceive(data, length, response, delayNs);
+        }
+};
+
+template <typename Card> static bool counter(MFRC522Sim & pcd, Card & card, NfcAdapter & nfc)
+{
+    char text[200];
+    memset(text, '-', sizeof(text));
+    pcd.addPicc(&card);
+    bool ok = nfc.tagPresent();
+    bool counted = ok;
+    for(uint8_t mode = 0; mode < 2; mode++) {
+        uint32_t writes = 0;
+        BenchCost total = {};
+        for(uint16_t count = 1; count <= 10; count++) {
+            snprintf(text, sizeof(text), "count=%04u, the rest of the record stays the same: %0140u", count, 0);
+            NdefMessage message;
+            message.addUriRecord("https://github.com/");
+            message.addTextRecord(text);
+            uint32_t before = card.writes;
+            bench_begin();
+            ok = ok && (mode ? nfc.update(message) : nfc.write(message));
+            BenchCost cost = bench_end();
+            writes += card.writes - before;
+            total.us += cost.us;
+            total.transactions += cost.transactions;
+            ok = ok && nfc.tagStillPresent() && nfc.read().message().record(1).getPayloadLength() == strlen(text) + 3;
+            ok = ok && nfc.tagStillPresent();
+        }
+        Serial.printf("  %-34s %6.1f writes %8.0f us per bump%s\n", mode ? "update()" : "write()", writes / 10.0,
+                      total.us / 10.0, ok ? "" : ", failed");
+        counted &= ok;
+    }
+    nfc.haltTag();
+    pcd.removePicc(&card);
+    return counted;
+}
+
+// A text record as long as the NDEF sectors of card take, formatted, written and read back
+static bool largest(const char * name, MFRC522Sim & pcd, SimMifareClassic & card, NfcAdapter & nfc)
+{
+    static char text[4096];
+    uint16_t capacity = MifareClassic::geometryOf(card.blockCount() == 256 ? MFRC522::PICC_TYPE_MIFARE_4K
+                        : card.blockCount() == 20 ? MFRC522::PICC_TYPE_MIFARE_MINI : MFRC522::PICC_TYPE_MIFARE_1K).ndefBytes();
+    // NDEF TLV (2 or 4), text record (header 3 or 6, type 1, status and language 3), terminator
+    uint16_t length = capacity - (capacity > 0xFF + 16 ? 4 + 6 : 2 + 3) - 1 - 3 - 1;
+    memset(text, 'a', length);
+    text[length] = 0;
+    NdefMessage message;
+    message.addTextRecord(text);
+    char label[40];
+
+    pcd.addPicc(&card);
+    snprintf(label, sizeof(label), "format (%s)", name);
+    bool ok = run(label, pcd, card, nfc, [&]() {
+        return nfc.format();
+    });
+    snprintf(label, sizeof(label), "write %u bytes (%s)", message.getEncodedSize(), name);
+    ok &= run(label, pcd, card, nfc, [&]() {
+        return nfc.write(message);
+    });
+    snprintf(label, sizeof(label), "read %u bytes (%s)", message.getEncodedSize(), name);
+    ok &= run(label, pcd, card, nfc, [&]() {
+        NfcTag tag = nfc.read();
+        return tag.hasNdefMessage() && tag.message().record(0).getPayloadLength() == length + 3u;
+    });
+    message.addTextRecord("one too many");
+    snprintf(label, sizeof(label), "write too long (%s)", name);
+    ok &= run(label, pcd, card, nfc, [&]() {
+        return !nfc.write(message);
+    });
+    pcd.removePicc(&card);
+    return ok;
+}
+
+// Sectors 1 and 2 of a formatted 1K go to another application, with its own key A; the MAD tells so and NDEF
+// starts in sector 3. The first read of the tag in a session reads the MAD, the next ones know it.
+static bool shared(MFRC522 & mfrc522, MFRC522Sim & pcd, NfcAdapter & nfc)
+{
+    static const byte otherKey[] = { 0x0B, 0x0B, 0x0B, 0x0B, 0x0B, 0x0B };
+    SimMifareClassic card(SimMifareClassic::CLASSIC_1K, sharedUid);
+    NfcAdapter setup(&mfrc522);
+    setup.begin(false);
+    pcd.addPicc(&card);
+    bool ok = setup.tagPresent() && setup.format();
+    setup.haltTag();
+    byte * mad = card.block(1);
+    for(byte sector = 1; sector <= 2; sector++) {
+        mad[2 * sector] = 0x01;
+        mad[2 * sector + 1] = 0x48;
+        memcpy(card.block(SimMifareClassic::trailerOf(sector)), otherKey, sizeof(otherKey));
+        memset(card.block(sector * 4), 0xA5, BLOCK_SIZE);
+    }
+    mad[0] = MifareClassic::madCrc(&mad[1], 31);
+    Serial.println(ok ? F(" 1K, sectors 1-2 another application's") : F(" 1K, format failed"));
+
+    NdefMessage message;
+    message.addUriRecord("https://github.com/");
+    message.addTextRecord("Hello from the simulator");
+    ok &= run("write (shared 1K)", pcd, card, nfc, [&]() {
+        return nfc.write(message);
+    });
+    for(byte known = 0; known < 2; known++) {
+        NfcAdapter cold(&mfrc522);
+        cold.begin(ndefKey, false);
+        NfcAdapter & reader = known ? nfc : cold;
+        ok &= run(known ? "read, MAD known (shared 1K)" : "read, MAD read (shared 1K)", pcd, card, reader, [&]() {
+            NfcTag tag = reader.read();
+            return tag.hasNdefMessage() && tag.getNdefMessage().getRecordCount() == message.getRecordCount();
+        });
+    }
+    if(card.block(4)[0] != 0xA5 || card.block(8)[0] != 0xA5 || card.block(12)[0] != 0x03) {
+        Serial.println(F("  shared 1K: unexpected result"));
+        ok = false;
+    }
+    pcd.removePicc(&card);
+    return ok;
+}
+
+// A formatted 4K whose MAD2 sector refuses the public key: the NDEF sectors of MAD1 are still read
+static bool madTwoLocked(MFRC522 & mfrc522, MFRC522Sim & pcd, NfcAdapter & nfc)
+{
+    SimMifareClassic card(SimMifareClassic::CLASSIC_4K, sharedUid);
+    NdefMessage message;
+    message.addUriRecord("https://github.com/");
+    pcd.addPicc(&card);
+    bool ok = nfc.tagPresent() && nfc.format() && nfc.tagStillPresent() && nfc.write(message);
+    nfc.haltTag();
+    pcd.removePicc(&card);
+    memset(card.block(SimMifareClassic::trailerOf(16)), 0x16, MFRC522::MF_KEY_SIZE);
+    Serial.println(ok ? F(" 4K, MAD2 sector locked") : F(" 4K, format failed"));
+
+    NfcAdapter cold(&mfrc522);
+    cold.begin(ndefKey, false);
+    ok &= run("read, MAD1 only (4K)", pcd, card, cold, [&]() {
+        NfcTag tag = cold.read();
+        return tag.hasNdefMessage() && tag.getNdefMessage().getRecordCount() == message.getRecordCount();
+    });
+    pcd.removePicc(&card);
+    return ok;
+}
+
+// The cache of a device that keeps it across restarts, in RAM
+class RamKeyStorage : public MifareKeyStorage
+{
+    public:
+        RamKeyStorage()
+        {
+            memset(_valid, 0, sizeof(_valid));
+        }
+        bool load(byte slot, void * data, size_t size)
+        {
+            if(!_valid[slot] || size != sizeof(_entries[slot])) {
+                return false;
+            }
+            memcpy(data, &_entries[slot], size);
+            return true;
+        }
+        bool save(byte slot, const void * data, size_t size)
+        {
+            memcpy(&_entries[slot], data, size);
+            _valid[slot] = true;
+            return true;
+        }
+    private:
+        MifareKeyCacheEntry _entries[MIFARE_KEY_CACHE_TAGS];
+        bool _valid[MIFARE_KEY_CACHE_TAGS];
+};
+
+// A 1K of the third batch: its NDEF sectors open with the third key of the ring only. The adapter's single key
+// fails; the resolver finds the key once, then tries it first, also after a restart.
+static bool batchKeys(MFRC522 & mfrc522, MFRC522Sim & pcd, NfcAdapter & nfc)
+{
+    static const MFRC522::MIFARE_Key batch[] = {
+        {{ 0xB1, 0x00, 0x00, 0x00, 0x00, 0x01 }}, {{ 0xB2, 0x00, 0x00, 0x00, 0x00, 0x02 }},
+        {{ 0xB3, 0x00, 0x00, 0x00, 0x00, 0x03 }}
+    };
+    SimMifareClassic card(SimMifareClassic::CLASSIC_1K, batchUid);
+    NdefMessage message;
+    message.addUriRecord("https://github.com/");
+    message.addTextRecord("Hello from the simulator");
+    NfcAdapter setup(&mfrc522);
+    setup.begin(false);
+    pcd.addPicc(&card);
+    bool ok = setup.tagPresent() && setup.format() && setup.write(message);
+    setup.haltTag();
+    for(byte sector = 1; sector < 16; sector++) {
+        memcpy(card.block(SimMifareClassic::trailerOf(sector)), batch[2].keyByte, MFRC522::MF_KEY_SIZE);
+    }
+    Serial.println(ok ? F(" 1K, 3 batch keys") : F(" 1K, format failed"));
+
+    auto read = [&]() {
+        NfcTag tag = nfc.read();
+        return tag.hasNdefMessage() && tag.getNdefMessage().getRecordCount() == message.getRecordCount();
+    };
+    ok &= run("read, adapter key refused", pcd, card, nfc, [&]() {
+        return !read();
+    });
+    RamKeyStorage storage;
+    MifareKeyResolver resolver(&storage);
+    for(byte i = 0; i < 3; i++) {
+        resolver.addKey(batch[i]);
+    }
+    resolver.begin();
+    nfc.setKeyProvider(&resolver);
+    ok &= run("read, key ring", pcd, card, nfc, read);
+    ok &= run("read, cached key", pcd, card, nfc, read);
+    MifareKeyResolver restarted(&storage);
+    for(byte i = 0; i < 3; i++) {
+        restarted.addKey(batch[i]);
+    }
+    restarted.begin();
+    nfc.setKeyProvider(&restarted);
+    ok &= run("read, cached key after restart", pcd, card, nfc, read);
+    Serial.printf("    %u entries saved, %u + %u cache hits\n", resolver.saves + restarted.saves, resolver.hits,
+                  restarted.hits);
+
+    // the tag gets a key of no batch: the cached key is forgotten, and the next one to open the sector is learned
+    memset(card.block(SimMifareClassic::trailerOf(1)), 0xEE, MFRC522::MF_KEY_SIZE);
+    uint32_t saves = restarted.saves;
+    ok &= run("read, key changed", pcd, card, nfc, [&]() {
+        return !read();
+    });
+    bool forgotten = restarted.saves == saves + 1;
+    memcpy(card.block(SimMifareClassic::trailerOf(1)), batch[1].keyByte, MFRC522::MF_KEY_SIZE);
+    uint32_t misses = restarted.misses;
+    ok &= run("read, key changed back", pcd, card, nfc, read);
+    forgotten = forgotten && restarted.misses == misses + 1;
+    Serial.printf("    the key is %s\n", forgotten ? "forgotten" : "still cached, failed");
+    ok &= forgotten;
+    nfc.setKeyProvider(NULL);
+    pcd.removePicc(&card);
+    return ok;
+}
+
+// A 1K whose NDEF sectors each have a key A diversified from the UID: no single key reads it
+static bool diversifiedKeys(MFRC522 & mfrc522, MFRC522Sim & pcd, NfcAdapter & nfc)
+{
+    static const byte masterKey[] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+    };
+    static const byte systemId[] = { 'b', 'e', 'n', 'c', 'h' };
+    MifareDiversifiedKeys keys(masterKey, MFRC522::PICC_CMD_MF_AUTH_KEY_A, systemId, sizeof(systemId));
+    SimMifareClassic card(SimMifareClassic::CLASSIC_1K, diversifiedUid, sizeof(diversifiedUid));
+    NdefMessage message;
+    message.addUriRecord("https://github.com/");
+    message.addTextRecord("Hello from the simulator");
+    NfcAdapter setup(&mfrc522);
+    setup.begin(false);
+    pcd.addPicc(&card);
+    bool ok = setup.tagPresent() && setup.format() && setup.write(message);
+    for(byte sector = 1; sector < 16; sector++) {
+        MifareSectorKey key;
+        keys.key(setup.uid(), sector, 0, key);
+        memcpy(card.block(SimMifareClassic::trailerOf(sector)), key.key.keyByte, MFRC522::MF_KEY_SIZE);
+    }
+    setup.haltTag();
+    Serial.println(ok ? F(" 1K, key A per sector") : F(" 1K, format failed"));
+
+    auto read = [&]() {
+        NfcTag tag = nfc.read();
+        return tag.hasNdefMessage() && tag.getNdefMessage().getRecordCount() == message.getRecordCount();
+    };
+    ok &= run("read, adapter key refused", pcd, card, nfc, [&]() {
+        return !read();
+    });
+    nfc.setKeyProvider(&keys);
+    ok &= run("read, diversified keys", pcd, card, nfc, read);
+    nfc.setKeyProvider(NULL);
+    pcd.removePicc(&card);
+    return ok;
+}
+
+bool bench_nfc()
+{
+    MFRC522Sim pcd;
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+    MFRC522 mfrc522(BENCH_PCD_BUS(pcd));
+    mfrc522.PCD_Init();
+    NfcAdapter nfc(&mfrc522);
+    nfc.begin(ndefKey, false);
+
+    Serial.println(F("\nNfcAdapter on simulated cards"));
+
+    SimMifareClassic classic(SimMifareClassic::CLASSIC_1K, classicUid);
+    bool ok = card("1K", pcd, classic, nfc, true);
+
+    SimMifareUltralight ntag(SimMifareUltralight::NTAG213, ntagUid);
+    ok &= card("NTAG213", pcd, ntag, nfc, false);
+    ok &= resting(pcd, ntag, nfc);
+
+    Serial.println(F("\nBumping a counter in a 2 record message"));
+    CountingCard<SimMifareUltralight> ntag216(SimMifareUltralight::NTAG216, ntagUid);
+    Serial.println(F(" NTAG216"));
+    ok &= counter(pcd, ntag216, nfc);
+    CountingCard<SimMifareClassic> counted(SimMifareClassic::CLASSIC_1K, classicUid);
+    pcd.addPicc(&counted);
+    bool formatted = nfc.tagPresent() && nfc.format();
+    nfc.haltTag();
+    pcd.removePicc(&counted);
+    Serial.println(formatted ? F(" 1K") : F(" 1K, format failed"));
+    ok &= formatted && counter(pcd, counted, nfc);
+
+    Serial.println(F("\nLargest message"));
+    SimMifareClassic mini(SimMifareClassic::MINI, classicUid);
+    ok &= largest("Mini", pcd, mini, nfc);
+    SimMifareClassic classic1k(SimMifareClassic::CLASSIC_1K, classicUid);
+    ok &= largest("1K", pcd, classic1k, nfc);
+    SimMifareClassic classic4k(SimMifareClassic::CLASSIC_4K, classicUid);
+    ok &= largest("4K", pcd, classic4k, nfc);
+
+    Serial.println(F("\nSharing a card with another application"));
+    ok &= shared(mfrc522, pcd, nfc);
+    ok &= madTwoLocked(mfrc522, pcd, nfc);
+
+    Serial.println(F("\nKeys per batch"));
+    ok &= batchKeys(mfrc522, pcd, nfc);
+
+    Serial.println(F("\nKeys diversified per UID and sector"));
+    ok &= diversifiedKeys(mfrc522, pcd, nfc);
+
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+    return ok;
+}
@@ -0,0 +1,211 @@
+// Large messages read whole (NfcAdapter::read, the data area buffered then decoded into an NfcTag) vs decoded
+// while the blocks come in (NdefStreamDecoder, one frame buffered).
+// Filtered reads of multi-record messages: the frames saved by stopping at the record wanted.
+#include "bench.h"
+#include "NfcAdapter.h"
+#include "MFRC522Sim.h"
+#include "SimMifareClassic.h"
+#include "SimMifareUltralight.h"
+
+static const byte classicUid[] = { 0xC0, 0xFF, 0xEE, 0x01 };
+static const byte ntagUid[] = { 0x04, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56 };
+static const MFRC522::MIFARE_Key ndefKey = {{ 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 }};
+
+// What the decoder saw: records, payload bytes and the pieces they came in
+struct Seen {
+    uint16_t records;
+    uint32_t payload;
+    uint16_t pieces;
+    uint32_t checksum;
+};
+
+static void seen(const NdefStreamEvent & event, void * context)
+{
+    Seen & seen = *static_cast<Seen *>(context);
+    if(event.type == NdefStreamEvent::RECORD) {
+        seen.records++;
+    }
+    else if(event.type == NdefStreamEvent::PAYLOAD) {
+        seen.payload += event.length;
+        seen.pieces++;
+        for(uint16_t i = 0; i < event.length; i++) {
+            seen.checksum += event.data[i];
+        }
+    }
+}
+
+static bool compare(const char * name, MFRC522Sim & pcd, SimPicc & card, NfcAdapter & nfc, uint16_t textLength)
+{
+    char text[1024];
+    for(uint16_t i = 0; i < textLength; i++) {
+        text[i] = 'A' + i % 26;
+    }
+    text[textLength] = 0;
+    NdefMessage message;
+    message.addUriRecord("https://github.com/");
+    message.addTextRecord(text);
+
+    char label[48];
+    pcd.addPicc(&card);
+    bool ok = nfc.tagPresent() && nfc.write(message) && nfc.tagStillPresent();
+
+    uint32_t frames = pcd.stats().framesSent;
+    bench_begin();
+    NfcTag tag = nfc.read();
+    BenchCost cost = bench_end();
+    frames = pcd.stats().framesSent - frames;
+    bool read = ok && tag.hasNdefMessage() && tag.message().getRecordCount() == 2;
+    snprintf(label, sizeof(label), "read (%s)", name);
+    bench_report(label, cost);
+    Serial.printf("    %u byte message, %u frames, buffered %u bytes%s\n", message.getEncodedSize(), frames,
+                  (message.getEncodedSize() + 4 + 15) / 16 * 16, read ? "" : ", failed");
+
+    nfc.haltTag();
+    ok = ok && nfc.tagStillPresent();
+    Seen result = { 0, 0, 0, 0 };
+    NdefStreamDecoder decoder(seen, &result);
+    frames = pcd.stats().framesSent;
+    bench_begin();
+    bool streamed = nfc.read(decoder);
+    cost = bench_end();
+    frames = pcd.stats().framesSent - frames;
+    ok = ok && streamed && result.records == 2 && result.payload == message.record(0).getPayloadLength()
+         + message.record(1).getPayloadLength();
+    snprintf(label, sizeof(label), "stream (%s)", name);
+    bench_report(label, cost);
+    Serial.printf("    %u payload bytes in %u pieces, %u frames, decoder %u bytes%s\n", result.payload, result.pieces,
+                  frames, (unsigned) sizeof(decoder), ok ? "" : ", failed");
+    nfc.haltTag();
+    pcd.removePicc(&card);
+    return ok && read;
+}
+
+static void text(NdefMessage & message, uint16_t length)
+{
+    char text[512];
+    memset(text, 'x', length);
+    text[length] = 0;
+    message.addTextRecord(text);
+}
+
+static void asset(NdefMessage & message)
+{
+    NdefRecord record;
+    record.setTnf(NdefRecord::TNF_EXTERNAL_TYPE);
+    record.setType((const byte *)"acme.com:asset", 14);
+    record.setPayload((const byte *)"pallet-00042", 12);
+    message.addRecord(record);
+}
+
+// Frames for the whole message vs for the record filter wants
+static bool filtered(const char * name, MFRC522Sim & pcd, SimPicc & card, NfcAdapter & nfc, NdefMessage & message,
+                     const NdefRecordFilter & filter, bool present)
+{
+    pcd.addPicc(&card);
+    bool ok = nfc.tagPresent() && nfc.write(message) && nfc.tagStillPresent();
+    uint32_t frames = pcd.stats().framesSent;
+    bench_begin();
+    ok = ok && nfc.read().message().getRecordCount() == message.getRecordCount();
+    BenchCost whole = bench_end();
+    uint32_t wholeFrames = pcd.stats().framesSent - frames;
+
+    nfc.haltTag();
+    ok = ok && nfc.tagStillPresent();
+    NdefRecord record;
+    frames = pcd.stats().framesSent;
+    bench_begin();
+    ok = ok && nfc.read(filter, record) == present;
+    BenchCost cost = bench_end();
+    frames = pcd.stats().framesSent - frames;
+    Serial.printf("  %-34s %3u -> %3u frames %7llu -> %7llu us%s\n", name, wholeFrames, frames,
+                  (unsigned long long) whole.us, (unsigned long long) cost.us, ok ? "" : ", failed");
+    nfc.haltTag();
+    pcd.removePicc(&card);
+    return ok;
+}
+
+// A record that claims a 2 GB payload in a 12 byte TLV: no match and nothing allocated for it
+static bool hostile(const char * what, MFRC522Sim & pcd, SimMifareUltralight & tag, NfcAdapter & nfc)
+{
+    static const byte tlv[] = { 0x03, 0x0C, 0xC4, 0x01, 0x7F, 0xFF, 0xFF, 0xF0, 'x', 0x01, 0x02, 0x03, 0x04, 0x05,
+                                0xFE };
+    memcpy(tag.page(4), tlv, sizeof(tlv));
+    pcd.addPicc(&tag);
+    NdefRecordFilter any(NdefRecord::TNF_EXTERNAL_TYPE);
+    NdefRecord record;
+    uint32_t allocations = ndef_heap_info().allocations;
+    bool ok = nfc.tagPresent() && !nfc.read(any, record) && ndef_heap_info().allocations == allocations;
+    Serial.printf("  %s: %s\n", what, ok ? "rejected" : "failed");
+    nfc.haltTag();
+    pcd.removePicc(&tag);
+    return ok;
+}
+
+static bool corpus(const char * tag, MFRC522Sim & pcd, SimPicc & card, NfcAdapter & nfc)
+{
+    NdefRecordFilter uri(NdefRecord::TNF_WELL_KNOWN, "U");
+    NdefRecordFilter assets(NdefRecord::TNF_EXTERNAL_TYPE, "acme.com:asset", 64);
+    char name[48];
+
+    NdefMessage first;
+    first.addUriRecord("https://github.com/");
+    text(first, 250);
+    text(first, 250);
+    snprintf(name, sizeof(name), "URI first (%s)", tag);
+    bool ok = filtered(name, pcd, card, nfc, first, uri, true);
+
+    NdefMessage last;
+    text(last, 250);
+    text(last, 250);
+    last.addUriRecord("https://github.com/");
+    snprintf(name, sizeof(name), "URI last (%s)", tag);
+    ok &= filtered(name, pcd, card, nfc, last, uri, true);
+
+    NdefMessage middle;
+    text(middle, 100);
+    asset(middle);
+    text(middle, 400);
+    snprintf(name, sizeof(name), "acme.com:asset second (%s)", tag);
+    ok &= filtered(name, pcd, card, nfc, middle, assets, true);
+
+    NdefMessage none;
+    text(none, 300);
+    text(none, 300);
+    snprintf(name, sizeof(name), "acme.com:asset absent (%s)", tag);
+    ok &= filtered(name, pcd, card, nfc, none, assets, false);
+    return ok;
+}
+
+bool bench_stream()
+{
+    MFRC522Sim pcd;
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+    MFRC522 mfrc522(BENCH_PCD_BUS(pcd));
+    mfrc522.PCD_Init();
+    mfrc522.PCD_SetCrcMode(MFRC522::PCD_CRC_FRAMED);
+    NfcAdapter nfc(&mfrc522);
+    nfc.begin(ndefKey, false);
+
+    Serial.println(F("\nStreaming NDEF decode"));
+
+    SimMifareUltralight ntag216(SimMifareUltralight::NTAG216, ntagUid);
+    bool ok = compare("NTAG216", pcd, ntag216, nfc, 800);
+
+    SimMifareClassic classic(SimMifareClassic::CLASSIC_1K, classicUid);
+    pcd.addPicc(&classic);
+    bool formatted = nfc.tagPresent() && nfc.format();
+    nfc.haltTag();
+    pcd.removePicc(&classic);
+    if(!formatted) {
+        Serial.println(F("  format (1K) failed"));
+    }
+    ok &= formatted && compare("1K", pcd, classic, nfc, 680);
+
+    Serial.println(F("\nFiltered reads, whole message -> up to the record"));
+    ok &= corpus("NTAG216", pcd, ntag216, nfc);
+    ok &= corpus("1K", pcd, classic, nfc);
+    ok &= hostile("record of 2147483632 bytes in 12", pcd, ntag216, nfc);
+
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+    return ok;
+}
@@ -0,0 +1,50 @@
+// Bus transactions per driver operation (PCD_Transaction batching).
+#include "bench.h"
+#include "MFRC522Sim.h"
+#include "SimMifareUltralight.h"
+
+static const byte uid[] = { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+
+bool bench_transactions()
+{
+    MFRC522Sim pcd;
+    SimMifareUltralight tag(SimMifareUltralight::NTAG213, uid);
+    pcd.addPicc(&tag);
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+    MFRC522 mfrc522(BENCH_PCD_BUS(pcd));
+
+    Serial.println(F("\nBus cost per operation"));
+
+    bench_begin();
+    mfrc522.PCD_Init();
+    bench_report("PCD_Init", bench_end());
+
+    bench_begin();
+    bool selected = bench_select(mfrc522);
+    bench_report("PICC_WakeupA + Select", bench_end());
+    if(!selected) {
+        Serial.println(F("  no card selected"));
+    }
+
+    byte buffer[18];
+    byte size = sizeof(buffer);
+    bench_begin();
+    MFRC522::StatusCode status = mfrc522.MIFARE_Read(4, buffer, &size);
+    bench_report("MIFARE_Read", bench_end());
+    if(status != MFRC522::STATUS_OK) {
+        Serial.print(F("  MIFARE_Read failed: "));
+        Serial.println(mfrc522.GetStatusCodeName(status));
+    }
+
+    byte crc[2];
+    bench_begin();
+    mfrc522.PCD_CalculateCRC(buffer, 2, crc);
+    bench_report("PCD_CalculateCRC", bench_end());
+
+    bench_begin();
+    mfrc522.PICC_HaltA();
+    bench_report("PICC_HaltA", bench_end());
+
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+    return selected && status == MFRC522::STATUS_OK;
+}
@@ -0,0 +1,166 @@
+// Ultralight/NTAG page writes: COMPATIBILITY WRITE (two frames, 16 bytes sent per 4 stored) vs WRITE.
+// Reads of a message filling the tag: READ, 4 pages per frame, vs FAST_READ after GET_VERSION.
+#include "bench.h"
+#include "NfcAdapter.h"
+#include "MFRC522Sim.h"
+#include "SimMifareUltralight.h"
+
+static const byte uid[] = { 0x04, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36 };
+static const byte FIRST_PAGE = 4;
+static const byte PAGES = 36;
+
+// A tag that only knows COMPATIBILITY WRITE, to exercise the fallback
+class CompatibilityOnlyTag : public SimMifareUltralight
+{
+    public:
+        CompatibilityOnlyTag(const byte * uid) : SimMifareUltralight(NTAG213, uid) {}
+    protected:
+        bool transceive(const byte * data, uint16_t length, SimFrame & response, uint32_t & delayNs)
+        {
+            if(data[0] == MFRC522::PICC_CMD_UL_WRITE) {
+                nak(response, 0x0);
+                return true;
+            }
+            return SimMifareUltralight::transceive(data, length, response, delayNs);
+        }
+};
+
+static bool report(const char * what, const BenchCost & cost, bool ok)
+{
+    bench_report(what, cost);
+    Serial.printf("    %.0f pages/s%s\n", PAGES * 1000000.0 / cost.us, ok ? "" : ", failed");
+    return ok;
+}
+
+static bool pages(MFRC522 & mfrc522)
+{
+    byte data[16] = { 0x11, 0x22, 0x33, 0x44 };
+    bool ok = bench_select(mfrc522);
+    bench_begin();
+    for(byte page = FIRST_PAGE; ok && page < FIRST_PAGE + PAGES; page++) {
+        ok = mfrc522.MIFARE_Write(page, data, sizeof(data)) == MFRC522::STATUS_OK;
+    }
+    bool reported = report("MIFARE_Write, 36 pages", bench_end(), ok);
+
+    bench_begin();
+    for(byte page = FIRST_PAGE; ok && page < FIRST_PAGE + PAGES; page++) {
+        ok = mfrc522.MIFARE_Ultralight_Write(page, data, 4) == MFRC522::STATUS_OK;
+    }
+    return report("MIFARE_Ultralight_Write, 36 pages", bench_end(), ok) && reported;
+}
+
+// The adapter's write of a message filling most of the tag
+static bool message(const char * what, MFRC522Sim & pcd, SimPicc & tag, NfcAdapter & nfc)
+{
+    NdefMessage message;
+    message.addTextRecord("A text record long enough to fill most of an NTAG213: 1234567890123456789012345678901234");
+    pcd.addPicc(&tag);
+    bench_begin();
+    bool ok = nfc.tagPresent() && nfc.write(message);
+    BenchCost cost = bench_end();
+    ok = ok && nfc.tagStillPresent() && nfc.read().getNdefMessage().getRecordCount() == 1;
+    bench_report(what, cost);
+    if(!ok) {
+        Serial.printf("  %s failed\n", what);
+    }
+    nfc.haltTag();
+    pcd.removePicc(&tag);
+    return ok;
+}
+
+// Fills the tag with one text record as long as MifareUltralight::write() takes, then reads it back
+static bool fill(const char * what, MFRC522Sim & pcd, SimMifareUltralight & tag, NfcAdapter & nfc, uint16_t capacity)
+{
+    // write() rounds the TLV up to 16 bytes and adds 2
+    uint16_t room = (capacity - 2) / 16 * 16;
+    char text[1024];
+    uint16_t length = room;
+    NdefMessage message;
+    do {
+        length--;
+        for(uint16_t i = 0; i < length; i++) {
+            text[i] = 'a' + i % 26;
+        }
+        text[length] = 0;
+        message = NdefMessage();
+        message.addTextRecord(text);
+    } while(message.getEncodedSize() + (message.getEncodedSize() < 0xFF ? 2 : 4) + 1 > room);
+    pcd.addPicc(&tag);
+    bool ok = nfc.tagPresent() && nfc.write(message) && nfc.tagStillPresent();
+    uint32_t frames = pcd.stats().framesSent;
+    bench_begin();
+    NfcTag read = nfc.read();
+    BenchCost cost = bench_end();
+    frames = pcd.stats().framesSent - frames;
+    ok = ok && read.hasNdefMessage() && read.getNdefMessage().getEncodedSize() == message.getEncodedSize();
+    bench_report(what, cost);
+    Serial.printf("    %u bytes, %u frames%s\n", message.getEncodedSize(), frames, ok ? "" : ", failed");
+    nfc.haltTag();
+    pcd.removePicc(&tag);
+    return ok;
+}
+
+// A TLV length the tag cannot hold, here 0xFFF0 bytes, must be rejected before anything is sized by it
+static bool hostile(const char * what, MFRC522Sim & pcd, SimMifareUltralight & tag, NfcAdapter & nfc)
+{
+    static const byte tlv[] = { 0x03, 0xFF, 0xFF, 0xF0 };
+    memcpy(tag.page(4), tlv, sizeof(tlv));
+    pcd.addPicc(&tag);
+    bool ok = nfc.tagPresent() && !nfc.read().hasNdefMessage();
+    Serial.printf("  %s: %s\n", what, ok ? "rejected" : "failed");
+    nfc.haltTag();
+    pcd.removePicc(&tag);
+    return ok;
+}
+
+// A message many times the capacity is refused, its image is not on the stack
+static bool oversized(const char * what, MFRC522Sim & pcd, SimMifareUltralight & tag, NfcAdapter & nfc)
+{
+    static char text[8192];
+    memset(text, 'x', sizeof(text) - 1);
+    NdefMessage message;
+    message.addTextRecord(text);
+    pcd.addPicc(&tag);
+    bool ok = nfc.tagPresent() && !nfc.write(message) && nfc.tagStillPresent() && !nfc.update(message);
+    Serial.printf("  %s: %s\n", what, ok ? "refused" : "failed");
+    nfc.haltTag();
+    pcd.removePicc(&tag);
+    return ok;
+}
+
+bool bench_ultralight()
+{
+    MFRC522Sim pcd;
+    SimMifareUltralight tag(SimMifareUltralight::NTAG213, uid);
+    pcd.connectIrq(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, &pcd);
+    MFRC522 mfrc522(BENCH_PCD_BUS(pcd), BENCH_PCD_IRQ_PIN);
+    mfrc522.PCD_Init();
+    mfrc522.PCD_SetCrcMode(MFRC522::PCD_CRC_FRAMED);
+    NfcAdapter nfc(&mfrc522);
+    nfc.begin(false);
+
+    Serial.println(F("\nUltralight page writes"));
+
+    pcd.addPicc(&tag);
+    bool ok = pages(mfrc522);
+    pcd.removePicc(&tag);
+
+    ok &= message("NfcAdapter write (WRITE)", pcd, tag, nfc);
+    CompatibilityOnlyTag old(uid);
+    ok &= message("NfcAdapter write (COMPATIBILITY)", pcd, old, nfc);
+
+    SimMifareUltralight ultralight(SimMifareUltralight::ULTRALIGHT, uid);
+    ok &= fill("read full Ultralight", pcd, ultralight, nfc, 48);
+    ok &= fill("read full NTAG213", pcd, tag, nfc, 144);
+    SimMifareUltralight ntag215(SimMifareUltralight::NTAG215, uid);
+    ok &= fill("read full NTAG215", pcd, ntag215, nfc, 496);
+    SimMifareUltralight ntag216(SimMifareUltralight::NTAG216, uid);
+    ok &= fill("read full NTAG216", pcd, ntag216, nfc, 872);
+    ok &= hostile("NTAG216 with a 65520 byte TLV", pcd, ntag216, nfc);
+    ok &= oversized("8 KB message on an NTAG213", pcd, tag, nfc);
+
+    detachInterrupt(BENCH_PCD_IRQ_PIN);
+    Wire.attach(BENCH_PCD_ADDRESS, NULL);
+    return ok;
+}
@@ -6,11 +6,14 @@
 #include <M5Unified.h>
 #include "MFRC522_I2C.h"
 #include "NfcAdapter.h"
+#include "NfcTagMonitor.h"
 
 MFRC522 mfrc522(0x28); // Create MFRC522 instance
 char str[256];
 
 NfcAdapter nfc = NfcAdapter(&mfrc522);
+NfcTagMonitor monitor = NfcTagMonitor(&nfc);
+void onTag(const NfcTagEvent & event, void * context);
 
 MFRC522::MIFARE_Key knownKeys[] = {
     {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}, // chinese clone default key
@@ -41,11 +44,23 @@ void setup()
     nfc.begin();
     // use a custom Mifare Classic key:
     // nfc.begin(knownKeys[0], true);
+    monitor.subscribe(onTag);
+    monitor.begin();
 }
 
 void loop()
 {
-    if(nfc.tagPresent()) {
+    // Tags are handled by onTag() in the monitor's task
+    delay(1000);
+}
+
+// Called in the monitor's task, which owns nfc
+void onTag(const NfcTagEvent & event, void * context)
+{
+    if(event.type == NfcTagEvent::DEPARTED) {
+        Serial.printf("Tag removed after %u ms\n", (unsigned)event.presentMs);
+    }
+    if(event.type == NfcTagEvent::ARRIVED) {
         // Show Nfc Tag type
         byte piccType = mfrc522.PICC_GetType((&mfrc522.uid)->sak);
         Serial.print("PICC type: ");
@@ -60,7 +75,7 @@ void loop()
 
         if(tag.hasNdefMessage()) { // every tag won't have a message
 
-            NdefMessage message = tag.getNdefMessage();
+            const NdefMessage & message = tag.message();
             Serial.print("\nThis NFC Tag contains an NDEF Message with ");
             Serial.print(message.getRecordCount());
             Serial.print(" NDEF Record");
@@ -70,11 +85,10 @@ void loop()
             Serial.println(".");
 
             // cycle through the records, printing some info from each
-            int recordCount = message.getRecordCount();
-            for(int i = 0; i < recordCount; i++) {
-                Serial.printf("\nNDEF Record %d ", i + 1);
-                NdefRecord record = message.getRecord(i);
-                // NdefRecord record = message[i]; // alternate syntax
+            int i = 0;
+            for(const NdefRecord & record : message) {
+                Serial.printf("\nNDEF Record %d ", ++i);
+                // const NdefRecord & record = message.record(i - 1); // alternate syntax
 
                 Serial.print("  TNF: ");
                 Serial.print(record.getTnf());
@@ -112,5 +126,4 @@ void loop()
             }
         }
     }
-    delay(1000);
 }
@@ -8,8 +8,8 @@
  * Released into the public domain.
  * ----------------------------------------------------------------------------
  * Example sketch/program which will try the most used default keys listed in
- * https://code.google.com/p/mfcuk/wiki/MifareClassicDefaultKeys to dump the
- * block 0 of a MIFARE RFID card using a RFID-RC522 reader.
+ * https://code.google.com/p/mfcuk/wiki/MifareClassicDefaultKeys on every sector of a MIFARE Classic, key A and
+ * key B, and print the keys found using a RFID-RC522 reader.
  *
  * Typical pin layout used:
  * -----------------------------------------------------------------------------------------
@@ -27,13 +27,14 @@
 
 #include <M5Unified.h>
 #include "MFRC522_I2C.h"
+#include "MifareKeySearch.h"
 
 MFRC522 mfrc522(0x28); // Create MFRC522 instance
 
-// Number of known default keys (hard-coded)
-// NOTE: Synchronize the NR_KNOWN_KEYS define with the defaultKeys[] array
-#define NR_KNOWN_KEYS   16
-byte knownKeys[NR_KNOWN_KEYS][MFRC522::MF_KEY_SIZE] =  {
+MifareKeySearch keySearch(&mfrc522);
+
+// Known default keys, in flash: the search reads them one by one, so the list can grow well beyond RAM
+const byte knownKeys[][MFRC522::MF_KEY_SIZE] PROGMEM =  {
     {0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5}, // A0 A1 A2 A3 A4 A5
     {0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5}, // B0 B1 B2 B3 B4 B5
     {0x4d, 0x3a, 0x99, 0xc3, 0x51, 0xdd}, // 4D 3A 99 C3 51 DD
@@ -41,7 +42,6 @@ byte knownKeys[NR_KNOWN_KEYS][MFRC522::MF_KEY_SIZE] =  {
     {0xd3, 0xf7, 0xd3, 0xf7, 0xd3, 0xf7}, // D3 F7 D3 F7 D3 F7
     {0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff}, // AA BB CC DD EE FF
     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // 00 00 00 00 00 00
-    {0xd3, 0xf7, 0xd3, 0xf7, 0xd3, 0xf7}, // d3 f7 d3 f7 d3 f7
     {0xa0, 0xb0, 0xc0, 0xd0, 0xe0, 0xf0}, // a0 b0 c0 d0 e0 f0
     {0xa1, 0xb1, 0xc1, 0xd1, 0xe1, 0xf1}, // a1 b1 c1 d1 e1 f1
     {0x71, 0x4c, 0x5c, 0x88, 0x6e, 0x97}, // 71 4c 5c 88 6e 97
@@ -53,10 +53,6 @@ byte knownKeys[NR_KNOWN_KEYS][MFRC522::MF_KEY_SIZE] =  {
 
 };
 
-byte uidByte_prev[10] ;
-
-int keyCounter = 0;
-
 /*
  * Initialize.
  */
@@ -76,7 +72,7 @@ void setup()
     mfrc522.PCD_Init();         // Init MFRC522 card
     // mfrc522.PICC_DumpToSerial();  // Show details of PCD - MFRC522 Card Reader details
 
-    Serial.println(F("Try the most used default keys to print block 0 of a MIFARE Classic 1k."));
+    Serial.println(F("Try the most used default keys on every sector of a MIFARE Classic."));
 }
 
 /*
@@ -90,60 +86,6 @@ void dump_byte_array(const byte * buffer, const byte bufferSize)
     }
 }
 
-/*
- * Try using the PICC (the tag/card) with the given key to access block 0.
- * On success, it will show the key details, and dump the block data on Serial.
- *
- * @return true when the given key worked, false otherwise.
- */
-boolean try_key(const MFRC522::MIFARE_Key & key)
-{
-    boolean result = false;
-    byte buffer[18];
-    byte block = 0;
-    MFRC522::StatusCode status;
-
-    //    for (byte j = 0; j < 63; j++) {
-    Serial.print(F("  ->  Authenticating using key A...  "));
-    status = mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, block, key, mfrc522.uid);
-    if(status != MFRC522::STATUS_OK) {
-        Serial.print(F("PCD_Authenticate() failed: "));
-        Serial.println(mfrc522.GetStatusCodeName(status));
-        return false;
-    }
-
-    // Read block
-    byte byteCount = sizeof(buffer);
-    status = mfrc522.MIFARE_Read(block, buffer, &byteCount);
-    if(status != MFRC522::STATUS_OK) {
-        Serial.print(F("MIFARE_Read() failed: "));
-        Serial.println(mfrc522.GetStatusCodeName(status));
-    }
-    else {
-        // Successful read
-        result = true;
-        Serial.print(F("Success with key:"));
-        dump_byte_array(&key.keyByte[0], MFRC522::MF_KEY_SIZE);
-        Serial.println();
-
-        // Dump block data
-        Serial.print(F("Block "));
-        Serial.print(block);
-        Serial.print(F(":"));
-        dump_byte_array(buffer, 16);
-        Serial.println();
-    }
-    Serial.println();
-
-    //      j++;
-
-    //    }
-
-    mfrc522.PICC_HaltA();       // Halt PICC
-    mfrc522.PCD_StopCrypto1();  // Stop encryption on PCD
-    return result;
-}
-
 /*
  * Main loop.
  */
@@ -158,46 +100,40 @@ void loop()
     if(! mfrc522.PICC_ReadCardSerial())
         return;
 
-    // Print card info just if new!
-    if(uidByte_prev[0] != mfrc522.uid.uidByte[0])  {
-        keyCounter = 0;
-
-        uidByte_prev[0] = mfrc522.uid.uidByte[0];
-
-        //mfrc522.PICC_DumpToSerial(&(mfrc522.uid));
-        Serial.print(F("\n\nCard UID:"));
-        dump_byte_array(mfrc522.uid.uidByte, mfrc522.uid.size);
-
-        Serial.println();
-
-        Serial.print(F("PICC type: "));
-        MFRC522::PICC_Type piccType = (MFRC522::PICC_Type) mfrc522.PICC_GetType(mfrc522.uid.sak);
-        Serial.println(mfrc522.PICC_GetTypeName(piccType));
-        Serial.println("\n\n");
-    }
-
-    // Try the known default keys
-    MFRC522::MIFARE_Key key;
-
-    byte k = keyCounter;
-    // Copy the known key into the MIFARE_Key structure
-    for(byte i = 0; i < MFRC522::MF_KEY_SIZE; i++) {
-        key.keyByte[i] = knownKeys[k][i];
-    }
+    Serial.print(F("\n\nCard UID:"));
+    dump_byte_array(mfrc522.uid.uidByte, mfrc522.uid.size);
+    Serial.println();
 
-    Serial.print("Trying key: ");
-    dump_byte_array((key).keyByte, MFRC522::MF_KEY_SIZE);
+    Serial.print(F("PICC type: "));
+    MFRC522::PICC_Type piccType = (MFRC522::PICC_Type) mfrc522.PICC_GetType(mfrc522.uid.sak);
+    Serial.println(mfrc522.PICC_GetTypeName(piccType));
 
-    // Try the key
-    if(try_key(key)) {
-        // Found and reported on the key and block,
-        // no need to try other keys for this PICC
-        Serial.println("key found!!");
+    // Try the known default keys on all sectors
+    MifareKeyTable keys(knownKeys, sizeof(knownKeys) / sizeof(knownKeys[0]));
+    if(!keySearch.search(keys)) {
+        Serial.println(F("Not a MIFARE Classic, or it left the field"));
+        return;
     }
-    else {
-        delay(1000);                  // 1s
-        keyCounter++;
-        //Serial.println(keyCounter);
+    for(byte sector = 0; sector < keySearch.sectors(); sector++) {
+        const MifareSectorKeys & found = keySearch.sector(sector);
+        Serial.printf("Sector %2u  key A:", sector);
+        if(found.hasKeyA) {
+            dump_byte_array(found.keyA.keyByte, MFRC522::MF_KEY_SIZE);
+        }
+        else {
+            Serial.print(F(" unknown          "));
+        }
+        Serial.print(F("  key B:"));
+        if(found.hasKeyB) {
+            dump_byte_array(found.keyB.keyByte, MFRC522::MF_KEY_SIZE);
+        }
+        else {
+            Serial.print(F(" unknown"));
+        }
+        Serial.println();
     }
+    Serial.printf("%u keys tried in %u ms, %u keys/s\n", keySearch.tried, keySearch.elapsedUs / 1000,
+                  keySearch.keysPerSecond());
 
+    mfrc522.PICC_HaltA();       // Halt PICC, it is found again once it left the field
 }